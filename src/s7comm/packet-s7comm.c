@@ -24,11 +24,27 @@
 
 #include "config.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 #include <glib.h>
 #include <epan/packet.h>
+#include <epan/prefs.h>
+#include <epan/conversation.h>
+#include <epan/tap.h>
+#include <epan/crc32-tvb.h>
+#include <epan/to_str.h>
+#include <wsutil/pint.h>
 
 #include "packet-s7comm.h"
 #include "packet-s7comm_szl_ids.h"
+#include "packet-s7comm_dblayout.h"
+#include "packet-s7comm_symbols.h"
+#include "packet-s7comm_nck.h"
+#include "packet-s7comm_shadow.h"
+#include "packet-s7comm_alarmcache.h"
+#include "packet-s7comm_pbc.h"
+#include "packet-s7comm_audit.h"
 
 #define PROTO_TAG_S7COMM                    "S7COMM"
 
@@ -41,6 +57,20 @@
 /* Wireshark ID of the S7COMM protocol */
 static int proto_s7comm = -1;
 
+/* Tap of the alarm indications */
+static int s7comm_alarm_tap = -1;
+/* Tap of the block list and block info responses */
+static int s7comm_block_tap = -1;
+/* Tap of the state changing operations */
+static int s7comm_audit_tap = -1;
+/* Tap of block uploads and downloads */
+static int s7comm_transfer_tap = -1;
+
+/* Preferences */
+static const gchar *s7comm_dblayout_filename = "";
+static const gchar *s7comm_symbols_filename = "";
+static const gchar *s7comm_nck_catalog_filename = "";
+
 /* Forward declarations */
 void proto_reg_handoff_s7comm(void);
 void proto_register_s7comm (void);
@@ -62,7 +92,7 @@ dissect_s7comm()
     +        +        +
     +     response  request
     +        +        +
-    +        +        +------ s7comm_decode_param_item()
+    +        +        +------ s7comm_decode_param_item_list()
     +        +        +       s7comm_decode_response_read_data()
     +        +        +
     +        +        +------ s7comm_decode_pdu_setup_communication()
@@ -85,7 +115,7 @@ dissect_s7comm()
              +
              +------ s7comm_decode_ud_cyclic_subfunc()
              +                  +
-             +                  +------- s7comm_decode_param_item()
+             +                  +------- s7comm_decode_param_item_list()
              +                  +------- s7comm_decode_response_read_data()
              +
              +------ s7comm_decode_ud_block_subfunc()
@@ -223,25 +253,8 @@ static const value_string param_functionnames[] = {
     { 0,                                    NULL }
 };
 /**************************************************************************
- * Area names
+ * Area names, the area defines are in packet-s7comm.h
  */
-#define S7COMM_AREA_SYSINFO                 0x03        /* System info of 200 family */
-#define S7COMM_AREA_SYSFLAGS                0x05        /* System flags of 200 family */
-#define S7COMM_AREA_ANAIN                   0x06        /* analog inputs of 200 family */
-#define S7COMM_AREA_ANAOUT                  0x07        /* analog outputs of 200 family */
-#define S7COMM_AREA_P                       0x80        /* direct peripheral access */
-#define S7COMM_AREA_INPUTS                  0x81
-#define S7COMM_AREA_OUTPUTS                 0x82
-#define S7COMM_AREA_FLAGS                   0x83
-#define S7COMM_AREA_DB                      0x84        /* data blocks */
-#define S7COMM_AREA_DI                      0x85        /* instance data blocks */
-#define S7COMM_AREA_LOCAL                   0x86        /* local data (should not be accessible over network) */
-#define S7COMM_AREA_V                       0x87        /* previous (Vorgaenger) local data (should not be accessible over network)  */
-#define S7COMM_AREA_COUNTER                 28          /* S7 counters */
-#define S7COMM_AREA_TIMER                   29          /* S7 timers */
-#define S7COMM_AREA_COUNTER200              30          /* IEC counters (200 family) */
-#define S7COMM_AREA_TIMER200                31          /* IEC timers (200 family) */
-
 static const value_string item_areanames[] = {
     { S7COMM_AREA_SYSINFO,                  "System info of 200 family" },
     { S7COMM_AREA_SYSFLAGS,                 "System flags of 200 family" },
@@ -332,6 +345,56 @@ static const value_string item_syntaxid_names[] = {
     { 0,                                    NULL }
 };
 
+/**************************************************************************
+ * Item with syntax-id S7ANY: type 0x12, length 10, syntax-id 0x10 + 9 bytes address
+ */
+#define S7COMM_S7ANY_ITEM_LENGTH            12
+
+typedef struct {
+    guint8 t_size;                          /* Transport size */
+    guint16 len;                            /* Number of elements */
+    guint16 db;                             /* DB number */
+    guint8 area;                            /* Memory area */
+    guint32 address;                        /* Bit address, or number of timer/counter */
+    guint8 syntax_id;
+    /* Address of an item with syntax-id NCK */
+    guint8 nck_areaunit;
+    guint8 nck_module;
+    guint8 nck_linecount;
+    guint16 nck_column;
+    guint16 nck_line;
+} s7comm_s7any_item_t;
+
+/* Maximum length of an address string like "DB65535.DBX 2097151.7 UNKNOWN 65535" */
+#define S7COMM_ITEM_ADDRESS_STRLEN          64
+/* Maximum length of the symbolic name of a S7-1200 symbolic address */
+#define S7COMM_ITEM_SYMBOL_STRLEN           256
+/* Maximum number of LIDs of a S7-1200 symbolic address, limited by the 1 byte item length */
+#define S7COMM_TIA1200_MAX_LIDS             64
+
+/**************************************************************************
+ * Addresses of the items of a read/write job or of a cyclic data request.
+ * Needed to decode the data of the response, which only contains the values.
+ * The area of an item is 0 when it has no S7ANY address.
+ */
+typedef struct {
+    guint8 item_count;
+    s7comm_s7any_item_t *items;
+} s7comm_job_items_t;
+
+/* Kinds of jobs. Read/write jobs are found by PDU reference, of the others the last request is used. */
+#define S7COMM_JOB_READWRITE                0
+#define S7COMM_JOB_CYCLIC                   1
+#define S7COMM_JOB_VARTAB                   2
+
+/* Open jobs of a connection, only used on the first pass */
+typedef struct {
+    wmem_tree_t *jobs;                      /* key: PDU reference */
+    s7comm_job_items_t *cyclic_job;         /* last request of cyclic data */
+    s7comm_job_items_t *vartab_job;         /* last request of a variable table */
+    guint8 listtype_block_type;             /* block type of the last request to list blocks of a type */
+} s7comm_conv_data_t;
+
 /**************************************************************************
  * Transport sizes in data
  */
@@ -369,16 +432,8 @@ const value_string s7comm_item_return_valuenames[] = {
     { 0,                                        NULL }
 };
 /**************************************************************************
- * Block Types
+ * Block Types, the defines are in packet-s7comm.h
  */
-#define S7COMM_BLOCKTYPE_OB                 '8'
-#define S7COMM_BLOCKTYPE_DB                 'A'
-#define S7COMM_BLOCKTYPE_SDB                'B'
-#define S7COMM_BLOCKTYPE_FC                 'C'
-#define S7COMM_BLOCKTYPE_SFC                'D'
-#define S7COMM_BLOCKTYPE_FB                 'E'
-#define S7COMM_BLOCKTYPE_SFB                'F'
-
 static const value_string blocktype_names[] = {
     { S7COMM_BLOCKTYPE_OB,                  "OB" },
     { S7COMM_BLOCKTYPE_DB,                  "DB" },
@@ -587,10 +642,6 @@ static const value_string userdata_cyclic_subfunc_names[] = {
 /**************************************************************************
  * Names of userdata subfunctions in group 3 (Block functions)
  */
-#define S7COMM_UD_SUBF_BLOCK_LIST           0x01
-#define S7COMM_UD_SUBF_BLOCK_LISTTYPE       0x02
-#define S7COMM_UD_SUBF_BLOCK_BLOCKINFO      0x03
-
 static const value_string userdata_block_subfunc_names[] = {
     { S7COMM_UD_SUBF_BLOCK_LIST,            "List blocks" },
     { S7COMM_UD_SUBF_BLOCK_LISTTYPE,        "List blocks of type" },
@@ -661,15 +712,8 @@ static const value_string weekdaynames[] = {
  **************************************************************************/
 
 /**************************************************************************
- * Flags for LID access
+ * Flags for LID access, the flag defines are in packet-s7comm.h
  */
-#define S7COMM_TIA1200_VAR_ENCAPS_LID       0x2
-#define S7COMM_TIA1200_VAR_ENCAPS_IDX       0x3
-#define S7COMM_TIA1200_VAR_OBTAIN_LID       0x4
-#define S7COMM_TIA1200_VAR_OBTAIN_IDX       0x5
-#define S7COMM_TIA1200_VAR_PART_START       0x6
-#define S7COMM_TIA1200_VAR_PART_LEN         0x7
-
 static const value_string tia1200_var_lid_flag_names[] = {
     { S7COMM_TIA1200_VAR_ENCAPS_LID,        "Encapsulated LID" },
     { S7COMM_TIA1200_VAR_ENCAPS_IDX,        "Encapsulated Index" },
@@ -880,6 +924,8 @@ static gint hf_s7comm_item_address = -1;                    /* Bit address, 3 By
 static gint hf_s7comm_item_address_byte = -1;               /* address: Byte address */
 static gint hf_s7comm_item_address_bit = -1;                /* address: Bit address */
 static gint hf_s7comm_item_address_nr = -1;                 /* address: Timer/Counter/block number */
+static gint hf_s7comm_item_address_str = -1;                /* Full address as string, e.g. DB10.DBX 4.0 BYTE 2 */
+static gint hf_s7comm_item_symbol = -1;                     /* Symbol of the address from the symbol table */
 /* Special variable read with Syntax-Id 0xb0 (DBREAD) */
 static gint hf_s7comm_item_dbread_numareas = -1;            /* Number of areas following, 1 Byte*/
 static gint hf_s7comm_item_dbread_length = -1;              /* length, 1 Byte*/
@@ -1187,12 +1233,13 @@ s7comm_guint8_from_bcd(guint8 i)
  * Add a BCD coded timestamp (10 /8 Bytes length) to tree
  *
  *******************************************************************************************************/
-static guint32
+guint32
 s7comm_add_timestamp_to_tree(tvbuff_t *tvb,
                              proto_tree *tree,
                              guint32 offset,
                              gboolean append_text,
-                             gboolean has_ten_bytes)          /* if this is false the [0] reserved and [1] year bytes are missing */
+                             gboolean has_ten_bytes,          /* if this is false the [0] reserved and [1] year bytes are missing */
+                             nstime_t *ts)                    /* returns the time, may be NULL */
 {
     guint8 timestamp[10];
     guint8 i;
@@ -1241,6 +1288,9 @@ s7comm_add_timestamp_to_tree(tvbuff_t *tvb,
     mt.tm_isdst = -1;
     tv.secs = mktime(&mt);
     tv.nsecs = msec * 1000000;
+    if (ts != NULL) {
+        *ts = tv;
+    }
     item = proto_tree_add_time_format(tree, hf_s7comm_data_ts, tvb, offset, timestamp_size, &tv,
         "S7 Timestamp: %s %2d, %d %02d:%02d:%02d.%03d", mon_names[mt.tm_mon], mt.tm_mday,
         mt.tm_year + 1900, mt.tm_hour, mt.tm_min, mt.tm_sec,
@@ -1298,6 +1348,205 @@ make_registerflag_string(gchar *str, guint8 flags, gint max)
         str[strlen(str) - 2 ] = '\0';
 }
 
+/*******************************************************************************************************
+ *
+ * Build the full address of an item with syntax-id S7ANY, like DB10.DBX 4.0 BYTE 2
+ *
+ *******************************************************************************************************/
+static void
+s7comm_get_s7any_address_string(const s7comm_s7any_item_t *s7any,
+                                gchar *str,
+                                gsize max)
+{
+    const gchar *area_prefix;
+
+    switch (s7any->area) {
+        case (S7COMM_AREA_TIMER):
+            g_snprintf(str, (gulong) max, "T %d", s7any->address);
+            return;
+        case (S7COMM_AREA_COUNTER):
+            g_snprintf(str, (gulong) max, "C %d", s7any->address);
+            return;
+        case (S7COMM_AREA_DB):
+            g_snprintf(str, (gulong) max, "DB%d.DBX %d.%d %s %d", s7any->db,
+                s7any->address / 8, s7any->address % 8,
+                val_to_str(s7any->t_size, item_transportsizenames, "Unknown transport size: 0x%02x"), s7any->len);
+            return;
+        case (S7COMM_AREA_DI):
+            g_snprintf(str, (gulong) max, "DI%d.DIX %d.%d %s %d", s7any->db,
+                s7any->address / 8, s7any->address % 8,
+                val_to_str(s7any->t_size, item_transportsizenames, "Unknown transport size: 0x%02x"), s7any->len);
+            return;
+        case (S7COMM_AREA_P):
+            area_prefix = "P";
+            break;
+        case (S7COMM_AREA_INPUTS):
+            area_prefix = "I";
+            break;
+        case (S7COMM_AREA_OUTPUTS):
+            area_prefix = "Q";
+            break;
+        case (S7COMM_AREA_FLAGS):
+            area_prefix = "M";
+            break;
+        case (S7COMM_AREA_LOCAL):
+            area_prefix = "L";
+            break;
+        default:
+            area_prefix = "unknown area";
+            break;
+    }
+    g_snprintf(str, (gulong) max, "%s %d.%d %s %d", area_prefix,
+        s7any->address / 8, s7any->address % 8,
+        val_to_str(s7any->t_size, item_transportsizenames, "Unknown transport size: 0x%02x"), s7any->len);
+}
+
+/*******************************************************************************************************
+ *
+ * Size of the area accessed by an item with syntax-id S7ANY in bits, for timers and counters
+ * the number of timers/counters.
+ *
+ *******************************************************************************************************/
+static guint32
+s7comm_get_s7any_bitlen(const s7comm_s7any_item_t *s7any)
+{
+    switch (s7any->t_size) {
+        case S7COMM_TRANSPORT_SIZE_BIT:
+        case S7COMM_TRANSPORT_SIZE_TIMER:
+        case S7COMM_TRANSPORT_SIZE_COUNTER:
+        case S7COMM_TRANSPORT_SIZE_IEC_TIMER:
+        case S7COMM_TRANSPORT_SIZE_IEC_COUNTER:
+        case S7COMM_TRANSPORT_SIZE_HS_COUNTER:
+            return s7any->len;
+        case S7COMM_TRANSPORT_SIZE_WORD:
+        case S7COMM_TRANSPORT_SIZE_INT:
+        case S7COMM_TRANSPORT_SIZE_DATE:
+        case S7COMM_TRANSPORT_SIZE_S5TIME:
+            return 16 * s7any->len;
+        case S7COMM_TRANSPORT_SIZE_DWORD:
+        case S7COMM_TRANSPORT_SIZE_DINT:
+        case S7COMM_TRANSPORT_SIZE_REAL:
+        case S7COMM_TRANSPORT_SIZE_TOD:
+        case S7COMM_TRANSPORT_SIZE_TIME:
+            return 32 * s7any->len;
+        case S7COMM_TRANSPORT_SIZE_DT:
+            return 64 * s7any->len;
+        default:
+            return 8 * s7any->len;
+    }
+}
+
+/*******************************************************************************************************
+ *
+ * Look up the symbol of an address in the symbol table. If there is one, it's added
+ * as generated field and shown beside the item.
+ *
+ *******************************************************************************************************/
+static void
+s7comm_add_symbol_to_tree(tvbuff_t *tvb,
+                          guint32 offset,
+                          gint length,
+                          proto_tree *item_tree,
+                          guint8 area,
+                          guint16 db,
+                          guint32 start,
+                          guint32 size)
+{
+    proto_item *symbol_item = NULL;
+    const gchar *symbol;
+
+    symbol = s7comm_get_symbol(area, db, start, size);
+    if (symbol != NULL) {
+        proto_item_append_text(item_tree, " \"%s\"", symbol);
+        symbol_item = proto_tree_add_string(item_tree, hf_s7comm_item_symbol, tvb, offset, length, symbol);
+        PROTO_ITEM_SET_GENERATED(symbol_item);
+    }
+}
+
+/*******************************************************************************************************
+ *
+ * Add the 9 address bytes of an item with syntax-id S7ANY to the item tree.
+ * The values are already decoded into s7any, offset points to the transport size.
+ *
+ *******************************************************************************************************/
+static guint32
+s7comm_add_s7any_address_to_tree(tvbuff_t *tvb,
+                                 guint32 offset,
+                                 proto_tree *item_tree,
+                                 const s7comm_s7any_item_t *s7any)
+{
+    proto_item *address_item = NULL;
+    proto_tree *address_item_tree = NULL;
+    gchar str[S7COMM_ITEM_ADDRESS_STRLEN];
+
+    /* Transport size, 1 byte */
+    proto_tree_add_uint(item_tree, hf_s7comm_item_transport_size, tvb, offset, 1, s7any->t_size);
+    offset += 1;
+    /* Length, 2 bytes */
+    proto_tree_add_uint(item_tree, hf_s7comm_item_length, tvb, offset, 2, s7any->len);
+    offset += 2;
+    /* DB number, 2 bytes */
+    proto_tree_add_uint(item_tree, hf_s7comm_item_db, tvb, offset, 2, s7any->db);
+    offset += 2;
+    /* Area, 1 byte */
+    proto_tree_add_uint(item_tree, hf_s7comm_item_area, tvb, offset, 1, s7any->area);
+    offset += 1;
+    /* Address, 3 bytes */
+    address_item = proto_tree_add_uint(item_tree, hf_s7comm_item_address, tvb, offset, 3, s7any->address);
+    address_item_tree = proto_item_add_subtree(address_item, ett_s7comm_item_address);
+    if (s7any->area == S7COMM_AREA_TIMER || s7any->area == S7COMM_AREA_COUNTER) {
+        proto_tree_add_uint(address_item_tree, hf_s7comm_item_address_nr, tvb, offset, 3, s7any->address);
+    } else {
+        proto_tree_add_uint(address_item_tree, hf_s7comm_item_address_byte, tvb, offset, 3, s7any->address);
+        proto_tree_add_uint(address_item_tree, hf_s7comm_item_address_bit, tvb, offset, 3, s7any->address);
+    }
+    /* build a full address to show item data directly beside the item */
+    s7comm_get_s7any_address_string(s7any, str, sizeof(str));
+    proto_item_append_text(item_tree, " (%s)", str);
+    address_item = proto_tree_add_string(item_tree, hf_s7comm_item_address_str, tvb, offset - 6, 9, str);
+    PROTO_ITEM_SET_GENERATED(address_item);
+    s7comm_add_symbol_to_tree(tvb, offset - 6, 9, item_tree, s7any->area, s7any->db,
+        s7any->address, s7comm_get_s7any_bitlen(s7any));
+    offset += 3;
+    return offset;
+}
+
+/*******************************************************************************************************
+ *
+ * Try to decode a complete item list in one pass, if all items are using syntax-id S7ANY.
+ * Almost all requests from HMIs and SCADA systems are build this way. Every item has then a fixed
+ * length of 12 bytes without fill-bytes, so the length of the whole list is checked only once
+ * and the items are read from a flat buffer.
+ * Returns FALSE if the list is incomplete or contains other syntax-ids, then nothing was decoded.
+ *
+ *******************************************************************************************************/
+static gboolean
+s7comm_get_s7any_item_list(tvbuff_t *tvb,
+                           guint32 offset,
+                           guint8 item_count,
+                           s7comm_s7any_item_t *items)
+{
+    const guint8 *p;
+    guint8 i;
+
+    if (item_count == 0 || !tvb_bytes_exist(tvb, offset, item_count * S7COMM_S7ANY_ITEM_LENGTH)) {
+        return FALSE;
+    }
+    p = tvb_get_ptr(tvb, offset, item_count * S7COMM_S7ANY_ITEM_LENGTH);
+    for (i = 0; i < item_count; i++, p += S7COMM_S7ANY_ITEM_LENGTH) {
+        if (p[0] != 0x12 || p[1] != 10 || p[2] != S7COMM_SYNTAXID_S7ANY) {
+            return FALSE;
+        }
+        items[i].t_size = p[3];
+        items[i].len = pntoh16(&p[4]);
+        items[i].db = pntoh16(&p[6]);
+        items[i].area = p[8];
+        items[i].address = pntoh24(&p[9]);
+        items[i].syntax_id = S7COMM_SYNTAXID_S7ANY;
+    }
+    return TRUE;
+}
+
 /*******************************************************************************************************
  *
  * Dissect the parameter details of a read/write request (Items)
@@ -1307,12 +1556,10 @@ static guint32
 s7comm_decode_param_item(tvbuff_t *tvb,
                           guint32 offset,
                           proto_tree *sub_tree,
-                          guint8 item_no)
+                          guint8 item_no,
+                          s7comm_s7any_item_t *s7any)
 {
-    guint32 a_address = 0;
     guint32 bytepos = 0;
-    guint32 bitpos = 0;
-    guint8 t_size = 0;
     guint16 len = 0;
     guint16 db = 0;
     guint16 i;
@@ -1320,8 +1567,6 @@ s7comm_decode_param_item(tvbuff_t *tvb,
     proto_item *item = NULL;
     proto_tree *item_tree = NULL;
     proto_tree *sub_item_tree = NULL;
-    proto_item *address_item = NULL;
-    proto_tree *address_item_tree = NULL;
     guint8 number_of_areas = 0;
 
     guint8 var_spec_type = 0;
@@ -1332,17 +1577,25 @@ s7comm_decode_param_item(tvbuff_t *tvb,
     guint16 tia_var_area2 = 0;
     guint8 tia_lid_flags = 0;
     guint32 tia_value = 0;
+    guint32 tia_crc = 0;
+    guint32 tia_offset = 0;
+    guint8 tia_flags_list[S7COMM_TIA1200_MAX_LIDS];
+    guint32 tia_value_list[S7COMM_TIA1200_MAX_LIDS];
+    gchar symbol[S7COMM_ITEM_SYMBOL_STRLEN];
 
     guint8 nck_area = 0;
     guint8 nck_unit = 0;
     guint16 nck_column = 0;
     guint16 nck_line = 0;
     guint8 nck_module = 0;
+    const gchar *nck_name;
 
     /* At first check type and length of variable specification */
     var_spec_type = tvb_get_guint8(tvb, offset);
     var_spec_length = tvb_get_guint8(tvb, offset + 1);
     var_spec_syntax_id = tvb_get_guint8(tvb, offset + 2);
+    memset(s7any, 0, sizeof(s7comm_s7any_item_t));
+    s7any->syntax_id = var_spec_syntax_id;
 
     /* Classic S7:  type = 0x12, len=10, syntax-id=0x10 for ANY-Pointer
      * TIA S7-1200: type = 0x12, len=14, syntax-id=0xb2 (symbolic addressing??)
@@ -1366,71 +1619,12 @@ s7comm_decode_param_item(tvbuff_t *tvb,
     /****************************************************************************/
     /************************** Step 7 Classic 300 400 **************************/
     if (var_spec_type == 0x12 && var_spec_length == 10 && var_spec_syntax_id == S7COMM_SYNTAXID_S7ANY) {
-        /* Transport size, 1 byte */
-        t_size = tvb_get_guint8(tvb, offset);
-        proto_tree_add_uint(item_tree, hf_s7comm_item_transport_size, tvb, offset, 1, t_size);
-        offset += 1;
-        /* Length, 2 bytes */
-        len = tvb_get_ntohs(tvb, offset);
-        proto_tree_add_uint(item_tree, hf_s7comm_item_length, tvb, offset, 2, len);
-        offset += 2;
-        /* DB number, 2 bytes */
-        db = tvb_get_ntohs(tvb, offset);
-        proto_tree_add_uint(item_tree, hf_s7comm_item_db, tvb, offset, 2, db);
-        offset += 2;
-        /* Area, 1 byte */
-        area = tvb_get_guint8(tvb, offset);
-        proto_tree_add_uint(item_tree, hf_s7comm_item_area, tvb, offset, 1, area);
-        offset += 1;
-        /* Address, 3 bytes */
-        a_address = tvb_get_ntoh24(tvb, offset);
-        address_item = proto_tree_add_uint(item_tree, hf_s7comm_item_address, tvb, offset, 3, a_address);
-        address_item_tree = proto_item_add_subtree(address_item, ett_s7comm_item_address);
-        bytepos = a_address / 8;
-        bitpos = a_address % 8;
-        /* build a full address to show item data directly beside the item */
-        switch (area) {
-            case (S7COMM_AREA_P):
-                proto_item_append_text(item_tree, " (P");
-                break;
-            case (S7COMM_AREA_INPUTS):
-                proto_item_append_text(item_tree, " (I");
-                break;
-            case (S7COMM_AREA_OUTPUTS):
-                proto_item_append_text(item_tree, " (Q");
-                break;
-            case (S7COMM_AREA_FLAGS):
-                proto_item_append_text(item_tree, " (M");
-                break;
-            case (S7COMM_AREA_DB):
-                proto_item_append_text(item_tree, " (DB%d.DBX", db);
-                break;
-            case (S7COMM_AREA_DI):
-                proto_item_append_text(item_tree, " (DI%d.DIX", db);
-                break;
-            case (S7COMM_AREA_LOCAL):
-                proto_item_append_text(item_tree, " (L");
-                break;
-            case (S7COMM_AREA_COUNTER):
-                proto_item_append_text(item_tree, " (C");
-                break;
-            case (S7COMM_AREA_TIMER):
-                proto_item_append_text(item_tree, " (T");
-                break;
-            default:
-                proto_item_append_text(item_tree, " (unknown area");
-                break;
-        }
-        if (area == S7COMM_AREA_TIMER || area == S7COMM_AREA_COUNTER) {
-            proto_item_append_text(item_tree, " %d)", a_address);
-            proto_tree_add_uint(address_item_tree, hf_s7comm_item_address_nr, tvb, offset, 3, a_address);
-        } else {
-            proto_tree_add_uint(address_item_tree, hf_s7comm_item_address_byte, tvb, offset, 3, a_address);
-            proto_tree_add_uint(address_item_tree, hf_s7comm_item_address_bit, tvb, offset, 3, a_address);
-            proto_item_append_text(item_tree, " %d.%d %s %d)",
-                bytepos, bitpos, val_to_str(t_size, item_transportsizenames, "Unknown transport size: 0x%02x"), len);
-        }
-        offset += 3;
+        s7any->t_size = tvb_get_guint8(tvb, offset);
+        s7any->len = tvb_get_ntohs(tvb, offset + 1);
+        s7any->db = tvb_get_ntohs(tvb, offset + 3);
+        s7any->area = tvb_get_guint8(tvb, offset + 5);
+        s7any->address = tvb_get_ntoh24(tvb, offset + 6);
+        offset = s7comm_add_s7any_address_to_tree(tvb, offset, item_tree, s7any);
     /****************************************************************************/
     /******************** S7-400 special address mode (kind of cyclic read) *****/
     /* The response to this kind of request can't be decoded, because in the response
@@ -1464,6 +1658,7 @@ s7comm_decode_param_item(tvbuff_t *tvb,
     /******************** TIA S7 1200 symbolic address mode *********************/
     } else if (var_spec_type == 0x12 && var_spec_length >= 14 && var_spec_syntax_id == S7COMM_SYNTAXID_1200SYM) {
         proto_item_append_text(item_tree, " 1200 symbolic address");
+        tia_offset = offset;
         /* first byte in address seems always be 0xff */
         proto_tree_add_item(item_tree, hf_s7comm_tia1200_item_reserved1, tvb, offset, 1, ENC_BIG_ENDIAN);
         offset += 1;
@@ -1488,7 +1683,8 @@ s7comm_decode_param_item(tvbuff_t *tvb,
             proto_item_append_text(item_tree, " - Unknown area specification");
             offset += 2;
         }
-        proto_tree_add_item(item_tree, hf_s7comm_tia1200_item_crc, tvb, offset, 4, ENC_BIG_ENDIAN);
+        tia_crc = tvb_get_ntohl(tvb, offset);
+        proto_tree_add_uint(item_tree, hf_s7comm_tia1200_item_crc, tvb, offset, 4, tia_crc);
         offset += 4;
 
         for (i = 0; i < (var_spec_length - 10) / 4; i++) {
@@ -1504,6 +1700,15 @@ s7comm_decode_param_item(tvbuff_t *tvb,
             );
             proto_tree_add_item(sub_item_tree, hf_s7comm_tia1200_item_value, tvb, offset, 4, ENC_BIG_ENDIAN);
             offset += 4;
+            tia_flags_list[i] = tia_lid_flags;
+            tia_value_list[i] = tia_value;
+        }
+        /* Resolve the LID path of a DB access with the DB layout file */
+        if (tia_var_area1 == S7COMM_TIA1200_VAR_ITEM_AREA1_DB &&
+            s7comm_get_dblayout_symbol(tia_var_area2, tia_crc, tia_flags_list, tia_value_list, i, symbol, sizeof(symbol))) {
+            proto_item_append_text(item_tree, " \"%s\"", symbol);
+            sub_item = proto_tree_add_string(item_tree, hf_s7comm_item_symbol, tvb, tia_offset, offset - tia_offset, symbol);
+            PROTO_ITEM_SET_GENERATED(sub_item);
         }
     /****************************************************************************/
     /******************** Sinumerik NCK access **********************************/
@@ -1524,10 +1729,21 @@ s7comm_decode_param_item(tvbuff_t *tvb,
         nck_module = tvb_get_guint8(tvb, offset);
         proto_tree_add_item(item_tree, hf_s7comm_item_nck_module, tvb, offset, 1, ENC_BIG_ENDIAN);
         offset += 1;
+        s7any->nck_linecount = tvb_get_guint8(tvb, offset);
         proto_tree_add_item(item_tree, hf_s7comm_item_nck_linecount, tvb, offset, 1, ENC_BIG_ENDIAN);
         offset += 1;
         proto_item_append_text(item_tree, " (NCK Area:%d Unit:%d Column:%d Line:%d Module:0x%02x)",
             nck_area, nck_unit, nck_column, nck_line, nck_module);
+        s7any->nck_areaunit = area;
+        s7any->nck_module = nck_module;
+        s7any->nck_column = nck_column;
+        s7any->nck_line = nck_line;
+        nck_name = s7comm_get_nck_var_name(nck_area, nck_module, nck_column);
+        if (nck_name != NULL) {
+            proto_item_append_text(item_tree, " \"%s\"", nck_name);
+            sub_item = proto_tree_add_string(item_tree, hf_s7comm_item_symbol, tvb, offset - 7, 7, nck_name);
+            PROTO_ITEM_SET_GENERATED(sub_item);
+        }
     }
     else {
         /* var spec, length and syntax id are still added to tree here */
@@ -1537,6 +1753,272 @@ s7comm_decode_param_item(tvbuff_t *tvb,
     return offset;
 }
 
+/*******************************************************************************************************
+ *
+ * Dissect the item list of a read/write request or cyclic data request.
+ * The S7ANY addresses of the items are returned in items, which must have space for item_count items.
+ *
+ *******************************************************************************************************/
+static guint32
+s7comm_decode_param_item_list(tvbuff_t *tvb,
+                              guint32 offset,
+                              proto_tree *sub_tree,
+                              guint8 item_count,
+                              s7comm_s7any_item_t *items)
+{
+    proto_item *item = NULL;
+    proto_tree *item_tree = NULL;
+    guint32 offset_old;
+    guint32 len;
+    guint8 i;
+
+    if (s7comm_get_s7any_item_list(tvb, offset, item_count, items)) {
+        for (i = 0; i < item_count; i++) {
+            item = proto_tree_add_item(sub_tree, hf_s7comm_param_item, tvb, offset, S7COMM_S7ANY_ITEM_LENGTH, ENC_NA);
+            item_tree = proto_item_add_subtree(item, ett_s7comm_param_item);
+            proto_item_append_text(item, " [%d]:", i + 1);
+            proto_tree_add_uint(item_tree, hf_s7comm_item_varspec, tvb, offset, 1, 0x12);
+            proto_tree_add_uint(item_tree, hf_s7comm_item_varspec_length, tvb, offset + 1, 1, 10);
+            proto_tree_add_uint(item_tree, hf_s7comm_item_syntax_id, tvb, offset + 2, 1, S7COMM_SYNTAXID_S7ANY);
+            offset = s7comm_add_s7any_address_to_tree(tvb, offset + 3, item_tree, &items[i]);
+        }
+        return offset;
+    }
+    /* mixed syntax-ids or incomplete list, decode item by item */
+    for (i = 0; i < item_count; i++) {
+        offset_old = offset;
+        offset = s7comm_decode_param_item(tvb, offset, sub_tree, i, &items[i]);
+        /* if length is not a multiple of 2 and this is not the last item, then add a fill-byte */
+        len = offset - offset_old;
+        if ((len % 2) && (i < item_count)) {
+            offset += 1;
+        }
+    }
+    return offset;
+}
+
+/*******************************************************************************************************
+ *
+ * Data of a PDU attached to the frame. A TCP segment may carry several S7 PDUs, so the data of a kind
+ * is kept by the index of the PDU in the frame and an id, e.g. the PDU reference or the EventID.
+ *
+ *******************************************************************************************************/
+static void
+s7comm_count_pdu(packet_info *pinfo)
+{
+    guint32 count;
+
+    count = GPOINTER_TO_UINT(p_get_proto_data(pinfo->pool, pinfo, proto_s7comm, S7COMM_PROTO_DATA_PDU_COUNT));
+    p_remove_proto_data(pinfo->pool, pinfo, proto_s7comm, S7COMM_PROTO_DATA_PDU_COUNT);
+    p_add_proto_data(pinfo->pool, pinfo, proto_s7comm, S7COMM_PROTO_DATA_PDU_COUNT, GUINT_TO_POINTER(count + 1));
+}
+
+static void
+s7comm_pdu_data_key(packet_info *pinfo,
+                    guint32 id,
+                    guint32 *pdu_key,
+                    wmem_tree_key_t *key)
+{
+    /* The PDU being dissected is the last one counted */
+    pdu_key[0] = GPOINTER_TO_UINT(p_get_proto_data(pinfo->pool, pinfo, proto_s7comm, S7COMM_PROTO_DATA_PDU_COUNT));
+    pdu_key[1] = id;
+    key[0].length = 2;
+    key[0].key = pdu_key;
+    key[1].length = 0;
+    key[1].key = NULL;
+}
+
+void
+s7comm_add_pdu_data(packet_info *pinfo,
+                    int proto,
+                    guint32 kind,
+                    guint32 id,
+                    void *data)
+{
+    wmem_tree_t *pdus;
+    wmem_tree_key_t key[2];
+    guint32 pdu_key[2];
+
+    pdus = (wmem_tree_t *)p_get_proto_data(wmem_file_scope(), pinfo, proto, kind);
+    if (pdus == NULL) {
+        pdus = wmem_tree_new(wmem_file_scope());
+        p_add_proto_data(wmem_file_scope(), pinfo, proto, kind, pdus);
+    }
+    s7comm_pdu_data_key(pinfo, id, pdu_key, key);
+    wmem_tree_insert32_array(pdus, key, data);
+}
+
+void *
+s7comm_get_pdu_data(packet_info *pinfo,
+                    int proto,
+                    guint32 kind,
+                    guint32 id)
+{
+    wmem_tree_t *pdus;
+    wmem_tree_key_t key[2];
+    guint32 pdu_key[2];
+
+    pdus = (wmem_tree_t *)p_get_proto_data(wmem_file_scope(), pinfo, proto, kind);
+    if (pdus == NULL) {
+        return NULL;
+    }
+    s7comm_pdu_data_key(pinfo, id, pdu_key, key);
+    return wmem_tree_lookup32_array(pdus, key);
+}
+
+/*******************************************************************************************************
+ *
+ * Get the data of the connection the packet belongs to
+ *
+ *******************************************************************************************************/
+static s7comm_conv_data_t *
+s7comm_get_conv_data(packet_info *pinfo)
+{
+    conversation_t *conversation;
+    s7comm_conv_data_t *conv_data;
+
+    conversation = find_or_create_conversation(pinfo);
+    conv_data = (s7comm_conv_data_t *)conversation_get_proto_data(conversation, proto_s7comm);
+    if (conv_data == NULL) {
+        conv_data = wmem_new0(wmem_file_scope(), s7comm_conv_data_t);
+        conv_data->jobs = wmem_tree_new(wmem_file_scope());
+        conversation_add_proto_data(conversation, proto_s7comm, conv_data);
+    }
+    return conv_data;
+}
+
+/*******************************************************************************************************
+ *
+ * Remember the item addresses of a read/write job, a cyclic data or variable table request, to decode
+ * the response. Read/write jobs are stored with their PDU reference, the other requests replace the last one.
+ *
+ *******************************************************************************************************/
+static void
+s7comm_store_job_items(packet_info *pinfo,
+                       guint16 pduref,
+                       guint8 job_type,
+                       guint8 item_count,
+                       const s7comm_s7any_item_t *items)
+{
+    s7comm_conv_data_t *conv_data;
+    s7comm_job_items_t *job;
+
+    if (pinfo->fd->flags.visited || item_count == 0) {
+        return;
+    }
+    conv_data = s7comm_get_conv_data(pinfo);
+    job = wmem_new(wmem_file_scope(), s7comm_job_items_t);
+    job->item_count = item_count;
+    job->items = wmem_alloc_array(wmem_file_scope(), s7comm_s7any_item_t, item_count);
+    memcpy(job->items, items, item_count * sizeof(s7comm_s7any_item_t));
+    if (job_type == S7COMM_JOB_CYCLIC) {
+        conv_data->cyclic_job = job;
+    } else if (job_type == S7COMM_JOB_VARTAB) {
+        conv_data->vartab_job = job;
+    } else {
+        wmem_tree_insert32(conv_data->jobs, pduref, job);
+    }
+}
+
+/*******************************************************************************************************
+ *
+ * Get the item addresses of the job a response or cyclic data belongs to.
+ * On the first pass the job is searched in the connection and attached to the frame.
+ * Returns NULL if the job is unknown, or if the number of items doesn't match.
+ *
+ *******************************************************************************************************/
+static const s7comm_s7any_item_t *
+s7comm_get_job_items(packet_info *pinfo,
+                     guint16 pduref,
+                     guint8 job_type,
+                     guint8 item_count)
+{
+    s7comm_conv_data_t *conv_data;
+    s7comm_job_items_t *job;
+
+    job = (s7comm_job_items_t *)s7comm_get_pdu_data(pinfo, proto_s7comm, S7COMM_PROTO_DATA_JOB, pduref);
+    if (job == NULL && !pinfo->fd->flags.visited) {
+        conv_data = s7comm_get_conv_data(pinfo);
+        if (job_type == S7COMM_JOB_CYCLIC) {
+            job = conv_data->cyclic_job;
+        } else if (job_type == S7COMM_JOB_VARTAB) {
+            job = conv_data->vartab_job;
+        } else {
+            job = (s7comm_job_items_t *)wmem_tree_lookup32(conv_data->jobs, pduref);
+        }
+        if (job != NULL) {
+            s7comm_add_pdu_data(pinfo, proto_s7comm, S7COMM_PROTO_DATA_JOB, pduref, job);
+        }
+    }
+    if (job == NULL || job->item_count != item_count) {
+        return NULL;
+    }
+    return job->items;
+}
+
+/*******************************************************************************************************
+ *
+ * Remember the block type of a request to list the blocks of a type, the response doesn't contain it
+ *
+ *******************************************************************************************************/
+static void
+s7comm_store_listtype_request(packet_info *pinfo,
+                              guint8 block_type)
+{
+    if (!pinfo->fd->flags.visited) {
+        s7comm_get_conv_data(pinfo)->listtype_block_type = block_type;
+    }
+}
+
+/*******************************************************************************************************
+ *
+ * Get the block type of the request a list blocks of type response belongs to, 0 if unknown.
+ * On the first pass the type is taken from the connection and attached to the frame.
+ *
+ *******************************************************************************************************/
+static guint8
+s7comm_get_listtype_request(packet_info *pinfo)
+{
+    guint8 block_type;
+
+    if (!pinfo->fd->flags.visited) {
+        block_type = s7comm_get_conv_data(pinfo)->listtype_block_type;
+        if (block_type != 0) {
+            s7comm_add_pdu_data(pinfo, proto_s7comm, S7COMM_PROTO_DATA_BLOCKTYPE, 0, GUINT_TO_POINTER(block_type));
+        }
+        return block_type;
+    }
+    return (guint8)GPOINTER_TO_UINT(s7comm_get_pdu_data(pinfo, proto_s7comm, S7COMM_PROTO_DATA_BLOCKTYPE, 0));
+}
+
+/*******************************************************************************************************
+ *
+ * Block type as in block lists, of a block type in a block info
+ *
+ *******************************************************************************************************/
+static guint8
+s7comm_get_blocktype_from_subblktype(guint8 subblktype)
+{
+    switch (subblktype) {
+        case S7COMM_SUBBLKTYPE_OB:
+            return S7COMM_BLOCKTYPE_OB;
+        case S7COMM_SUBBLKTYPE_DB:
+            return S7COMM_BLOCKTYPE_DB;
+        case S7COMM_SUBBLKTYPE_SDB:
+            return S7COMM_BLOCKTYPE_SDB;
+        case S7COMM_SUBBLKTYPE_FC:
+            return S7COMM_BLOCKTYPE_FC;
+        case S7COMM_SUBBLKTYPE_SFC:
+            return S7COMM_BLOCKTYPE_SFC;
+        case S7COMM_SUBBLKTYPE_FB:
+            return S7COMM_BLOCKTYPE_FB;
+        case S7COMM_SUBBLKTYPE_SFB:
+            return S7COMM_BLOCKTYPE_SFB;
+        default:
+            return 0;
+    }
+}
+
 /*******************************************************************************************************
  *
  * Decode parameter part of a PDU for setup communication
@@ -1586,6 +2068,93 @@ s7comm_decode_response_write_data(tvbuff_t *tvb,
     return offset;
 }
 
+/*******************************************************************************************************
+ *
+ * Store the data of an item in the shadow memory of the PLC
+ *
+ *******************************************************************************************************/
+static void
+s7comm_update_shadow(s7comm_shadow_plc_t *shadow,
+                     const s7comm_s7any_item_t *item,
+                     guint8 tsize,
+                     tvbuff_t *tvb,
+                     guint32 offset,
+                     guint32 len)
+{
+    if (shadow == NULL || item->area == 0) {
+        return;
+    }
+    if (item->area == S7COMM_AREA_TIMER || item->area == S7COMM_AREA_COUNTER) {
+        s7comm_shadow_write(shadow, item->area, 0, item->address, tvb, offset, len);
+    } else if (tsize == S7COMM_DATA_TRANSPORT_SIZE_BBIT) {
+        s7comm_shadow_write_bit(shadow, item->area, item->db, item->address, tvb_get_guint8(tvb, offset) & 0x01);
+    } else {
+        s7comm_shadow_write(shadow, item->area, item->db, item->address / 8, tvb, offset, len);
+    }
+}
+
+/*******************************************************************************************************
+ *
+ * Add the last known values of the items of a read job, from the shadow memory of the PLC
+ *
+ *******************************************************************************************************/
+static void
+s7comm_add_shadow_values_to_tree(tvbuff_t *tvb,
+                                 packet_info *pinfo,
+                                 proto_tree *tree,
+                                 guint8 item_count,
+                                 const s7comm_s7any_item_t *items)
+{
+    s7comm_shadow_plc_t *shadow;
+    guint8 i;
+
+    shadow = s7comm_shadow_find_plc(&pinfo->dst);
+    if (shadow == NULL) {
+        return;
+    }
+    for (i = 0; i < item_count; i++) {
+        if (items[i].area == 0 || items[i].t_size == S7COMM_TRANSPORT_SIZE_BIT) {
+            continue;
+        }
+        if (items[i].area == S7COMM_AREA_TIMER || items[i].area == S7COMM_AREA_COUNTER) {
+            s7comm_shadow_add_value_to_tree(tvb, tree, shadow, items[i].area, 0, items[i].address,
+                items[i].len * 2, pinfo->fd->num, i);
+        } else {
+            s7comm_shadow_add_value_to_tree(tvb, tree, shadow, items[i].area, items[i].db, items[i].address / 8,
+                s7comm_get_s7any_bitlen(&items[i]) / 8, pinfo->fd->num, i);
+        }
+    }
+}
+
+/*******************************************************************************************************
+ *
+ * Length in bytes of the data of a data item, without the header and the fill byte
+ *
+ *******************************************************************************************************/
+static guint16
+s7comm_get_data_item_len(tvbuff_t *tvb,
+                         guint32 offset)
+{
+    guint8 tsize;
+    guint16 len;
+
+    tsize = tvb_get_guint8(tvb, offset + 1);
+    len = tvb_get_ntohs(tvb, offset + 2);
+    /* calculate length in bytes */
+    if (tsize == S7COMM_DATA_TRANSPORT_SIZE_BBIT ||
+        tsize == S7COMM_DATA_TRANSPORT_SIZE_BBYTE ||
+        tsize == S7COMM_DATA_TRANSPORT_SIZE_BINT
+        ) {     /* given length is in number of bits */
+        if (len % 8) { /* len is not a multiple of 8, then round up to next number */
+            len /= 8;
+            len = len + 1;
+        } else {
+            len /= 8;
+        }
+    }
+    return len;
+}
+
 /*******************************************************************************************************
  *
  * PDU Type: Response -> Function Read  -> Data part
@@ -1596,6 +2165,8 @@ static guint32
 s7comm_decode_response_read_data(tvbuff_t *tvb,
                                  proto_tree *tree,
                                  guint8 item_count,
+                                 const s7comm_s7any_item_t *items,   /* addresses from the request, may be NULL */
+                                 s7comm_shadow_plc_t *shadow,        /* memory of the PLC to update, may be NULL */
                                  guint32 offset)
 {
     guint8 ret_val = 0;
@@ -1613,19 +2184,7 @@ s7comm_decode_response_read_data(tvbuff_t *tvb,
             ret_val == S7COMM_ITEM_RETVAL_DATA_ERR
             ) {
             tsize = tvb_get_guint8(tvb, offset + 1);
-            len = tvb_get_ntohs(tvb, offset + 2);
-            /* calculate length in bytes */
-            if (tsize == S7COMM_DATA_TRANSPORT_SIZE_BBIT ||
-                tsize == S7COMM_DATA_TRANSPORT_SIZE_BBYTE ||
-                tsize == S7COMM_DATA_TRANSPORT_SIZE_BINT
-                ) {     /* given length is in number of bits */
-                if (len % 8) { /* len is not a multiple of 8, then round up to next number */
-                    len /= 8;
-                    len = len + 1;
-                } else {
-                    len /= 8;
-                }
-            }
+            len = s7comm_get_data_item_len(tvb, offset);
 
             /* the PLC places extra bytes at the end of all but last result, if length is not a multiple of 2 */
             if ((len % 2) && (i < item_count)) {
@@ -1646,6 +2205,16 @@ s7comm_decode_response_read_data(tvbuff_t *tvb,
 
         if (ret_val == S7COMM_ITEM_RETVAL_DATA_OK || ret_val == S7COMM_ITEM_RETVAL_RESERVED) {
             proto_tree_add_item(item_tree, hf_s7comm_readresponse_data, tvb, offset, len, ENC_NA);
+            if (items != NULL) {
+                s7comm_update_shadow(shadow, &items[i - 1], tsize, tvb, offset, len);
+            }
+            if (items != NULL && items[i - 1].area == S7COMM_AREA_DB) {
+                s7comm_add_dblayout_tags_to_tree(tvb, item_tree, items[i - 1].db, items[i - 1].address,
+                    (tsize == S7COMM_DATA_TRANSPORT_SIZE_BBIT) ? 1 : len * 8, offset);
+            } else if (items != NULL && items[i - 1].syntax_id == S7COMM_SYNTAXID_NCK) {
+                s7comm_add_nck_values_to_tree(tvb, item_tree, items[i - 1].nck_areaunit >> 5, items[i - 1].nck_module,
+                    items[i - 1].nck_column, items[i - 1].nck_line, items[i - 1].nck_linecount, offset, len);
+            }
             offset += len;
             if (len != len2) {
                 proto_tree_add_item(item_tree, hf_s7comm_data_fillbyte, tvb, offset, 1, ENC_BIG_ENDIAN);
@@ -1656,6 +2225,101 @@ s7comm_decode_response_read_data(tvbuff_t *tvb,
     return offset;
 }
 
+/*******************************************************************************************************
+ *
+ * Queue a state changing operation for the audit log, the strings must be valid for the packet.
+ * The callers build the strings only if have_tap_listener(s7comm_audit_tap).
+ *
+ *******************************************************************************************************/
+static void
+s7comm_queue_audit(packet_info *pinfo,
+                   const gchar *operation,
+                   const gchar *object,
+                   const gchar *details)
+{
+    s7comm_audit_tap_t *audit;
+
+    audit = wmem_new(wmem_packet_scope(), s7comm_audit_tap_t);
+    audit->operation = operation;
+    audit->object = object;
+    audit->details = details;
+    tap_queue_packet(s7comm_audit_tap, pinfo, audit);
+}
+
+/*******************************************************************************************************
+ *
+ * Audit a write request with the addresses of all items
+ *
+ *******************************************************************************************************/
+static void
+s7comm_audit_writevar(packet_info *pinfo,
+                      guint8 item_count,
+                      const s7comm_s7any_item_t *items)
+{
+    wmem_strbuf_t *object;
+    gchar str[S7COMM_ITEM_ADDRESS_STRLEN];
+    guint8 i;
+
+    object = wmem_strbuf_new(wmem_packet_scope(), "");
+    for (i = 0; i < item_count; i++) {
+        if (i > 0) {
+            wmem_strbuf_append(object, "; ");
+        }
+        if (items[i].syntax_id == S7COMM_SYNTAXID_S7ANY) {
+            s7comm_get_s7any_address_string(&items[i], str, sizeof(str));
+            wmem_strbuf_append(object, str);
+        } else {
+            wmem_strbuf_append(object, val_to_str(items[i].syntax_id, item_syntaxid_names, "Syntax-Id 0x%02x"));
+        }
+    }
+    s7comm_queue_audit(pinfo, "Write var", wmem_strbuf_get_str(object),
+        wmem_strdup_printf(wmem_packet_scope(), "%u items", item_count));
+}
+
+/*******************************************************************************************************
+ *
+ * Queue a PDU of a block transfer or a setup communication for the transfer statistics
+ *
+ *******************************************************************************************************/
+static void
+s7comm_queue_transfer(packet_info *pinfo,
+                      guint8 kind,
+                      guint16 pdu_size,
+                      guint32 data_len)
+{
+    s7comm_transfer_tap_t *transfer;
+
+    transfer = wmem_new0(wmem_packet_scope(), s7comm_transfer_tap_t);
+    transfer->kind = kind;
+    transfer->pdu_size = pdu_size;
+    transfer->data_len = data_len;
+    tap_queue_packet(s7comm_transfer_tap, pinfo, transfer);
+}
+
+/*******************************************************************************************************
+ *
+ * Kind of a block transfer job for the transfer statistics
+ *
+ *******************************************************************************************************/
+static guint8
+s7comm_get_transfer_kind(guint8 function)
+{
+    switch (function) {
+        case S7COMM_FUNCREQUESTDOWNLOAD:
+            return S7COMM_TRANSFER_DOWNLOAD_START;
+        case S7COMM_FUNCDOWNLOADBLOCK:
+            return S7COMM_TRANSFER_DOWNLOAD_REQ;
+        case S7COMM_FUNCDOWNLOADENDED:
+            return S7COMM_TRANSFER_DOWNLOAD_END;
+        case S7COMM_FUNCSTARTUPLOAD:
+            return S7COMM_TRANSFER_UPLOAD_START;
+        case S7COMM_FUNCUPLOAD:
+            return S7COMM_TRANSFER_UPLOAD_REQ;
+        default:
+            return S7COMM_TRANSFER_UPLOAD_END;
+    }
+}
+
 /*******************************************************************************************************
  *
  * PDU Type: Request or Response -> Function 0x28 (PLC control functions)
@@ -1671,7 +2335,11 @@ s7comm_decode_plc_controls_param_hex28(tvbuff_t *tvb,
     guint8 count;
     guint8 i;
     guint8 *str;
+    wmem_strbuf_t *audit_details = NULL;
 
+    if (have_tap_listener(s7comm_audit_tap)) {
+        audit_details = wmem_strbuf_new(wmem_packet_scope(), "");
+    }
     /* The first byte 0x28 is checked and inserted to tree outside, so skip it here */
     offset += 1;
 
@@ -1686,6 +2354,9 @@ s7comm_decode_plc_controls_param_hex28(tvbuff_t *tvb,
     if (len == 2) {
         /* C = cold start */
         proto_tree_add_item(tree, hf_s7comm_data_plccontrol_argument, tvb, offset, 2, ENC_ASCII|ENC_NA);
+        if (audit_details) {
+            wmem_strbuf_append_printf(audit_details, "Argument %s", tvb_get_string_enc(wmem_packet_scope(), tvb, offset, 2, ENC_ASCII));
+        }
         offset +=2;
     } else if (len > 2) {
         count = tvb_get_guint8(tvb, offset);            /* number of blocks following */
@@ -1704,6 +2375,10 @@ s7comm_decode_plc_controls_param_hex28(tvbuff_t *tvb,
             proto_tree_add_item(tree, hf_s7comm_data_plccontrol_block_num, tvb, offset, 5, ENC_ASCII|ENC_NA);
             str = tvb_get_string_enc(wmem_packet_scope(), tvb, offset, 5, ENC_ASCII);
             col_append_fstr(pinfo->cinfo, COL_INFO, " No.:[%s]", str);
+            if (audit_details) {
+                wmem_strbuf_append_printf(audit_details, "%s%s %s", (i > 0) ? "; " : "",
+                    val_to_str_const(tvb_get_guint8(tvb, offset - 1), blocktype_names, "?"), str);
+            }
             offset += 5;
             /* 'P', 'B' or 'A' is following
              Destination filesystem?
@@ -1726,6 +2401,10 @@ s7comm_decode_plc_controls_param_hex28(tvbuff_t *tvb,
      *   _PLC_MEMORYRESET = Reset the PLC memory
      */
     proto_tree_add_item(tree, hf_s7comm_data_plccontrol_pi_service, tvb, offset, len, ENC_ASCII|ENC_NA);
+    if (audit_details) {
+        s7comm_queue_audit(pinfo, "PLC control", (const gchar *)tvb_get_string_enc(wmem_packet_scope(), tvb, offset, len, ENC_ASCII),
+            wmem_strbuf_get_str(audit_details));
+    }
     offset += len;
 
     return offset;
@@ -1738,6 +2417,7 @@ s7comm_decode_plc_controls_param_hex28(tvbuff_t *tvb,
  *******************************************************************************************************/
 static guint32
 s7comm_decode_plc_controls_param_hex29(tvbuff_t *tvb,
+                      packet_info *pinfo,
                       proto_tree *tree,
                       guint32 offset)
 {
@@ -1754,6 +2434,9 @@ s7comm_decode_plc_controls_param_hex29(tvbuff_t *tvb,
     offset += 1;
     /* Function as string */
     proto_tree_add_item(tree, hf_s7comm_data_plccontrol_pi_service, tvb, offset, len, ENC_ASCII|ENC_NA);
+    if (have_tap_listener(s7comm_audit_tap)) {
+        s7comm_queue_audit(pinfo, "PLC stop", (const gchar *)tvb_get_string_enc(wmem_packet_scope(), tvb, offset, len, ENC_ASCII), NULL);
+    }
     offset += len;
 
     return offset;
@@ -1774,9 +2457,24 @@ s7comm_decode_plc_controls_param_hex1x(tvbuff_t *tvb,
     guint8 len;
     guint8 function;
     guint8 *str;
+    const gchar *audit_operation = NULL;
+    const gchar *audit_object = NULL;
+    const gchar *audit_details = NULL;
+    s7comm_transfer_tap_t *transfer = NULL;
 
     function = tvb_get_guint8(tvb, offset);
     offset += 1;
+    if (have_tap_listener(s7comm_transfer_tap)) {
+        transfer = wmem_new0(wmem_packet_scope(), s7comm_transfer_tap_t);
+        transfer->kind = s7comm_get_transfer_kind(function);
+    }
+    if (have_tap_listener(s7comm_audit_tap)) {
+        if (function == S7COMM_FUNCREQUESTDOWNLOAD) {
+            audit_operation = "Download start";
+        } else if (function == S7COMM_FUNCDOWNLOADENDED) {
+            audit_operation = "Download end";
+        }
+    }
 
     /* Meaning of first byte is unknown */
     proto_tree_add_item(tree, hf_s7comm_data_blockcontrol_unknown1, tvb, offset, 1, ENC_NA);
@@ -1789,6 +2487,12 @@ s7comm_decode_plc_controls_param_hex1x(tvbuff_t *tvb,
     offset += 4;
     if (plength <= 8) {
         /* Upload or End upload functions have no other data */
+        if (audit_operation) {
+            s7comm_queue_audit(pinfo, audit_operation, NULL, NULL);
+        }
+        if (transfer) {
+            tap_queue_packet(s7comm_transfer_tap, pinfo, transfer);
+        }
         return offset;
     }
 
@@ -1816,6 +2520,14 @@ s7comm_decode_plc_controls_param_hex1x(tvbuff_t *tvb,
     offset += 5;
     /* 'P', 'B' or 'A' is following */
     proto_tree_add_item(tree, hf_s7comm_data_blockcontrol_dest_filesys, tvb, offset, 1, ENC_ASCII|ENC_NA);
+    if (audit_operation) {
+        audit_object = wmem_strdup_printf(wmem_packet_scope(), "%s %s %c",
+            val_to_str_const(tvb_get_guint8(tvb, offset - 6), blocktype_names, "?"), str, tvb_get_guint8(tvb, offset));
+    }
+    if (transfer) {
+        transfer->block = wmem_strdup_printf(wmem_packet_scope(), "%s %s",
+            val_to_str_const(tvb_get_guint8(tvb, offset - 6), blocktype_names, "?"), str);
+    }
     offset += 1;
 
     /* Part 2, only available in "request download" */
@@ -1829,8 +2541,23 @@ s7comm_decode_plc_controls_param_hex1x(tvbuff_t *tvb,
         proto_tree_add_item(tree, hf_s7comm_data_blockcontrol_loadmem_len, tvb, offset, 6, ENC_ASCII|ENC_NA);
         offset += 6;
         proto_tree_add_item(tree, hf_s7comm_data_blockcontrol_mc7code_len, tvb, offset, 6, ENC_ASCII|ENC_NA);
+        if (audit_operation) {
+            audit_details = wmem_strdup_printf(wmem_packet_scope(), "Load memory %s, MC7 %s",
+                tvb_get_string_enc(wmem_packet_scope(), tvb, offset - 6, 6, ENC_ASCII),
+                tvb_get_string_enc(wmem_packet_scope(), tvb, offset, 6, ENC_ASCII));
+        }
+        if (transfer) {
+            transfer->loadmem_len = (guint32)strtoul((const char *)tvb_get_string_enc(wmem_packet_scope(), tvb, offset - 6, 6, ENC_ASCII), NULL, 10);
+            transfer->mc7_len = (guint32)strtoul((const char *)tvb_get_string_enc(wmem_packet_scope(), tvb, offset, 6, ENC_ASCII), NULL, 10);
+        }
         offset += 6;
     }
+    if (audit_operation) {
+        s7comm_queue_audit(pinfo, audit_operation, audit_object, audit_details);
+    }
+    if (transfer) {
+        tap_queue_packet(s7comm_transfer_tap, pinfo, transfer);
+    }
     return offset;
 }
 
@@ -1924,7 +2651,8 @@ static guint32
 s7comm_decode_ud_prog_vartab_req_item(tvbuff_t *tvb,
                           guint32 offset,
                           proto_tree *sub_tree,
-                          guint16 item_no)
+                          guint16 item_no,
+                          s7comm_s7any_item_t *s7any)     /* returns the address as S7ANY, area 0 if unknown */
 {
     guint32 bytepos = 0;
     guint16 len = 0;
@@ -1932,6 +2660,8 @@ s7comm_decode_ud_prog_vartab_req_item(tvbuff_t *tvb,
     guint8 area = 0;
     proto_item *item = NULL;
 
+    memset(s7any, 0, sizeof(s7comm_s7any_item_t));
+
     /* Insert a new tree with 6 bytes for every item */
     item = proto_tree_add_item(sub_tree, hf_s7comm_param_item, tvb, offset, 6, ENC_NA);
 
@@ -2021,6 +2751,60 @@ s7comm_decode_ud_prog_vartab_req_item(tvbuff_t *tvb,
                 proto_item_append_text(sub_tree, " (C %d)", bytepos);
             break;
     }
+    /* convert to a S7ANY address, the upper nibble is the memory area, the lower one the size of the elements */
+    s7any->len = len;
+    switch (area) {
+        case S7COMM_UD_SUBF_PROG_VARTAB_AREA_T:
+            s7any->area = S7COMM_AREA_TIMER;
+            s7any->t_size = S7COMM_TRANSPORT_SIZE_TIMER;
+            s7any->address = bytepos;
+            break;
+        case S7COMM_UD_SUBF_PROG_VARTAB_AREA_C:
+            s7any->area = S7COMM_AREA_COUNTER;
+            s7any->t_size = S7COMM_TRANSPORT_SIZE_COUNTER;
+            s7any->address = bytepos;
+            break;
+        default:
+            switch (area & 0xf0) {
+                case 0x00:
+                    s7any->area = S7COMM_AREA_FLAGS;
+                    break;
+                case 0x10:
+                    s7any->area = S7COMM_AREA_INPUTS;
+                    break;
+                case 0x20:
+                    s7any->area = S7COMM_AREA_OUTPUTS;
+                    break;
+                case 0x30:
+                    s7any->area = S7COMM_AREA_P;
+                    break;
+                case 0x70:
+                    s7any->area = S7COMM_AREA_DB;
+                    s7any->db = db;
+                    break;
+            }
+            switch (area & 0x0f) {
+                case 1:
+                    s7any->t_size = S7COMM_TRANSPORT_SIZE_BYTE;
+                    break;
+                case 2:
+                    s7any->t_size = S7COMM_TRANSPORT_SIZE_WORD;
+                    break;
+                case 3:
+                    s7any->t_size = S7COMM_TRANSPORT_SIZE_DWORD;
+                    break;
+                default:
+                    s7any->area = 0;
+                    break;
+            }
+            s7any->address = bytepos * 8;
+            break;
+    }
+    if (s7any->area != 0) {
+        s7any->syntax_id = S7COMM_SYNTAXID_S7ANY;
+        s7comm_add_symbol_to_tree(tvb, offset - 6, 6, sub_tree, s7any->area, s7any->db,
+            s7any->address, s7comm_get_s7any_bitlen(s7any));
+    }
     return offset;
 }
 
@@ -2033,7 +2817,9 @@ static guint32
 s7comm_decode_ud_prog_vartab_res_item(tvbuff_t *tvb,
                           guint32 offset,
                           proto_tree *sub_tree,
-                          guint16 item_no)
+                          guint16 item_no,
+                          const s7comm_s7any_item_t *s7any,   /* address from the request, may be NULL */
+                          s7comm_shadow_plc_t *shadow)        /* memory of the PLC to update, may be NULL */
 {
     guint16 len = 0, len2 = 0;
     guint8 ret_val = 0;
@@ -2073,6 +2859,9 @@ s7comm_decode_ud_prog_vartab_res_item(tvbuff_t *tvb,
     offset += head_len;
     if (ret_val == S7COMM_ITEM_RETVAL_DATA_OK || ret_val == S7COMM_ITEM_RETVAL_RESERVED) {
         proto_tree_add_item(sub_tree, hf_s7comm_readresponse_data, tvb, offset, len, ENC_NA);
+        if (s7any != NULL) {
+            s7comm_update_shadow(shadow, s7any, tsize, tvb, offset, len);
+        }
         offset += len;
         if (len != len2) {
             proto_tree_add_item(sub_tree, hf_s7comm_data_fillbyte, tvb, offset, 1, ENC_BIG_ENDIAN);
@@ -2107,10 +2896,14 @@ s7comm_decode_ud_security_subfunc(tvbuff_t *tvb,
  *******************************************************************************************************/
 static guint32
 s7comm_decode_ud_pbc_subfunc(tvbuff_t *tvb,
+                             packet_info *pinfo,
                              proto_tree *data_tree,
+                             guint8 last_data_unit,
                              guint16 dlength,                   /* length of data part given in header */
                              guint32 offset)                    /* Offset on data part +4 */
 {
+    guint32 r_id;
+
     proto_tree_add_item(data_tree, hf_s7comm_item_varspec, tvb, offset, 1, ENC_BIG_ENDIAN);
     offset += 1;
     proto_tree_add_item(data_tree, hf_s7comm_item_varspec_length, tvb, offset, 1, ENC_BIG_ENDIAN);
@@ -2119,16 +2912,14 @@ s7comm_decode_ud_pbc_subfunc(tvbuff_t *tvb,
     offset += 1;
     proto_tree_add_item(data_tree, hf_s7comm_pbc_unknown, tvb, offset, 1, ENC_BIG_ENDIAN);
     offset += 1;
+    r_id = tvb_get_ntohl(tvb, offset);
     proto_tree_add_item(data_tree, hf_s7comm_pbc_r_id, tvb, offset, 4, ENC_BIG_ENDIAN);
     offset += 4;
     /* Only in the first telegram of possible several segments, an int16 of full data length is following.
-     * As the dissector can't check this, don't display the information
-     * and display the data as payload bytes.
+     * The segments of a transfer are reassembled, see packet-s7comm_pbc.c
      */
-    dlength = dlength - 4 - 8;  /* 4 bytes data header, 8 bytes varspec */
-    if (dlength > 0) {
-        proto_tree_add_item(data_tree, hf_s7comm_userdata_data, tvb, offset, dlength, ENC_NA);
-        offset += dlength;
+    if (dlength > 4 + 8) {      /* 4 bytes data header, 8 bytes varspec */
+        offset = s7comm_decode_pbc_data(tvb, pinfo, data_tree, r_id, last_data_unit == S7COMM_UD_LASTDATAUNIT_NO, offset, dlength - 4 - 8);
     }
 
     return offset;
@@ -2156,13 +2947,16 @@ s7comm_decode_ud_cpu_alarm_indication(tvbuff_t *tvb,
     guint8 syntax_id;
     guint8 sig_nr;
     guint8 signalstate;
+    s7comm_alarm_tap_t *alarm_tap;
 
+    alarm_tap = wmem_new0(wmem_packet_scope(), s7comm_alarm_tap_t);
+    alarm_tap->subfunc = subfunc;
     start_offset = offset;
     msg_item = proto_tree_add_item(data_tree, hf_s7comm_cpu_alarm_message_item, tvb, offset, 0, ENC_NA);
     msg_item_tree = proto_item_add_subtree(msg_item, ett_s7comm_cpu_alarm_message);
 
     /* 8 bytes timestamp */
-    offset = s7comm_add_timestamp_to_tree(tvb, msg_item_tree, offset, FALSE, FALSE);
+    offset = s7comm_add_timestamp_to_tree(tvb, msg_item_tree, offset, FALSE, FALSE, NULL);
     /* 2 bytes unknown, timezone? daylight-saving? */
     proto_tree_add_item(msg_item_tree, hf_s7comm_cpu_alarm_message_function1, tvb, offset, 2, ENC_BIG_ENDIAN);
     offset += 2;
@@ -2185,8 +2979,12 @@ s7comm_decode_ud_cpu_alarm_indication(tvbuff_t *tvb,
         offset += 4;
         proto_item_append_text(msg_item_tree, ": EventID=0x%08x", ev_id);
         col_append_fstr(pinfo->cinfo, COL_INFO, " EV_ID=0x%08x", ev_id);
+        s7comm_alarmcache_add_to_tree(tvb, pinfo, msg_item_tree, &pinfo->src, ev_id);
         /* 1 byte signalstate*/
         signalstate = tvb_get_guint8(tvb, offset);
+        alarm_tap->ev_id = ev_id;
+        alarm_tap->has_signalstate = TRUE;
+        alarm_tap->signalstate = signalstate;
         proto_tree_add_bitmask(msg_item_tree, tvb, offset, hf_s7comm_cpu_alarm_message_eventstate,
             ett_s7comm_cpu_alarm_message_eventstate, s7comm_cpu_alarm_message_eventstate_fields, ENC_BIG_ENDIAN);
         offset += 1;
@@ -2213,13 +3011,15 @@ s7comm_decode_ud_cpu_alarm_indication(tvbuff_t *tvb,
         offset += 1;
 
         /* 2 bytes ack-state */
+        alarm_tap->ackstate = tvb_get_ntohs(tvb, offset);
         proto_tree_add_bitmask(msg_item_tree, tvb, offset, hf_s7comm_cpu_alarm_message_ackstate,
             ett_s7comm_cpu_alarm_message_ackstate, s7comm_cpu_alarm_message_ackstate_fields, ENC_BIG_ENDIAN);
         offset += 2;
+        tap_queue_packet(s7comm_alarm_tap, pinfo, alarm_tap);
 
         /* associated value(s) */
         if (no_add_values > 0) {
-            offset = s7comm_decode_response_read_data(tvb, msg_item_tree, no_add_values, offset);
+            offset = s7comm_decode_response_read_data(tvb, msg_item_tree, no_add_values, NULL, NULL, offset);
         }
     } else if (syntax_id == S7COMM_SYNTAXID_ALARM_ACKMESSAGE) {
         /* 1 byte unknown / reserved */
@@ -2231,10 +3031,14 @@ s7comm_decode_ud_cpu_alarm_indication(tvbuff_t *tvb,
         offset += 4;
         proto_item_append_text(msg_item_tree, ": EventID=0x%08x", ev_id);
         col_append_fstr(pinfo->cinfo, COL_INFO, " EV_ID=0x%08x", ev_id);
+        s7comm_alarmcache_add_to_tree(tvb, pinfo, msg_item_tree, &pinfo->src, ev_id);
         /* 2 bytes ack-state */
+        alarm_tap->ev_id = ev_id;
+        alarm_tap->ackstate = tvb_get_ntohs(tvb, offset);
         proto_tree_add_bitmask(msg_item_tree, tvb, offset, hf_s7comm_cpu_alarm_message_ackstate,
             ett_s7comm_cpu_alarm_message_ackstate, s7comm_cpu_alarm_message_ackstate_fields, ENC_BIG_ENDIAN);
         offset += 2;
+        tap_queue_packet(s7comm_alarm_tap, pinfo, alarm_tap);
     }
     proto_item_set_len(msg_item_tree, offset - start_offset);
     return offset;
@@ -2283,6 +3087,9 @@ s7comm_decode_ud_cpu_alarm_acknowledge(tvbuff_t *tvb,
         offset += 4;
         proto_item_append_text(msg_item_tree, ": EventID=0x%08x", ev_id);
         col_append_fstr(pinfo->cinfo, COL_INFO, " EV_ID=0x%08x", ev_id);
+        /* The acknowledge is requested by the HMI, the PLC responds */
+        s7comm_alarmcache_add_to_tree(tvb, pinfo, msg_item_tree,
+            (type == S7COMM_UD_TYPE_REQ) ? &pinfo->dst : &pinfo->src, ev_id);
         proto_tree_add_bitmask(msg_item_tree, tvb, offset, hf_s7comm_cpu_alarm_message_ackstate,
             ett_s7comm_cpu_alarm_message_ackstate, s7comm_cpu_alarm_message_ackstate_fields, ENC_BIG_ENDIAN);
         offset += 2;
@@ -2314,6 +3121,8 @@ s7comm_decode_ud_cpu_alarm_query(tvbuff_t *tvb,
     guint8 spec;
     guint8 returncode;
     guint16 alarmtype;
+    guint32 value_offset;
+    nstime_t coming;
 
     start_offset = offset;
     msg_item = proto_tree_add_item(data_tree, hf_s7comm_cpu_alarm_message_item, tvb, offset, 0, ENC_NA);
@@ -2392,16 +3201,22 @@ s7comm_decode_ud_cpu_alarm_query(tvbuff_t *tvb,
                 offset += 2;
 
                 /* 8 bytes timestamp (coming?)*/
-                offset = s7comm_add_timestamp_to_tree(tvb, msg_item_tree, offset, FALSE, FALSE);
+                offset = s7comm_add_timestamp_to_tree(tvb, msg_item_tree, offset, FALSE, FALSE, &coming);
 
                 /* Begleitwert */
-                offset = s7comm_decode_response_read_data(tvb, msg_item_tree, 1, offset);
+                value_offset = offset;
+                offset = s7comm_decode_response_read_data(tvb, msg_item_tree, 1, NULL, NULL, offset);
+                /* keep the alarm for later indications, without the 4 bytes header and a fill byte of the value */
+                if (offset >= value_offset + 4) {
+                    s7comm_alarmcache_store(pinfo, ev_id, &coming, tvb, value_offset + 4,
+                        MIN(offset - value_offset - 4, s7comm_get_data_item_len(tvb, value_offset)));
+                }
 
                 /* 8 bytes timestamp (coming?)*/
-                offset = s7comm_add_timestamp_to_tree(tvb, msg_item_tree, offset, FALSE, FALSE);
+                offset = s7comm_add_timestamp_to_tree(tvb, msg_item_tree, offset, FALSE, FALSE, NULL);
 
                 /* Begleitwert */
-                offset = s7comm_decode_response_read_data(tvb, msg_item_tree, 1, offset);
+                offset = s7comm_decode_response_read_data(tvb, msg_item_tree, 1, NULL, NULL, offset);
     /* ENDE DATENSATZ */
             }
         }
@@ -2417,6 +3232,7 @@ s7comm_decode_ud_cpu_alarm_query(tvbuff_t *tvb,
  *******************************************************************************************************/
 static guint32
 s7comm_decode_ud_time_subfunc(tvbuff_t *tvb,
+                                    packet_info *pinfo,
                                     proto_tree *data_tree,
                                     guint8 type,                /* Type of data (request/response) */
                                     guint8 subfunc,             /* Subfunction */
@@ -2425,6 +3241,7 @@ s7comm_decode_ud_time_subfunc(tvbuff_t *tvb,
                                     guint32 offset)             /* Offset on data part +4 */
 {
     gboolean know_data = FALSE;
+    nstime_t ts;
 
     switch (subfunc) {
         case S7COMM_UD_SUBF_TIME_READ:
@@ -2432,7 +3249,7 @@ s7comm_decode_ud_time_subfunc(tvbuff_t *tvb,
             if (type == S7COMM_UD_TYPE_RES) {                   /*** Response ***/
                 if (ret_val == S7COMM_ITEM_RETVAL_DATA_OK) {
                     proto_item_append_text(data_tree, ": ");
-                    offset = s7comm_add_timestamp_to_tree(tvb, data_tree, offset, TRUE, TRUE);
+                    offset = s7comm_add_timestamp_to_tree(tvb, data_tree, offset, TRUE, TRUE, NULL);
                 }
                 know_data = TRUE;
             }
@@ -2442,7 +3259,10 @@ s7comm_decode_ud_time_subfunc(tvbuff_t *tvb,
             if (type == S7COMM_UD_TYPE_REQ) {                   /*** Request ***/
                 if (ret_val == S7COMM_ITEM_RETVAL_DATA_OK) {
                     proto_item_append_text(data_tree, ": ");
-                    offset = s7comm_add_timestamp_to_tree(tvb, data_tree, offset, TRUE, TRUE);
+                    offset = s7comm_add_timestamp_to_tree(tvb, data_tree, offset, TRUE, TRUE, &ts);
+                    if (have_tap_listener(s7comm_audit_tap)) {
+                        s7comm_queue_audit(pinfo, "Set time", abs_time_to_ep_str(&ts, ABSOLUTE_TIME_LOCAL, FALSE), NULL);
+                    }
                 }
                 know_data = TRUE;
             }
@@ -2486,6 +3306,12 @@ s7comm_decode_ud_block_subfunc(tvbuff_t *tvb,
     char str_timestamp[30];
     char str_number[10];
     char str_version[10];
+    guint32 info_offset;
+    s7comm_block_tap_t *block_tap;
+    s7comm_block_tap_info_t *block;
+
+    block_tap = wmem_new0(wmem_packet_scope(), s7comm_block_tap_t);
+    block_tap->subfunc = subfunc;
 
     switch (subfunc) {
         /*************************************************
@@ -2497,17 +3323,24 @@ s7comm_decode_ud_block_subfunc(tvbuff_t *tvb,
 
             } else if (type == S7COMM_UD_TYPE_RES) {                /*** Response ***/
                 count = len / 4;
+                block_tap->count = count;
+                block_tap->blocks = wmem_alloc0_array(wmem_packet_scope(), s7comm_block_tap_info_t, count);
                 for(i = 0; i < count; i++) {
                     /* Insert a new tree of 4 byte length for every item */
                     item = proto_tree_add_item(data_tree, hf_s7comm_data_item, tvb, offset, 4, ENC_NA);
                     item_tree = proto_item_add_subtree(item, ett_s7comm_data_item);
                     offset += 1; /* skip first byte */
                     proto_item_append_text(item, " [%d]: (Block type %s)", i+1, val_to_str(tvb_get_guint8(tvb, offset), blocktype_names, "Unknown Block type: 0x%02x"));
+                    block = &block_tap->blocks[i];
+                    block->block_type = tvb_get_guint8(tvb, offset);
+                    block->type_name = val_to_str_const(block->block_type, blocktype_names, "?");
                     proto_tree_add_item(item_tree, hf_s7comm_ud_blockinfo_block_type, tvb, offset, 1, ENC_BIG_ENDIAN);
                     offset += 1;
+                    block->number = tvb_get_ntohs(tvb, offset);
                     proto_tree_add_item(item_tree, hf_s7comm_ud_blockinfo_block_cnt, tvb, offset, 2, ENC_BIG_ENDIAN);
                     offset += 2;
                 }
+                tap_queue_packet(s7comm_block_tap, pinfo, block_tap);
                 know_data = TRUE;
             }
             break;
@@ -2518,6 +3351,7 @@ s7comm_decode_ud_block_subfunc(tvbuff_t *tvb,
             if (type == S7COMM_UD_TYPE_REQ) {                       /*** Request ***/
                 if (tsize != S7COMM_DATA_TRANSPORT_SIZE_NULL) {
                     offset += 1; /* skip first byte */
+                    s7comm_store_listtype_request(pinfo, tvb_get_guint8(tvb, offset));
                     proto_tree_add_item(data_tree, hf_s7comm_ud_blockinfo_block_type, tvb, offset, 1, ENC_BIG_ENDIAN);
                     col_append_fstr(pinfo->cinfo, COL_INFO, " Type:[%s]",
                         val_to_str(tvb_get_guint8(tvb, offset), blocktype_names, "Unknown Block type: 0x%02x"));
@@ -2530,12 +3364,26 @@ s7comm_decode_ud_block_subfunc(tvbuff_t *tvb,
             }else if (type == S7COMM_UD_TYPE_RES) {                 /*** Response ***/
                 if (tsize != S7COMM_DATA_TRANSPORT_SIZE_NULL) {
                     count = len / 4;
+                    blocktype = s7comm_get_listtype_request(pinfo);
+                    if (blocktype != 0) {
+                        item = proto_tree_add_uint(data_tree, hf_s7comm_ud_blockinfo_block_type, tvb, 0, 0, blocktype);
+                        PROTO_ITEM_SET_GENERATED(item);
+                    }
+                    block_tap->count = count;
+                    block_tap->blocks = wmem_alloc0_array(wmem_packet_scope(), s7comm_block_tap_info_t, count);
 
                     for(i = 0; i < count; i++) {
                         /* Insert a new tree of 4 byte length for every item */
                         item = proto_tree_add_item(data_tree, hf_s7comm_data_item, tvb, offset, 4, ENC_NA);
                         item_tree = proto_item_add_subtree(item, ett_s7comm_data_item);
 
+                        block = &block_tap->blocks[i];
+                        block->block_type = blocktype;
+                        block->type_name = val_to_str_const(blocktype, blocktype_names, "?");
+                        block->number = tvb_get_ntohs(tvb, offset);
+                        block->flags = tvb_get_guint8(tvb, offset + 2);
+                        block->lang = tvb_get_guint8(tvb, offset + 3);
+                        block->lang_name = val_to_str_const(block->lang, blocklanguage_names, "?");
                         proto_item_append_text(item, " [%d]: (Block number %d)", i+1, tvb_get_ntohs(tvb, offset));
                         proto_tree_add_item(item_tree, hf_s7comm_ud_blockinfo_block_num, tvb, offset, 2, ENC_BIG_ENDIAN);
                         offset += 2;
@@ -2545,6 +3393,10 @@ s7comm_decode_ud_block_subfunc(tvbuff_t *tvb,
                         proto_tree_add_item(item_tree, hf_s7comm_ud_blockinfo_block_lang, tvb, offset, 1, ENC_BIG_ENDIAN);
                         offset += 1;
                     }
+                    /* without the type of the request the blocks can't be listed */
+                    if (blocktype != 0) {
+                        tap_queue_packet(s7comm_block_tap, pinfo, block_tap);
+                    }
                 }
                 know_data = TRUE;
             }
@@ -2577,6 +3429,10 @@ s7comm_decode_ud_block_subfunc(tvbuff_t *tvb,
             }else if (type == S7COMM_UD_TYPE_RES) {             /*** Response ***/
                 /* 78 Bytes */
                 if (ret_val == S7COMM_ITEM_RETVAL_DATA_OK) {
+                    block_tap->count = 1;
+                    block = block_tap->blocks = wmem_new0(wmem_packet_scope(), s7comm_block_tap_info_t);
+                    block->has_info = TRUE;
+                    info_offset = offset;
                     proto_tree_add_item(data_tree, hf_s7comm_ud_blockinfo_res_const1, tvb, offset, 1, ENC_BIG_ENDIAN);
                     offset += 1;
                     proto_tree_add_item(data_tree, hf_s7comm_ud_blockinfo_block_type, tvb, offset, 1, ENC_BIG_ENDIAN);
@@ -2602,10 +3458,15 @@ s7comm_decode_ud_block_subfunc(tvbuff_t *tvb,
 
                     proto_tree_add_bitmask(data_tree, tvb, offset, hf_s7comm_userdata_blockinfo_flags,
                         ett_s7comm_userdata_blockinfo_flags, s7comm_userdata_blockinfo_flags_fields, ENC_BIG_ENDIAN);
+                    block->flags = tvb_get_guint8(tvb, offset);
                     offset += 1;
+                    block->lang = tvb_get_guint8(tvb, offset);
+                    block->lang_name = val_to_str_const(block->lang, blocklanguage_names, "?");
                     proto_tree_add_item(data_tree, hf_s7comm_ud_blockinfo_block_lang, tvb, offset, 1, ENC_BIG_ENDIAN);
                     offset += 1;
                     blocktype = tvb_get_guint8(tvb, offset);
+                    block->block_type = s7comm_get_blocktype_from_subblktype(blocktype);
+                    block->type_name = val_to_str_const(blocktype, subblktype_names, "?");
                     proto_tree_add_item(data_tree, hf_s7comm_ud_blockinfo_subblk_type, tvb, offset, 1, ENC_BIG_ENDIAN);
                     /* Add block type and number to info column */
                     col_append_fstr(pinfo->cinfo, COL_INFO, " Type:[%s]",
@@ -2614,47 +3475,66 @@ s7comm_decode_ud_block_subfunc(tvbuff_t *tvb,
                         val_to_str(blocktype, subblktype_names, "Unknown Subblk type: 0x%02x"));
                     offset += 1;
                     blocknumber = tvb_get_ntohs(tvb, offset);
+                    block->number = blocknumber;
                     proto_tree_add_uint(data_tree, hf_s7comm_ud_blockinfo_block_num, tvb, offset, 2, blocknumber);
                     g_snprintf(str_number, sizeof(str_number), "%05d", blocknumber);
                     col_append_fstr(pinfo->cinfo, COL_INFO, " No.:[%s]", str_number);
                     proto_item_append_text(data_tree, ", Number: %05d)", blocknumber);
                     offset += 2;
                     /* "Length Load mem" -> the length in Step7 Manager seems to be this length +6 bytes */
+                    block->load_mem_len = tvb_get_ntohl(tvb, offset);
                     proto_tree_add_item(data_tree, hf_s7comm_ud_blockinfo_load_mem_len, tvb, offset, 4, ENC_BIG_ENDIAN);
                     offset += 4;
+                    block->security = tvb_get_ntohl(tvb, offset);
                     proto_tree_add_item(data_tree, hf_s7comm_ud_blockinfo_blocksecurity, tvb, offset, 4, ENC_BIG_ENDIAN);
                     offset += 4;
                     s7comm_get_timestring_from_s7time(tvb, offset, str_timestamp, sizeof(str_timestamp));
+                    block->code_timestamp = wmem_strdup(wmem_packet_scope(), str_timestamp);
                     proto_tree_add_string(data_tree, hf_s7comm_ud_blockinfo_code_timestamp, tvb, offset, 6, str_timestamp);
                     offset += 6;
                     s7comm_get_timestring_from_s7time(tvb, offset, str_timestamp, sizeof(str_timestamp));
+                    block->interface_timestamp = wmem_strdup(wmem_packet_scope(), str_timestamp);
                     proto_tree_add_string(data_tree, hf_s7comm_ud_blockinfo_interface_timestamp, tvb, offset, 6, str_timestamp);
                     offset += 6;
+                    block->ssb_len = tvb_get_ntohs(tvb, offset);
                     proto_tree_add_item(data_tree, hf_s7comm_ud_blockinfo_ssb_len, tvb, offset, 2, ENC_BIG_ENDIAN);
                     offset += 2;
+                    block->add_len = tvb_get_ntohs(tvb, offset);
                     proto_tree_add_item(data_tree, hf_s7comm_ud_blockinfo_add_len, tvb, offset, 2, ENC_BIG_ENDIAN);
                     offset += 2;
+                    block->localdata_len = tvb_get_ntohs(tvb, offset);
                     proto_tree_add_item(data_tree, hf_s7comm_ud_blockinfo_localdata_len, tvb, offset, 2, ENC_BIG_ENDIAN);
                     offset += 2;
+                    block->mc7_len = tvb_get_ntohs(tvb, offset);
                     proto_tree_add_item(data_tree, hf_s7comm_ud_blockinfo_mc7_len, tvb, offset, 2, ENC_BIG_ENDIAN);
                     offset += 2;
+                    block->author = (const gchar *)tvb_get_string_enc(wmem_packet_scope(), tvb, offset, 8, ENC_ASCII);
                     proto_tree_add_item(data_tree, hf_s7comm_ud_blockinfo_author, tvb, offset, 8, ENC_ASCII|ENC_NA);
                     offset += 8;
+                    block->family = (const gchar *)tvb_get_string_enc(wmem_packet_scope(), tvb, offset, 8, ENC_ASCII);
                     proto_tree_add_item(data_tree, hf_s7comm_ud_blockinfo_family, tvb, offset, 8, ENC_ASCII|ENC_NA);
                     offset += 8;
+                    block->name = (const gchar *)tvb_get_string_enc(wmem_packet_scope(), tvb, offset, 8, ENC_ASCII);
                     proto_tree_add_item(data_tree, hf_s7comm_ud_blockinfo_headername, tvb, offset, 8, ENC_ASCII|ENC_NA);
                     offset += 8;
                     g_snprintf(str_version, sizeof(str_version), "%d.%d", ((tvb_get_guint8(tvb, offset) & 0xf0) >> 4), tvb_get_guint8(tvb, offset) & 0x0f);
+                    block->version = wmem_strdup(wmem_packet_scope(), str_version);
                     proto_tree_add_string(data_tree, hf_s7comm_ud_blockinfo_headerversion, tvb, offset, 1, str_version);
                     offset += 1;
                     proto_tree_add_item(data_tree, hf_s7comm_ud_blockinfo_res_unknown, tvb, offset, 1, ENC_NA);
                     offset += 1;
+                    block->checksum = tvb_get_ntohs(tvb, offset);
                     proto_tree_add_item(data_tree, hf_s7comm_ud_blockinfo_checksum, tvb, offset, 2, ENC_BIG_ENDIAN);
                     offset += 2;
                     proto_tree_add_item(data_tree, hf_s7comm_ud_blockinfo_reserved1, tvb, offset, 4, ENC_BIG_ENDIAN);
                     offset += 4;
                     proto_tree_add_item(data_tree, hf_s7comm_ud_blockinfo_reserved2, tvb, offset, 4, ENC_BIG_ENDIAN);
                     offset += 4;
+                    /* a CRC over all of the info, so that changes of a block are found by comparing one value */
+                    block->info_crc = crc32_ccitt_tvb_offset(tvb, info_offset, offset - info_offset);
+                    if (block->block_type != 0) {
+                        tap_queue_packet(s7comm_block_tap, pinfo, block_tap);
+                    }
                 }
                 know_data = TRUE;
             }
@@ -2676,6 +3556,7 @@ s7comm_decode_ud_block_subfunc(tvbuff_t *tvb,
  *******************************************************************************************************/
 static guint32
 s7comm_decode_ud_cyclic_subfunc(tvbuff_t *tvb,
+                                    packet_info *pinfo,
                                     proto_tree *data_tree,
                                     guint8 type,                /* Type of data (request/response) */
                                     guint8 subfunc,             /* Subfunction */
@@ -2683,10 +3564,8 @@ s7comm_decode_ud_cyclic_subfunc(tvbuff_t *tvb,
                                     guint32 offset)             /* Offset on data part +4 */
 {
     gboolean know_data = FALSE;
-    guint32 offset_old;
-    guint32 len_item;
     guint8 item_count;
-    guint8 i;
+    s7comm_s7any_item_t items[G_MAXUINT8];
 
     switch (subfunc)
     {
@@ -2700,19 +3579,14 @@ s7comm_decode_ud_cyclic_subfunc(tvbuff_t *tvb,
                 proto_tree_add_item(data_tree, hf_s7comm_cycl_interval_time, tvb, offset, 1, ENC_BIG_ENDIAN);
                 offset += 1;
                 /* parse item data */
-                for (i = 0; i < item_count; i++) {
-                    offset_old = offset;
-                    offset = s7comm_decode_param_item(tvb, offset, data_tree, i);
-                    /* if length is not a multiple of 2 and this is not the last item, then add a fill-byte */
-                    len_item = offset - offset_old;
-                    if ((len_item % 2) && (i < item_count)) {
-                        offset += 1;
-                    }
-                }
+                offset = s7comm_decode_param_item_list(tvb, offset, data_tree, item_count, items);
+                s7comm_store_job_items(pinfo, 0, S7COMM_JOB_CYCLIC, item_count, items);
 
             } else if (type == S7COMM_UD_TYPE_RES || type == S7COMM_UD_TYPE_PUSH) {   /* Response from PLC with the requested data */
                 /* parse item data */
-                offset = s7comm_decode_response_read_data(tvb, data_tree, item_count, offset);
+                offset = s7comm_decode_response_read_data(tvb, data_tree, item_count,
+                    s7comm_get_job_items(pinfo, 0, S7COMM_JOB_CYCLIC, item_count),
+                    s7comm_shadow_get_plc(pinfo, &pinfo->src), offset);
             }
             know_data = TRUE;
             break;
@@ -2732,6 +3606,7 @@ s7comm_decode_ud_cyclic_subfunc(tvbuff_t *tvb,
  *******************************************************************************************************/
 static guint32
 s7comm_decode_ud_prog_subfunc(tvbuff_t *tvb,
+                                    packet_info *pinfo,
                                     proto_tree *data_tree,
                                     guint8 type,                /* Type of data (request/response) */
                                     guint8 subfunc,             /* Subfunction */
@@ -2744,6 +3619,10 @@ s7comm_decode_ud_prog_subfunc(tvbuff_t *tvb,
     guint16 byte_count;
     guint16 item_count;
     guint16 i;
+    s7comm_s7any_item_t items[G_MAXUINT8];
+    s7comm_s7any_item_t unused_item;
+    const s7comm_s7any_item_t *job_items;
+    s7comm_shadow_plc_t *shadow;
 
     switch(subfunc)
     {
@@ -2784,7 +3663,11 @@ s7comm_decode_ud_prog_subfunc(tvbuff_t *tvb,
 
                     /* parse item data */
                     for (i = 0; i < item_count; i++) {
-                        offset = s7comm_decode_ud_prog_vartab_req_item(tvb, offset, data_tree, i);
+                        offset = s7comm_decode_ud_prog_vartab_req_item(tvb, offset, data_tree, i,
+                            (i < G_MAXUINT8) ? &items[i] : &unused_item);
+                    }
+                    if (item_count <= G_MAXUINT8) {
+                        s7comm_store_job_items(pinfo, 0, S7COMM_JOB_VARTAB, (guint8)item_count, items);
                     }
                     know_data = TRUE;
                     break;
@@ -2801,8 +3684,14 @@ s7comm_decode_ud_prog_subfunc(tvbuff_t *tvb,
                     offset += 2;
 
                     /* parse item data */
+                    job_items = NULL;
+                    if (item_count <= G_MAXUINT8) {
+                        job_items = s7comm_get_job_items(pinfo, 0, S7COMM_JOB_VARTAB, (guint8)item_count);
+                    }
+                    shadow = s7comm_shadow_get_plc(pinfo, &pinfo->src);
                     for (i = 0; i < item_count; i++) {
-                        offset = s7comm_decode_ud_prog_vartab_res_item(tvb, offset, data_tree, i);
+                        offset = s7comm_decode_ud_prog_vartab_res_item(tvb, offset, data_tree, i,
+                            (job_items != NULL) ? &job_items[i] : NULL, shadow);
                     }
                     know_data = TRUE;
                     break;
@@ -2967,10 +3856,10 @@ s7comm_decode_ud(tvbuff_t *tvb,
         if (dlength > 4) {
             switch (funcgroup){
                 case S7COMM_UD_FUNCGROUP_PROG:
-                    offset = s7comm_decode_ud_prog_subfunc(tvb, data_tree, type, subfunc, dlength, offset);
+                    offset = s7comm_decode_ud_prog_subfunc(tvb, pinfo, data_tree, type, subfunc, dlength, offset);
                     break;
                 case S7COMM_UD_FUNCGROUP_CYCLIC:
-                    offset = s7comm_decode_ud_cyclic_subfunc(tvb, data_tree, type, subfunc, dlength, offset);
+                    offset = s7comm_decode_ud_cyclic_subfunc(tvb, pinfo, data_tree, type, subfunc, dlength, offset);
                     break;
                 case S7COMM_UD_FUNCGROUP_BLOCK:
                     offset = s7comm_decode_ud_block_subfunc(tvb, pinfo, data_tree, type, subfunc, ret_val, tsize, len, dlength, offset);
@@ -2994,10 +3883,10 @@ s7comm_decode_ud(tvbuff_t *tvb,
                     offset = s7comm_decode_ud_security_subfunc(tvb, data_tree, dlength, offset);
                     break;
                 case S7COMM_UD_FUNCGROUP_PBC:
-                    offset = s7comm_decode_ud_pbc_subfunc(tvb, data_tree, dlength, offset);
+                    offset = s7comm_decode_ud_pbc_subfunc(tvb, pinfo, data_tree, last_data_unit, dlength, offset);
                     break;
                 case S7COMM_UD_FUNCGROUP_TIME:
-                    offset = s7comm_decode_ud_time_subfunc(tvb, data_tree, type, subfunc, ret_val, dlength, offset);
+                    offset = s7comm_decode_ud_time_subfunc(tvb, pinfo, data_tree, type, subfunc, ret_val, dlength, offset);
                     break;
                 default:
                     break;
@@ -3020,16 +3909,15 @@ s7comm_decode_req_resp(tvbuff_t *tvb,
                       guint16 plength,
                       guint16 dlength,
                       guint32 offset,
-                      guint8 rosctr)
+                      guint8 rosctr,
+                      guint16 pduref)
 {
     proto_item *item = NULL;
     proto_tree *param_tree = NULL;
     proto_tree *data_tree = NULL;
     guint8 function = 0;
     guint8 item_count = 0;
-    guint8 i;
-    guint32 offset_old;
-    guint32 len;
+    s7comm_s7any_item_t items[G_MAXUINT8];
 
     if (plength > 0) {
         /* Add parameter tree */
@@ -3052,21 +3940,20 @@ s7comm_decode_req_resp(tvbuff_t *tvb,
                     proto_tree_add_uint(param_tree, hf_s7comm_param_itemcount, tvb, offset, 1, item_count);
                     offset += 1;
                     /* parse item data */
-                    for (i = 0; i < item_count; i++) {
-                        offset_old = offset;
-                        offset = s7comm_decode_param_item(tvb, offset, param_tree, i);
-                        /* if length is not a multiple of 2 and this is not the last item, then add a fill-byte */
-                        len = offset - offset_old;
-                        if ((len % 2) && (i < item_count)) {
-                            offset += 1;
-                        }
+                    offset = s7comm_decode_param_item_list(tvb, offset, param_tree, item_count, items);
+                    s7comm_store_job_items(pinfo, pduref, S7COMM_JOB_READWRITE, item_count, items);
+                    if (function == S7COMM_SERV_READVAR) {
+                        s7comm_add_shadow_values_to_tree(tvb, pinfo, param_tree, item_count, items);
+                    } else if (have_tap_listener(s7comm_audit_tap)) {
+                        s7comm_audit_writevar(pinfo, item_count, items);
                     }
                     /* in write-function there is a data part */
                     if ((function == S7COMM_SERV_WRITEVAR) && (dlength > 0)) {
                         item = proto_tree_add_item(tree, hf_s7comm_data, tvb, offset, dlength, ENC_NA);
                         data_tree = proto_item_add_subtree(item, ett_s7comm_data);
                         /* Add returned data to data-tree */
-                        offset = s7comm_decode_response_read_data(tvb, data_tree, item_count, offset);
+                        offset = s7comm_decode_response_read_data(tvb, data_tree, item_count, items,
+                            s7comm_shadow_get_plc(pinfo, &pinfo->dst), offset);
                     }
                     break;
                 case S7COMM_SERV_SETUPCOMM:
@@ -3085,7 +3972,7 @@ s7comm_decode_req_resp(tvbuff_t *tvb,
                     offset = s7comm_decode_plc_controls_param_hex28(tvb, pinfo, param_tree, offset -1);
                     break;
                 case S7COMM_FUNC_PLC_STOP:
-                    offset = s7comm_decode_plc_controls_param_hex29(tvb, param_tree, offset -1);
+                    offset = s7comm_decode_plc_controls_param_hex29(tvb, pinfo, param_tree, offset -1);
                     break;
 
                 default:
@@ -3119,15 +4006,28 @@ s7comm_decode_req_resp(tvbuff_t *tvb,
                     data_tree = proto_item_add_subtree(item, ett_s7comm_data);
                     /* Add returned data to data-tree */
                     if ((function == S7COMM_SERV_READVAR) && (dlength > 0)) {
-                        offset = s7comm_decode_response_read_data(tvb, data_tree, item_count, offset);
+                        offset = s7comm_decode_response_read_data(tvb, data_tree, item_count,
+                            s7comm_get_job_items(pinfo, pduref, S7COMM_JOB_READWRITE, item_count),
+                            s7comm_shadow_get_plc(pinfo, &pinfo->src), offset);
                     } else if ((function == S7COMM_SERV_WRITEVAR) && (dlength > 0)) {
                         offset = s7comm_decode_response_write_data(tvb, data_tree, item_count, offset);
                     }
                     break;
                 case S7COMM_SERV_SETUPCOMM:
+                    if (have_tap_listener(s7comm_transfer_tap)) {
+                        /* the negotiated PDU length is after reserved byte and max AmQ calling/called */
+                        s7comm_queue_transfer(pinfo, S7COMM_TRANSFER_SETUP, tvb_get_ntohs(tvb, offset + 5), 0);
+                    }
                     offset = s7comm_decode_pdu_setup_communication(tvb, param_tree, offset);
                     break;
                 default:
+                    /* The block data of a transfer, the data part begins with its length */
+                    if ((function == S7COMM_FUNCDOWNLOADBLOCK || function == S7COMM_FUNCUPLOAD) && dlength >= 2
+                            && have_tap_listener(s7comm_transfer_tap)) {
+                        s7comm_queue_transfer(pinfo,
+                            (function == S7COMM_FUNCDOWNLOADBLOCK) ? S7COMM_TRANSFER_DOWNLOAD_DATA : S7COMM_TRANSFER_UPLOAD_DATA,
+                            0, tvb_get_ntohs(tvb, offset + plength - 1));
+                    }
                     /* Print unknown part as raw bytes */
                     if (plength > 1) {
                         proto_tree_add_item(param_tree, hf_s7comm_param_data, tvb, offset, plength - 1, ENC_NA);
@@ -3174,6 +4074,7 @@ dissect_s7comm(tvbuff_t *tvb,
     guint8 hlength = 10;                /* Header 10 Bytes, when type 2 or 3 (Response) -> 12 Bytes */
     guint16 plength = 0;
     guint16 dlength = 0;
+    guint16 pduref = 0;
 
     /*----------------- Heuristic Checks - Begin */
     /* 1) check for minimum length */
@@ -3189,6 +4090,7 @@ dissect_s7comm(tvbuff_t *tvb,
 
     col_set_str(pinfo->cinfo, COL_PROTOCOL, PROTO_TAG_S7COMM);
     col_clear(pinfo->cinfo, COL_INFO);
+    s7comm_count_pdu(pinfo);
 
     rosctr = tvb_get_guint8(tvb, 1);                            /* Get the type byte */
     if (rosctr == 2 || rosctr == 3) hlength = 12;               /* Header 10 Bytes, when type 2 or 3 (response) -> 12 Bytes */
@@ -3219,7 +4121,8 @@ dissect_s7comm(tvbuff_t *tvb,
     proto_tree_add_item(s7comm_header_tree, hf_s7comm_header_redid, tvb, offset, 2, ENC_BIG_ENDIAN);
     offset += 2;
     /* Protocol Data Unit Reference */
-    proto_tree_add_item(s7comm_header_tree, hf_s7comm_header_pduref, tvb, offset, 2, ENC_BIG_ENDIAN);
+    pduref = tvb_get_ntohs(tvb, offset);
+    proto_tree_add_uint(s7comm_header_tree, hf_s7comm_header_pduref, tvb, offset, 2, pduref);
     offset += 2;
     /* Parameter length */
     plength = tvb_get_ntohs(tvb, offset);
@@ -3240,7 +4143,7 @@ dissect_s7comm(tvbuff_t *tvb,
     switch (rosctr) {
         case S7COMM_ROSCTR_JOB:
         case S7COMM_ROSCTR_ACK_DATA:
-            s7comm_decode_req_resp(tvb, pinfo, s7comm_tree, plength, dlength, offset, rosctr);
+            s7comm_decode_req_resp(tvb, pinfo, s7comm_tree, plength, dlength, offset, rosctr, pduref);
             break;
         case S7COMM_ROSCTR_USERDATA:
             s7comm_decode_ud(tvb, pinfo, s7comm_tree, plength, dlength, offset);
@@ -3251,11 +4154,26 @@ dissect_s7comm(tvbuff_t *tvb,
     return TRUE;
 }
 
+/*******************************************************************************************************
+ *
+ * (Re)load the files given in the preferences
+ *
+ *******************************************************************************************************/
+static void
+s7comm_apply_prefs(void)
+{
+    s7comm_load_dblayout(s7comm_dblayout_filename);
+    s7comm_load_symbols(s7comm_symbols_filename);
+    s7comm_load_nck_catalog(s7comm_nck_catalog_filename);
+}
+
 /*******************************************************************************************************
  *******************************************************************************************************/
 void
 proto_register_s7comm (void)
 {
+    module_t *s7comm_module;
+
     /* format:
      * {&(field id), {name, abbrev, type, display, strings, bitmask, blurb, HFILL}}.
      */
@@ -3354,6 +4272,12 @@ proto_register_s7comm (void)
         { &hf_s7comm_item_address_nr,
         { "Number (T/C/BLOCK)", "s7comm.param.item.address.number", FT_UINT24, BASE_DEC, NULL, 0x00ffff,
           NULL, HFILL }},
+        { &hf_s7comm_item_address_str,
+        { "Address", "s7comm.item.address", FT_STRING, BASE_NONE, NULL, 0x0,
+          "Full address of the item, e.g. DB10.DBX 4.0 BYTE 2", HFILL }},
+        { &hf_s7comm_item_symbol,
+        { "Symbol", "s7comm.item.symbol", FT_STRING, BASE_NONE, NULL, 0x0,
+          "Symbol of the address from the STEP 7 symbol table, the TIA DB layout file or the NCK catalog", HFILL }},
         /* Special variable read with Syntax-Id 0xb0 (DBREAD) */
         { &hf_s7comm_item_dbread_numareas,
         { "Number of areas", "s7comm.param.item.dbread.numareas", FT_UINT8, BASE_DEC, NULL, 0x0,
@@ -3933,7 +4857,37 @@ proto_register_s7comm (void)
 
     s7comm_register_szl_types(proto_s7comm);
 
+    s7comm_register_dblayout(proto_s7comm);
+
+    s7comm_register_nck(proto_s7comm);
+
     proto_register_subtree_array(ett, array_length (ett));
+
+    s7comm_alarm_tap = register_tap("s7comm_alarm");
+    s7comm_block_tap = register_tap("s7comm_block");
+    s7comm_audit_tap = register_tap("s7comm_audit");
+    s7comm_transfer_tap = register_tap("s7comm_transfer");
+
+    /* Register preferences */
+    s7comm_module = prefs_register_protocol(proto_s7comm, s7comm_apply_prefs);
+    prefs_register_filename_preference(s7comm_module, "dblayout_file",
+        "TIA DB layout file",
+        "XML export of the data blocks from TIA Portal. Tags of DBs with access by offset are shown in the read/write data, "
+        "S7-1200 symbolic addresses are resolved to the tag names",
+        &s7comm_dblayout_filename);
+    prefs_register_filename_preference(s7comm_module, "symbols_file",
+        "STEP 7 symbol table",
+        "Symbol table of a S7-300/400 exported from STEP 7 (ASCII or SDF). Symbols are shown beside the item addresses",
+        &s7comm_symbols_filename);
+    prefs_register_filename_preference(s7comm_module, "nck_catalog_file",
+        "Sinumerik NCK variable catalog",
+        "Text file with lines area;module;column;name;datatype. NCK variables are shown with their name, and the values in read responses",
+        &s7comm_nck_catalog_filename);
+
+    s7comm_register_shadow(proto_s7comm, s7comm_module);
+
+    s7comm_register_alarmcache(proto_s7comm, s7comm_module);
+    s7comm_register_pbc(proto_s7comm);
 }
 
 /* Register this protocol */
@@ -24,6 +24,36 @@
 #ifndef __PACKET_S7COMM_H__
 #define __PACKET_S7COMM_H__
 
+/**************************************************************************
+ * Areas of S7ANY addresses
+ */
+#define S7COMM_AREA_SYSINFO                 0x03        /* System info of 200 family */
+#define S7COMM_AREA_SYSFLAGS                0x05        /* System flags of 200 family */
+#define S7COMM_AREA_ANAIN                   0x06        /* analog inputs of 200 family */
+#define S7COMM_AREA_ANAOUT                  0x07        /* analog outputs of 200 family */
+#define S7COMM_AREA_P                       0x80        /* direct peripheral access */
+#define S7COMM_AREA_INPUTS                  0x81
+#define S7COMM_AREA_OUTPUTS                 0x82
+#define S7COMM_AREA_FLAGS                   0x83
+#define S7COMM_AREA_DB                      0x84        /* data blocks */
+#define S7COMM_AREA_DI                      0x85        /* instance data blocks */
+#define S7COMM_AREA_LOCAL                   0x86        /* local data (should not be accessible over network) */
+#define S7COMM_AREA_V                       0x87        /* previous (Vorgaenger) local data (should not be accessible over network)  */
+#define S7COMM_AREA_COUNTER                 28          /* S7 counters */
+#define S7COMM_AREA_TIMER                   29          /* S7 timers */
+#define S7COMM_AREA_COUNTER200              30          /* IEC counters (200 family) */
+#define S7COMM_AREA_TIMER200                31          /* IEC timers (200 family) */
+
+/**************************************************************************
+ * Flags for LID access of S7-1200 symbolic addresses
+ */
+#define S7COMM_TIA1200_VAR_ENCAPS_LID       0x2
+#define S7COMM_TIA1200_VAR_ENCAPS_IDX       0x3
+#define S7COMM_TIA1200_VAR_OBTAIN_LID       0x4
+#define S7COMM_TIA1200_VAR_OBTAIN_IDX       0x5
+#define S7COMM_TIA1200_VAR_PART_START       0x6
+#define S7COMM_TIA1200_VAR_PART_LEN         0x7
+
 /**************************************************************************
  * Returnvalues of an item response
  */
@@ -50,6 +80,24 @@
 #define S7COMM_UD_SUBF_CPU_ALARMACK         0x0b
 #define S7COMM_UD_SUBF_CPU_ALARMACK_IND     0x0c
 
+/**************************************************************************
+ * Block Types
+ */
+#define S7COMM_BLOCKTYPE_OB                 '8'
+#define S7COMM_BLOCKTYPE_DB                 'A'
+#define S7COMM_BLOCKTYPE_SDB                'B'
+#define S7COMM_BLOCKTYPE_FC                 'C'
+#define S7COMM_BLOCKTYPE_SFC                'D'
+#define S7COMM_BLOCKTYPE_FB                 'E'
+#define S7COMM_BLOCKTYPE_SFB                'F'
+
+/**************************************************************************
+ * Names of userdata subfunctions in group 3 (Block functions)
+ */
+#define S7COMM_UD_SUBF_BLOCK_LIST           0x01
+#define S7COMM_UD_SUBF_BLOCK_LISTTYPE       0x02
+#define S7COMM_UD_SUBF_BLOCK_BLOCKINFO      0x03
+
 /**************************************************************************
  * Names of types in userdata parameter part
  */
@@ -57,8 +105,159 @@
 #define S7COMM_UD_TYPE_REQ                  0x4
 #define S7COMM_UD_TYPE_RES                  0x8
 
+/**************************************************************************
+ * Keys of the data of a frame, the data of a PDU is kept with s7comm_add_pdu_data()
+ */
+#define S7COMM_PROTO_DATA_JOB               0           /* Items of the job of a response */
+#define S7COMM_PROTO_DATA_ALARM             1           /* Alarm from an alarm query */
+#define S7COMM_PROTO_DATA_BLOCKTYPE         2           /* Block type of the request to list blocks of a type */
+#define S7COMM_PROTO_DATA_PBC               3           /* Segment of a PBC transfer */
+#define S7COMM_PROTO_DATA_SZL               4           /* Following data unit of a SZL response */
+#define S7COMM_PROTO_DATA_PDU_COUNT         5           /* S7 PDUs dissected in the frame so far, packet scope */
+
+/**************************************************************************
+ * Data of an alarm indication, for the tap "s7comm_alarm"
+ */
+typedef struct {
+    guint8 subfunc;                         /* S7COMM_UD_SUBF_CPU_xxx_IND */
+    guint32 ev_id;
+    gboolean has_signalstate;               /* FALSE for acknowledge indications */
+    guint8 signalstate;                     /* Bit 0..7: SIG_1..SIG_8 */
+    guint16 ackstate;                       /* Bit 0..7: incoming, bit 8..15: outgoing SIG_1..SIG_8 acknowledged */
+} s7comm_alarm_tap_t;
+
+/**************************************************************************
+ * Blocks of a block list or block info response, for the tap "s7comm_block"
+ */
+typedef struct {
+    guint8 block_type;                      /* Block type as in block lists ('8' = OB, 'A' = DB, ...) */
+    const gchar *type_name;
+    guint16 number;                         /* Block number, in a block list the number of blocks of the type */
+    guint8 flags;
+    guint8 lang;
+    const gchar *lang_name;
+    gboolean has_info;                      /* The values below are from a block info */
+    guint32 load_mem_len;
+    guint32 security;
+    const gchar *code_timestamp;
+    const gchar *interface_timestamp;
+    guint16 ssb_len;
+    guint16 add_len;
+    guint16 localdata_len;
+    guint16 mc7_len;
+    const gchar *author;
+    const gchar *family;
+    const gchar *name;
+    const gchar *version;
+    guint16 checksum;
+    guint32 info_crc;                       /* CRC over the whole block info */
+} s7comm_block_tap_info_t;
+
+typedef struct {
+    guint8 subfunc;                         /* S7COMM_UD_SUBF_BLOCK_xxx */
+    guint16 count;
+    s7comm_block_tap_info_t *blocks;
+} s7comm_block_tap_t;
+
+/**************************************************************************
+ * Reassembled PBC (BSEND/BRCV) message, for the tap "s7comm_pbc_eo".
+ * The names are the same as of the export objects of other protocols.
+ */
+typedef struct {
+    guint32 pkt_num;
+    const gchar *hostname;                  /* Address of the sender */
+    const gchar *filename;
+    const gchar *content_type;
+    guint32 r_id;
+    guint32 payload_len;
+    const guint8 *payload_data;
+} s7comm_pbc_eo_t;
+
+/**************************************************************************
+ * PDU of a block upload or download, or the setup of the communication,
+ * for the tap "s7comm_transfer"
+ */
+#define S7COMM_TRANSFER_SETUP               0           /* Ack of setup communication with the PDU size */
+#define S7COMM_TRANSFER_DOWNLOAD_START      1           /* Request download, sent to the PLC */
+#define S7COMM_TRANSFER_DOWNLOAD_REQ        2           /* Download block, the PLC asks for the next data */
+#define S7COMM_TRANSFER_DOWNLOAD_DATA       3           /* Ack of download block with the data */
+#define S7COMM_TRANSFER_DOWNLOAD_END        4           /* Download ended, sent by the PLC */
+#define S7COMM_TRANSFER_UPLOAD_START        5
+#define S7COMM_TRANSFER_UPLOAD_REQ          6
+#define S7COMM_TRANSFER_UPLOAD_DATA         7
+#define S7COMM_TRANSFER_UPLOAD_END          8
+
+typedef struct {
+    guint8 kind;                            /* S7COMM_TRANSFER_xxx */
+    guint16 pdu_size;                       /* Negotiated PDU size of a setup communication */
+    const gchar *block;                     /* Block of a job, e.g. "DB 00010", NULL if not in the PDU */
+    guint32 loadmem_len;                    /* Announced lengths of a request download */
+    guint32 mc7_len;
+    guint32 data_len;                       /* Length of the block data of an ack */
+} s7comm_transfer_tap_t;
+
+/**************************************************************************
+ * Facts about a PLC from a SZL response, for the tap "s7comm_inventory".
+ * Only what the SZL-ID of the response contains is set.
+ */
+typedef struct {
+    guint16 id;                             /* SZL-ID and index of the response */
+    guint16 index;
+    const gchar *order_number;              /* xy11: module identification */
+    const gchar *hardware;                  /* xy11: version of the module */
+    const gchar *firmware;                  /* xy11: basic firmware */
+    guint16 max_pdu;                        /* 0131 index 0001, 0 if not in the response */
+    guint16 max_connections;
+    gboolean has_conn_status;               /* 0132 index 0001 */
+    guint16 used_connections;
+    guint16 protection_level;               /* 0132 index 0004, 0 if not in the response */
+    const gchar *mode_switch;
+    const gchar *mode;                      /* xy24: mode after the last mode transition */
+    wmem_strbuf_t *leds;                    /* xy74: LEDs which are on or flashing */
+} s7comm_inventory_tap_t;
+
+/**************************************************************************
+ * Events of a diagnostic buffer response (SZL-ID xyA0), for the tap "s7comm_diag"
+ */
+#define S7COMM_DIAG_RECORD_LEN              20
+
+typedef struct {
+    guint16 event_id;
+    const gchar *event_class;
+    guint8 priority;
+    guint8 ob;
+    guint16 dat_id;
+    guint16 info1;
+    guint32 info2;
+    nstime_t ts;                            /* Time stamp of the event in the PLC */
+    guint8 record[S7COMM_DIAG_RECORD_LEN];  /* The whole record, the same event is read again on every poll */
+} s7comm_diag_event_t;
+
+typedef struct {
+    guint16 count;
+    s7comm_diag_event_t *events;            /* Most recent event first, as in the response */
+} s7comm_diag_tap_t;
+
+/**************************************************************************
+ * A decoded data unit of a SZL response, for the tap "s7comm_szl"
+ */
+typedef struct {
+    guint16 id;
+    guint16 index;
+    guint16 count;                          /* Records in this PDU */
+    wmem_strbuf_t *records;                 /* The records as JSON objects, separated by commas */
+    guint32 conversation;                   /* Index of the conversation, with data_unit_ref the response */
+    guint8 data_unit_ref;
+    gboolean first_unit;                    /* The data unit with the header of the response */
+    gboolean more_units;                    /* Data units of the response follow */
+} s7comm_szl_tap_t;
+
 extern const value_string s7comm_item_return_valuenames[];
 
+void s7comm_add_pdu_data(packet_info *pinfo, int proto, guint32 kind, guint32 id, void *data);
+void *s7comm_get_pdu_data(packet_info *pinfo, int proto, guint32 kind, guint32 id);
+guint32 s7comm_add_timestamp_to_tree(tvbuff_t *tvb, proto_tree *tree, guint32 offset, gboolean append_text, gboolean has_ten_bytes, nstime_t *ts);
+
 #endif
 
 /*
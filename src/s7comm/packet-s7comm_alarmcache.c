@@ -0,0 +1,281 @@
+/* packet-s7comm_alarmcache.c
+ *
+ * Author:      Thomas Wiens, 2014 (th.wiens@gmx.de)
+ * Description: Wireshark dissector for S7-Communication
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**************************************************************************
+ * Cache of alarm query results
+ *
+ * The response of an alarm query lists the active alarms of a PLC with
+ * the timestamp and associated value of their coming. These are kept per
+ * PLC and EventID, so that later alarm indications and acknowledgements
+ * of the same EventID can show when the alarm was coming and its value.
+ *
+ * The cache is filled on the first pass. The number of EventIDs per PLC is
+ * limited by a preference, when the cache is full the least recently used
+ * EventID is dropped. What was found for a PDU and EventID is kept with the
+ * frame, so the later passes show the same, even if the entry was dropped since.
+ **************************************************************************/
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+#include <epan/packet.h>
+#include <epan/prefs.h>
+
+#include "packet-s7comm.h"
+#include "packet-s7comm_tap.h"
+#include "packet-s7comm_alarmcache.h"
+
+static gint ett_s7comm_alarmcache = -1;
+
+static gint hf_s7comm_alarmcache = -1;                      /* Alarm as known from an alarm query */
+static gint hf_s7comm_alarmcache_frame = -1;
+static gint hf_s7comm_alarmcache_coming = -1;
+static gint hf_s7comm_alarmcache_value = -1;
+
+/* Alarm of a query response, also used as data of a frame */
+typedef struct {
+    guint32 ev_id;
+    guint32 frame;                          /* Frame of the query response */
+    nstime_t coming;                        /* S7 timestamp of the coming */
+    guint32 value_len;
+    guint8 *value;                          /* Associated value of the coming */
+    GList *link;                            /* Entry in the LRU list of the PLC, not used for frame data */
+} s7comm_alarmcache_entry_t;
+
+typedef struct {
+    address addr;                           /* Address of the PLC, with own copy of the data */
+    GHashTable *alarms;                     /* EventID -> s7comm_alarmcache_entry_t */
+    GQueue *lru;                            /* Least recently used EventID first */
+} s7comm_alarmcache_plc_t;
+
+/* Address of the PLC -> s7comm_alarmcache_plc_t */
+static GHashTable *s7comm_alarmcache_plcs = NULL;
+static guint s7comm_alarmcache_max_entries = 1000;
+
+static int proto_s7comm_alarmcache = -1;
+
+static void
+s7comm_alarmcache_free_entry(gpointer data)
+{
+    s7comm_alarmcache_entry_t *entry = (s7comm_alarmcache_entry_t *)data;
+
+    g_free(entry->value);
+    g_free(entry);
+}
+
+static void
+s7comm_alarmcache_free_plc(gpointer data)
+{
+    s7comm_alarmcache_plc_t *plc = (s7comm_alarmcache_plc_t *)data;
+
+    g_queue_free(plc->lru);
+    g_hash_table_destroy(plc->alarms);
+    g_free((gpointer)plc->addr.data);
+    g_free(plc);
+}
+
+/*******************************************************************************************************
+ *
+ * Called at the start of every capture file, drops the cache of all PLCs
+ *
+ *******************************************************************************************************/
+static void
+s7comm_alarmcache_init(void)
+{
+    if (s7comm_alarmcache_plcs != NULL) {
+        g_hash_table_destroy(s7comm_alarmcache_plcs);
+    }
+    s7comm_alarmcache_plcs = g_hash_table_new_full(s7comm_tap_addr_hash, s7comm_tap_addr_equal,
+        NULL, s7comm_alarmcache_free_plc);
+}
+
+/*******************************************************************************************************
+ *
+ * Store an alarm from the response of an alarm query, sent by the PLC in pinfo->src.
+ * value is the data of the associated value, len bytes at offset.
+ *
+ *******************************************************************************************************/
+void
+s7comm_alarmcache_store(packet_info *pinfo,
+                        guint32 ev_id,
+                        const nstime_t *coming,
+                        tvbuff_t *tvb,
+                        guint32 offset,
+                        guint32 len)
+{
+    s7comm_alarmcache_plc_t *plc;
+    s7comm_alarmcache_entry_t *entry;
+
+    if (pinfo->fd->flags.visited || s7comm_alarmcache_max_entries == 0 || s7comm_alarmcache_plcs == NULL) {
+        return;
+    }
+    plc = (s7comm_alarmcache_plc_t *)g_hash_table_lookup(s7comm_alarmcache_plcs, &pinfo->src);
+    if (plc == NULL) {
+        plc = g_new0(s7comm_alarmcache_plc_t, 1);
+        plc->addr.type = pinfo->src.type;
+        plc->addr.len = pinfo->src.len;
+        plc->addr.data = g_memdup(pinfo->src.data, pinfo->src.len);
+        plc->alarms = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, s7comm_alarmcache_free_entry);
+        plc->lru = g_queue_new();
+        g_hash_table_insert(s7comm_alarmcache_plcs, &plc->addr, plc);
+    }
+    entry = (s7comm_alarmcache_entry_t *)g_hash_table_lookup(plc->alarms, GUINT_TO_POINTER(ev_id));
+    if (entry != NULL) {
+        /* Replace the values, the entry is used most recently */
+        g_free(entry->value);
+        g_queue_unlink(plc->lru, entry->link);
+        g_queue_push_tail_link(plc->lru, entry->link);
+    } else {
+        while (g_queue_get_length(plc->lru) >= s7comm_alarmcache_max_entries) {
+            g_hash_table_remove(plc->alarms, g_queue_pop_head(plc->lru));
+        }
+        entry = g_new0(s7comm_alarmcache_entry_t, 1);
+        entry->ev_id = ev_id;
+        g_queue_push_tail(plc->lru, GUINT_TO_POINTER(ev_id));
+        entry->link = g_queue_peek_tail_link(plc->lru);
+        g_hash_table_insert(plc->alarms, GUINT_TO_POINTER(ev_id), entry);
+    }
+    entry->frame = pinfo->fd->num;
+    entry->coming = *coming;
+    entry->value_len = 0;
+    entry->value = NULL;
+    if (len > 0 && tvb_bytes_exist(tvb, offset, len)) {
+        entry->value_len = len;
+        entry->value = (guint8 *)tvb_memdup(NULL, tvb, offset, len);
+    }
+}
+
+/*******************************************************************************************************
+ *
+ * Add what is known of the EventID from an alarm query of the PLC in plc_addr to the tree
+ *
+ *******************************************************************************************************/
+void
+s7comm_alarmcache_add_to_tree(tvbuff_t *tvb,
+                              packet_info *pinfo,
+                              proto_tree *tree,
+                              const address *plc_addr,
+                              guint32 ev_id)
+{
+    s7comm_alarmcache_plc_t *plc;
+    s7comm_alarmcache_entry_t *entry;
+    s7comm_alarmcache_entry_t *known = NULL;
+    proto_item *item = NULL;
+    proto_tree *cache_tree = NULL;
+    tvbuff_t *value_tvb;
+
+    if (!pinfo->fd->flags.visited) {
+        if (s7comm_alarmcache_plcs == NULL) {
+            return;
+        }
+        plc = (s7comm_alarmcache_plc_t *)g_hash_table_lookup(s7comm_alarmcache_plcs, plc_addr);
+        entry = (plc != NULL) ? (s7comm_alarmcache_entry_t *)g_hash_table_lookup(plc->alarms, GUINT_TO_POINTER(ev_id)) : NULL;
+        if (entry == NULL) {
+            return;
+        }
+        g_queue_unlink(plc->lru, entry->link);
+        g_queue_push_tail_link(plc->lru, entry->link);
+        known = wmem_new0(wmem_file_scope(), s7comm_alarmcache_entry_t);
+        known->ev_id = ev_id;
+        known->frame = entry->frame;
+        known->coming = entry->coming;
+        if (entry->value_len > 0) {
+            known->value_len = entry->value_len;
+            known->value = (guint8 *)wmem_memdup(wmem_file_scope(), entry->value, entry->value_len);
+        }
+        s7comm_add_pdu_data(pinfo, proto_s7comm_alarmcache, S7COMM_PROTO_DATA_ALARM, ev_id, known);
+    } else {
+        known = (s7comm_alarmcache_entry_t *)s7comm_get_pdu_data(pinfo, proto_s7comm_alarmcache, S7COMM_PROTO_DATA_ALARM, ev_id);
+    }
+    if (known == NULL || known->ev_id != ev_id) {
+        return;
+    }
+    item = proto_tree_add_item(tree, hf_s7comm_alarmcache, tvb, 0, 0, ENC_NA);
+    PROTO_ITEM_SET_GENERATED(item);
+    cache_tree = proto_item_add_subtree(item, ett_s7comm_alarmcache);
+    item = proto_tree_add_uint(cache_tree, hf_s7comm_alarmcache_frame, tvb, 0, 0, known->frame);
+    PROTO_ITEM_SET_GENERATED(item);
+    item = proto_tree_add_time(cache_tree, hf_s7comm_alarmcache_coming, tvb, 0, 0, &known->coming);
+    PROTO_ITEM_SET_GENERATED(item);
+    if (known->value_len > 0) {
+        /* The value is not in this packet, give it an own tvb */
+        value_tvb = tvb_new_child_real_data(tvb, known->value, known->value_len, known->value_len);
+        item = proto_tree_add_item(cache_tree, hf_s7comm_alarmcache_value, value_tvb, 0, known->value_len, ENC_NA);
+        PROTO_ITEM_SET_GENERATED(item);
+    }
+}
+
+/*******************************************************************************************************
+ *
+ * Register the fields and the preference of the alarm cache
+ *
+ *******************************************************************************************************/
+void
+s7comm_register_alarmcache(int proto,
+                           module_t *module)
+{
+    static hf_register_info hf[] = {
+        { &hf_s7comm_alarmcache,
+        { "Alarm from query", "s7comm.alarm.query", FT_NONE, BASE_NONE, NULL, 0x0,
+          "Alarm as listed in an earlier response of an alarm query", HFILL }},
+        { &hf_s7comm_alarmcache_frame,
+        { "Query response in frame", "s7comm.alarm.query.frame", FT_FRAMENUM, BASE_NONE, NULL, 0x0,
+          NULL, HFILL }},
+        { &hf_s7comm_alarmcache_coming,
+        { "Coming timestamp", "s7comm.alarm.query.coming", FT_ABSOLUTE_TIME, ABSOLUTE_TIME_LOCAL, NULL, 0x0,
+          "S7 timestamp of the coming of the alarm", HFILL }},
+        { &hf_s7comm_alarmcache_value,
+        { "Associated value", "s7comm.alarm.query.value", FT_BYTES, BASE_NONE, NULL, 0x0,
+          "Associated value of the coming of the alarm", HFILL }},
+    };
+
+    static gint *ett[] = {
+        &ett_s7comm_alarmcache
+    };
+
+    proto_s7comm_alarmcache = proto;
+    proto_register_field_array(proto, hf, array_length(hf));
+    proto_register_subtree_array(ett, array_length(ett));
+    prefs_register_uint_preference(module, "alarm_cache_entries",
+        "Alarms per PLC from alarm queries",
+        "Maximum number of EventIDs per PLC kept from alarm query responses, "
+        "the least recently used are dropped first. 0 disables the cache",
+        10, &s7comm_alarmcache_max_entries);
+    register_init_routine(s7comm_alarmcache_init);
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
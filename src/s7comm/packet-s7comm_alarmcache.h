@@ -0,0 +1,45 @@
+/* packet-s7comm_alarmcache.h
+ *
+ * Author:      Thomas Wiens, 2014 (th.wiens@gmx.de)
+ * Description: Wireshark dissector for S7-Communication
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __PACKET_S7COMM_ALARMCACHE_H__
+#define __PACKET_S7COMM_ALARMCACHE_H__
+
+void s7comm_register_alarmcache(int proto, module_t *module);
+void s7comm_alarmcache_store(packet_info *pinfo, guint32 ev_id, const nstime_t *coming, tvbuff_t *tvb, guint32 offset, guint32 len);
+void s7comm_alarmcache_add_to_tree(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, const address *plc_addr, guint32 ev_id);
+
+#endif
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
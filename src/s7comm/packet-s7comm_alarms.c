@@ -0,0 +1,430 @@
+/* packet-s7comm_alarms.c
+ *
+ * Author:      Thomas Wiens, 2014 (th.wiens@gmx.de)
+ * Description: Wireshark dissector for S7-Communication
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**************************************************************************
+ * Alarm timeline for tshark
+ *
+ * -z "s7comm,alarms[,<window>[,<threshold>]]"
+ *   Follows the state of every EventID of every PLC from the alarm
+ *   indications (ALARM_8, ALARM_S, ALARM_SQ, NOTIFY and their acknowledge
+ *   indications). Every change is printed when it is seen:
+ *     coming        signal changed from 0 to 1
+ *     going         signal changed from 1 to 0, with the time it was active
+ *     acknowledged  acknowledge bit of the incoming or outgoing event was set,
+ *                   with the time since the signal was coming
+ *   If the coming of a signal is not in the capture, no duration is given.
+ *   The number of coming alarms of a PLC within the last <window> seconds
+ *   (default 600) is counted, above <threshold> (default 10) the PLC is in
+ *   an alarm flood. At the end a summary per PLC and EventID is printed.
+ *   Durations are taken from the capture time, not from the S7 timestamps
+ *   of the messages, so they don't depend on the clock of the PLC.
+ **************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <glib.h>
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/to_str.h>
+#include <epan/stat_cmd_args.h>
+
+#include "packet-s7comm.h"
+#include "packet-s7comm_tap.h"
+
+#define S7COMM_ALARMS_WINDOW                600     /* seconds */
+#define S7COMM_ALARMS_THRESHOLD             10      /* coming alarms per window */
+
+/* State of an EventID */
+typedef struct {
+    guint32 ev_id;
+    guint8 subfunc;                         /* Type of the last indication */
+    guint8 signalstate;
+    guint16 ackstate;
+    gdouble coming_time[8];                 /* Capture time of the last coming per signal, 0 if not captured */
+    guint32 n_coming;
+    guint32 n_going;
+    guint32 n_ack;
+    gdouble active_total;                   /* Seconds from coming to going, of all signals */
+    gdouble active_max;
+} s7comm_alarms_event_t;
+
+typedef struct {
+    address addr;                           /* Address of the PLC, with own copy of the data */
+    GHashTable *events;                     /* EventID -> s7comm_alarms_event_t */
+    GQueue *window;                         /* Capture times (gdouble *) of the coming alarms in the window */
+    guint32 n_coming;
+    guint32 n_going;
+    guint32 n_ack;
+    guint max_in_window;
+    guint32 max_in_window_frame;
+    guint32 n_floods;
+    gboolean in_flood;
+} s7comm_alarms_plc_t;
+
+typedef struct {
+    gdouble window;
+    guint threshold;
+    GHashTable *plcs;                       /* Address -> s7comm_alarms_plc_t */
+} s7comm_alarms_t;
+
+static void
+s7comm_alarms_free_plc(gpointer data)
+{
+    s7comm_alarms_plc_t *plc = (s7comm_alarms_plc_t *)data;
+
+    while (!g_queue_is_empty(plc->window)) {
+        g_free(g_queue_pop_head(plc->window));
+    }
+    g_queue_free(plc->window);
+    g_hash_table_destroy(plc->events);
+    g_free((gpointer)plc->addr.data);
+    g_free(plc);
+}
+
+static s7comm_alarms_plc_t *
+s7comm_alarms_get_plc(s7comm_alarms_t *alarms,
+                      const address *addr)
+{
+    s7comm_alarms_plc_t *plc;
+
+    plc = (s7comm_alarms_plc_t *)g_hash_table_lookup(alarms->plcs, addr);
+    if (plc == NULL) {
+        plc = g_new0(s7comm_alarms_plc_t, 1);
+        plc->addr.type = addr->type;
+        plc->addr.len = addr->len;
+        plc->addr.data = g_memdup(addr->data, addr->len);
+        plc->events = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+        plc->window = g_queue_new();
+        g_hash_table_insert(alarms->plcs, &plc->addr, plc);
+    }
+    return plc;
+}
+
+static const gchar *
+s7comm_alarms_type_name(guint8 subfunc)
+{
+    switch (subfunc) {
+        case S7COMM_UD_SUBF_CPU_ALARM8_IND:
+            return "ALARM_8";
+        case S7COMM_UD_SUBF_CPU_NOTIFY_IND:
+            return "NOTIFY";
+        case S7COMM_UD_SUBF_CPU_ALARMS_IND:
+            return "ALARM_S";
+        case S7COMM_UD_SUBF_CPU_ALARMSQ_IND:
+            return "ALARM_SQ";
+        default:
+            return "-";
+    }
+}
+
+/* Begin of a line of the timeline */
+static void
+s7comm_alarms_print_event(packet_info *pinfo,
+                          const s7comm_alarms_plc_t *plc,
+                          const s7comm_alarms_event_t *event,
+                          guint8 sig_nr)
+{
+    time_t secs;
+    struct tm *tm;
+
+    secs = pinfo->fd->abs_ts.secs;
+    tm = localtime(&secs);
+    printf("%6u ", pinfo->fd->num);
+    if (tm != NULL) {
+        printf("%04d-%02d-%02d %02d:%02d:%02d.%03d ", tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday,
+            tm->tm_hour, tm->tm_min, tm->tm_sec, pinfo->fd->abs_ts.nsecs / 1000000);
+    }
+    printf("%-15s EventID=0x%08x SIG_%d %-8s ", ep_address_to_str(&plc->addr), event->ev_id, sig_nr + 1,
+        s7comm_alarms_type_name(event->subfunc));
+}
+
+/* Packet for which the windows of all PLCs are expired */
+typedef struct {
+    s7comm_alarms_t *alarms;
+    packet_info *pinfo;
+    gdouble t;
+} s7comm_alarms_expire_t;
+
+/* Drop the coming alarms older than the window from the window of a PLC, this may end an alarm flood */
+static void
+s7comm_alarms_expire_window(gpointer key _U_,
+                            gpointer value,
+                            gpointer user_data)
+{
+    s7comm_alarms_plc_t *plc = (s7comm_alarms_plc_t *)value;
+    s7comm_alarms_expire_t *expire = (s7comm_alarms_expire_t *)user_data;
+
+    while (!g_queue_is_empty(plc->window) &&
+           *(gdouble *)g_queue_peek_head(plc->window) <= expire->t - expire->alarms->window) {
+        g_free(g_queue_pop_head(plc->window));
+    }
+    if (plc->in_flood && g_queue_get_length(plc->window) <= expire->alarms->threshold) {
+        plc->in_flood = FALSE;
+        printf("%6u %s: alarm flood ended\n", expire->pinfo->fd->num, ep_address_to_str(&plc->addr));
+    }
+}
+
+/* Count a coming alarm in the window of the PLC and check for an alarm flood */
+static void
+s7comm_alarms_count_coming(s7comm_alarms_t *alarms,
+                           packet_info *pinfo,
+                           s7comm_alarms_plc_t *plc,
+                           gdouble t)
+{
+    gdouble *coming_time;
+    guint n;
+
+    coming_time = g_new(gdouble, 1);
+    *coming_time = t;
+    g_queue_push_tail(plc->window, coming_time);
+    n = g_queue_get_length(plc->window);
+    if (n > plc->max_in_window) {
+        plc->max_in_window = n;
+        plc->max_in_window_frame = pinfo->fd->num;
+    }
+    if (n > alarms->threshold && !plc->in_flood) {
+        plc->in_flood = TRUE;
+        plc->n_floods++;
+        printf("%6u %s: alarm flood, %u alarms within %.0f s\n", pinfo->fd->num, ep_address_to_str(&plc->addr),
+            n, alarms->window);
+    }
+}
+
+/* End of the line of an acknowledge */
+static void
+s7comm_alarms_print_after(const s7comm_alarms_event_t *event,
+                          guint8 sig_nr,
+                          const gchar *direction,
+                          gdouble t)
+{
+    if (event->coming_time[sig_nr] > 0) {
+        printf("acknowledged (%s), after %.3f s\n", direction, t - event->coming_time[sig_nr]);
+    } else {
+        printf("acknowledged (%s), coming not captured\n", direction);
+    }
+}
+
+static int
+s7comm_alarms_packet(void *tapdata,
+                     packet_info *pinfo,
+                     epan_dissect_t *edt _U_,
+                     const void *data)
+{
+    s7comm_alarms_t *alarms = (s7comm_alarms_t *)tapdata;
+    const s7comm_alarm_tap_t *alarm = (const s7comm_alarm_tap_t *)data;
+    s7comm_alarms_plc_t *plc;
+    s7comm_alarms_event_t *event;
+    s7comm_alarms_expire_t expire;
+    gdouble t;
+    gdouble active;
+    guint8 sig_nr;
+    guint8 mask;
+    guint8 signalstate;
+
+    t = pinfo->fd->abs_ts.secs + pinfo->fd->abs_ts.nsecs / 1000000000.0;
+    /* Floods end by time, also of PLCs that send nothing anymore */
+    expire.alarms = alarms;
+    expire.pinfo = pinfo;
+    expire.t = t;
+    g_hash_table_foreach(alarms->plcs, s7comm_alarms_expire_window, &expire);
+    /* The indications are sent by the PLC */
+    plc = s7comm_alarms_get_plc(alarms, &pinfo->src);
+    event = (s7comm_alarms_event_t *)g_hash_table_lookup(plc->events, GUINT_TO_POINTER(alarm->ev_id));
+    if (event == NULL) {
+        /* The states before are unknown, so the acknowledge state is taken as it is */
+        event = g_new0(s7comm_alarms_event_t, 1);
+        event->ev_id = alarm->ev_id;
+        event->ackstate = alarm->ackstate;
+        g_hash_table_insert(plc->events, GUINT_TO_POINTER(alarm->ev_id), event);
+    }
+    if (alarm->subfunc != S7COMM_UD_SUBF_CPU_ALARMACK_IND) {
+        event->subfunc = alarm->subfunc;
+    }
+    signalstate = alarm->has_signalstate ? alarm->signalstate : event->signalstate;
+
+    for (sig_nr = 0; sig_nr < 8; sig_nr++) {
+        mask = 1 << sig_nr;
+        if ((signalstate & mask) && !(event->signalstate & mask)) {
+            event->coming_time[sig_nr] = t;
+            event->n_coming++;
+            plc->n_coming++;
+            s7comm_alarms_print_event(pinfo, plc, event, sig_nr);
+            printf("coming\n");
+            s7comm_alarms_count_coming(alarms, pinfo, plc, t);
+        } else if (!(signalstate & mask) && (event->signalstate & mask)) {
+            event->n_going++;
+            plc->n_going++;
+            s7comm_alarms_print_event(pinfo, plc, event, sig_nr);
+            if (event->coming_time[sig_nr] > 0) {
+                active = t - event->coming_time[sig_nr];
+                event->active_total += active;
+                if (active > event->active_max) {
+                    event->active_max = active;
+                }
+                printf("going, active %.3f s\n", active);
+            } else {
+                printf("going, coming not captured\n");
+            }
+        }
+        if ((alarm->ackstate & mask) && !(event->ackstate & mask)) {
+            event->n_ack++;
+            plc->n_ack++;
+            s7comm_alarms_print_event(pinfo, plc, event, sig_nr);
+            s7comm_alarms_print_after(event, sig_nr, "incoming", t);
+        }
+        if ((alarm->ackstate & (mask << 8)) && !(event->ackstate & (mask << 8))) {
+            event->n_ack++;
+            plc->n_ack++;
+            s7comm_alarms_print_event(pinfo, plc, event, sig_nr);
+            s7comm_alarms_print_after(event, sig_nr, "outgoing", t);
+        }
+    }
+    event->signalstate = signalstate;
+    event->ackstate = alarm->ackstate;
+    return FALSE;
+}
+
+static void
+s7comm_alarms_reset(void *tapdata)
+{
+    s7comm_alarms_t *alarms = (s7comm_alarms_t *)tapdata;
+
+    g_hash_table_remove_all(alarms->plcs);
+}
+
+static gint
+s7comm_alarms_compare_event(gconstpointer a,
+                            gconstpointer b)
+{
+    const s7comm_alarms_event_t *event1 = *(const s7comm_alarms_event_t * const *)a;
+    const s7comm_alarms_event_t *event2 = *(const s7comm_alarms_event_t * const *)b;
+
+    if (event1->ev_id < event2->ev_id) {
+        return -1;
+    }
+    return event1->ev_id > event2->ev_id;
+}
+
+static void
+s7comm_alarms_print_plc(gpointer key _U_,
+                        gpointer value,
+                        gpointer user_data _U_)
+{
+    s7comm_alarms_plc_t *plc = (s7comm_alarms_plc_t *)value;
+    s7comm_alarms_event_t *event;
+    GPtrArray *events;
+    guint i;
+
+    printf("\nPLC %s: %u coming, %u going, %u acknowledged, %u floods, max %u alarms in window (frame %u)\n",
+        ep_address_to_str(&plc->addr), plc->n_coming, plc->n_going, plc->n_ack, plc->n_floods,
+        plc->max_in_window, plc->max_in_window_frame);
+    printf("  EventID     Type      Coming  Going   Acks    Active total/max (s)  Signals now\n");
+    events = g_ptr_array_new();
+    g_hash_table_foreach(plc->events, s7comm_tap_collect, events);
+    g_ptr_array_sort(events, s7comm_alarms_compare_event);
+    for (i = 0; i < events->len; i++) {
+        event = (s7comm_alarms_event_t *)g_ptr_array_index(events, i);
+        printf("  0x%08x  %-8s  %-6u  %-6u  %-6u  %10.3f/%-10.3f  0x%02x\n", event->ev_id,
+            s7comm_alarms_type_name(event->subfunc), event->n_coming, event->n_going, event->n_ack,
+            event->active_total, event->active_max, event->signalstate);
+    }
+    g_ptr_array_free(events, TRUE);
+}
+
+static void
+s7comm_alarms_draw(void *tapdata)
+{
+    s7comm_alarms_t *alarms = (s7comm_alarms_t *)tapdata;
+
+    printf("\n===================================================================\n");
+    printf("S7 alarms, flood: more than %u alarms within %.0f s\n", alarms->threshold, alarms->window);
+    g_hash_table_foreach(alarms->plcs, s7comm_alarms_print_plc, NULL);
+    printf("===================================================================\n");
+}
+
+/*******************************************************************************************************
+ *
+ * -z "s7comm,alarms[,<window>[,<threshold>]]"
+ *
+ *******************************************************************************************************/
+static void
+s7comm_alarms_init(const char *optarg,
+                   void *userdata _U_)
+{
+    s7comm_alarms_t *alarms;
+    gchar **fields;
+    GString *error_string;
+    guint n;
+
+    alarms = g_new0(s7comm_alarms_t, 1);
+    alarms->window = S7COMM_ALARMS_WINDOW;
+    alarms->threshold = S7COMM_ALARMS_THRESHOLD;
+    fields = g_strsplit(optarg, ",", 4);
+    n = g_strv_length(fields);
+    if (n > 2) {
+        alarms->window = g_ascii_strtod(fields[2], NULL);
+    }
+    if (n > 3) {
+        alarms->threshold = (guint)strtoul(fields[3], NULL, 10);
+    }
+    g_strfreev(fields);
+    if (alarms->window <= 0) {
+        fprintf(stderr, "tshark: invalid \"-z s7comm,alarms[,<window>[,<threshold>]]\" argument\n");
+        exit(1);
+    }
+    alarms->plcs = g_hash_table_new_full(s7comm_tap_addr_hash, s7comm_tap_addr_equal,
+        NULL, s7comm_alarms_free_plc);
+
+    error_string = register_tap_listener("s7comm_alarm", alarms, NULL, TL_REQUIRES_NOTHING,
+        s7comm_alarms_reset, s7comm_alarms_packet, s7comm_alarms_draw);
+    if (error_string) {
+        fprintf(stderr, "tshark: Couldn't register s7comm,alarms tap: %s\n", error_string->str);
+        g_string_free(error_string, TRUE);
+        exit(1);
+    }
+}
+
+void
+s7comm_register_alarms_tap(void)
+{
+    register_stat_cmd_arg("s7comm,alarms", s7comm_alarms_init, NULL);
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
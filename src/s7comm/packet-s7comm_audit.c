@@ -0,0 +1,188 @@
+/* packet-s7comm_audit.c
+ *
+ * Author:      Thomas Wiens, 2014 (th.wiens@gmx.de)
+ * Description: Wireshark dissector for S7-Communication
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**************************************************************************
+ * Audit log of state changing operations for tshark
+ *
+ * -z "s7comm,audit,<file>"
+ *   Appends a CSV line to <file> for every request that changes the state
+ *   of a PLC, when the request is seen:
+ *     S7comm       Write var (with the addresses of all items), PLC control
+ *                  (PI service like _INSE, _DELE, _PROGRAM or
+ *                  _PLC_MEMORYRESET, with the blocks), PLC stop, Download
+ *                  start and end (with the block), Set time
+ *     S7comm-plus  SetMultiVariables, SetVariable and DeleteObject, if the
+ *                  S7comm-plus plugin is loaded
+ *   The file is never truncated, the header line is written only to an
+ *   empty file. Lines are written when the operation is dissected, so the
+ *   log is complete also when tshark is stopped on a live capture. The
+ *   operations are queued by the dissectors only if this tap is active,
+ *   and no protocol tree is needed.
+ **************************************************************************/
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <glib.h>
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/to_str.h>
+#include <epan/stat_cmd_args.h>
+#include <wsutil/file_util.h>
+
+#include "packet-s7comm.h"
+#include "packet-s7comm_tap.h"
+#include "packet-s7comm_audit.h"
+
+typedef struct {
+    gchar *filename;
+    FILE *fh;
+} s7comm_audit_t;
+
+/* One listener per protocol, on the same log */
+typedef struct {
+    s7comm_audit_t *audit;
+    const gchar *protocol;
+} s7comm_audit_listener_t;
+
+static int
+s7comm_audit_packet(void *tapdata,
+                    packet_info *pinfo,
+                    epan_dissect_t *edt _U_,
+                    const void *data)
+{
+    s7comm_audit_listener_t *listener = (s7comm_audit_listener_t *)tapdata;
+    const s7comm_audit_tap_t *op = (const s7comm_audit_tap_t *)data;
+    FILE *fh = listener->audit->fh;
+    time_t secs;
+    struct tm *tm;
+
+    secs = pinfo->fd->abs_ts.secs;
+    tm = localtime(&secs);
+    fprintf(fh, "%u,", pinfo->fd->num);
+    if (tm != NULL) {
+        fprintf(fh, "%04d-%02d-%02d %02d:%02d:%02d.%03d", tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday,
+            tm->tm_hour, tm->tm_min, tm->tm_sec, pinfo->fd->abs_ts.nsecs / 1000000);
+    }
+    fprintf(fh, ",%s", ep_address_to_str(&pinfo->src));
+    fprintf(fh, ",%s,%s,", ep_address_to_str(&pinfo->dst), listener->protocol);
+    s7comm_tap_write_csv_text(fh, op->operation);
+    fputc(',', fh);
+    s7comm_tap_write_csv_text(fh, op->object);
+    fputc(',', fh);
+    s7comm_tap_write_csv_text(fh, op->details);
+    fputc('\n', fh);
+    return FALSE;
+}
+
+static void
+s7comm_audit_draw(void *tapdata)
+{
+    s7comm_audit_listener_t *listener = (s7comm_audit_listener_t *)tapdata;
+
+    fflush(listener->audit->fh);
+}
+
+static void
+s7comm_audit_add_listener(s7comm_audit_t *audit,
+                          const gchar *tap_name,
+                          const gchar *protocol,
+                          gboolean required)
+{
+    s7comm_audit_listener_t *listener;
+    GString *error_string;
+
+    listener = g_new0(s7comm_audit_listener_t, 1);
+    listener->audit = audit;
+    listener->protocol = protocol;
+    error_string = register_tap_listener(tap_name, listener, NULL, TL_REQUIRES_NOTHING, NULL,
+        s7comm_audit_packet, s7comm_audit_draw);
+    if (error_string) {
+        /* The tap of a plugin which is not loaded */
+        if (required) {
+            fprintf(stderr, "tshark: Couldn't register s7comm,audit tap: %s\n", error_string->str);
+            g_string_free(error_string, TRUE);
+            exit(1);
+        }
+        g_string_free(error_string, TRUE);
+        g_free(listener);
+    }
+}
+
+/*******************************************************************************************************
+ *
+ * -z "s7comm,audit,<file>"
+ *
+ *******************************************************************************************************/
+static void
+s7comm_audit_init(const char *optarg,
+                  void *userdata _U_)
+{
+    s7comm_audit_t *audit;
+
+    audit = g_new0(s7comm_audit_t, 1);
+    audit->filename = g_strdup(optarg + strlen("s7comm,audit,"));
+    if (audit->filename[0] == '\0') {
+        fprintf(stderr, "tshark: invalid \"-z s7comm,audit,<file>\" argument\n");
+        exit(1);
+    }
+    audit->fh = ws_fopen(audit->filename, "a");
+    if (audit->fh == NULL) {
+        fprintf(stderr, "tshark: Can't open \"%s\": %s\n", audit->filename, g_strerror(errno));
+        exit(1);
+    }
+    /* Every line is written at once, for logs which are read while tshark is running */
+    setvbuf(audit->fh, NULL, _IOLBF, BUFSIZ);
+    fseek(audit->fh, 0, SEEK_END);
+    if (ftell(audit->fh) == 0) {
+        fprintf(audit->fh, "frame,time,source,destination,protocol,operation,object,details\n");
+    }
+
+    s7comm_audit_add_listener(audit, "s7comm_audit", "S7COMM", TRUE);
+    s7comm_audit_add_listener(audit, "s7commp_audit", "S7COMM-PLUS", FALSE);
+}
+
+void
+s7comm_register_audit_tap(void)
+{
+    register_stat_cmd_arg("s7comm,audit,", s7comm_audit_init, NULL);
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,455 @@
+/* packet-s7comm_blocks.c
+ *
+ * Author:      Thomas Wiens, 2014 (th.wiens@gmx.de)
+ * Description: Wireshark dissector for S7-Communication
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**************************************************************************
+ * Block catalog for tshark
+ *
+ * -z "s7comm,blocks[,<file>]"
+ *   Collects the program blocks of every PLC from the responses of the
+ *   block functions: the number of blocks per type from "List blocks",
+ *   the blocks of a type from "List blocks of type" and the header of a
+ *   block from "Get block info". The catalog is updated with every
+ *   response, a later block info replaces the earlier one.
+ *   At the end a table per PLC is printed. With <file> the catalog is also
+ *   written as CSV, one line per block. The column info_crc is a CRC-32
+ *   over the whole block info, so the blocks that changed between two
+ *   captures are found by comparing the files, without the traffic.
+ **************************************************************************/
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/to_str.h>
+#include <epan/stat_cmd_args.h>
+#include <wsutil/file_util.h>
+
+#include "packet-s7comm.h"
+#include "packet-s7comm_tap.h"
+
+/* A block of a PLC */
+typedef struct {
+    guint8 block_type;                      /* As in block lists, '8' = OB, 'A' = DB, ... */
+    guint16 number;
+    guint8 flags;
+    guint8 lang;
+    guint32 first_frame;
+    guint32 last_frame;
+    gboolean has_info;
+    guint32 info_frame;                     /* Frame of the last block info */
+    guint32 n_info_changes;                 /* Block infos with another CRC than the one before */
+    guint32 load_mem_len;
+    guint32 security;
+    gchar *code_timestamp;
+    gchar *interface_timestamp;
+    guint16 ssb_len;
+    guint16 add_len;
+    guint16 localdata_len;
+    guint16 mc7_len;
+    gchar *author;
+    gchar *family;
+    gchar *name;
+    gchar *version;
+    guint16 checksum;
+    guint32 info_crc;
+} s7comm_blocks_block_t;
+
+typedef struct {
+    address addr;                           /* Address of the PLC, with own copy of the data */
+    gchar *name;                            /* Address of the PLC as text */
+    GHashTable *blocks;                     /* (type << 16 | number) -> s7comm_blocks_block_t */
+    GHashTable *type_counts;                /* Block type -> number of blocks from the last block list */
+} s7comm_blocks_plc_t;
+
+typedef struct {
+    gchar *filename;                        /* CSV file, or NULL */
+    GHashTable *plcs;                       /* Address of the PLC -> s7comm_blocks_plc_t */
+} s7comm_blocks_t;
+
+static void
+s7comm_blocks_free_block(gpointer data)
+{
+    s7comm_blocks_block_t *block = (s7comm_blocks_block_t *)data;
+
+    g_free(block->code_timestamp);
+    g_free(block->interface_timestamp);
+    g_free(block->author);
+    g_free(block->family);
+    g_free(block->name);
+    g_free(block->version);
+    g_free(block);
+}
+
+static void
+s7comm_blocks_free_plc(gpointer data)
+{
+    s7comm_blocks_plc_t *plc = (s7comm_blocks_plc_t *)data;
+
+    g_hash_table_destroy(plc->blocks);
+    g_hash_table_destroy(plc->type_counts);
+    g_free((gpointer)plc->addr.data);
+    g_free(plc->name);
+    g_free(plc);
+}
+
+static s7comm_blocks_plc_t *
+s7comm_blocks_get_plc(s7comm_blocks_t *blocks,
+                      const address *addr)
+{
+    s7comm_blocks_plc_t *plc;
+
+    plc = (s7comm_blocks_plc_t *)g_hash_table_lookup(blocks->plcs, addr);
+    if (plc == NULL) {
+        plc = g_new0(s7comm_blocks_plc_t, 1);
+        plc->addr.type = addr->type;
+        plc->addr.len = addr->len;
+        plc->addr.data = g_memdup(addr->data, addr->len);
+        plc->name = g_strdup(ep_address_to_str(addr));
+        plc->blocks = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, s7comm_blocks_free_block);
+        plc->type_counts = g_hash_table_new(g_direct_hash, g_direct_equal);
+        g_hash_table_insert(blocks->plcs, &plc->addr, plc);
+    }
+    return plc;
+}
+
+static s7comm_blocks_block_t *
+s7comm_blocks_get_block(s7comm_blocks_plc_t *plc,
+                        packet_info *pinfo,
+                        guint8 block_type,
+                        guint16 number)
+{
+    s7comm_blocks_block_t *block;
+    guint key = ((guint)block_type << 16) | number;
+
+    block = (s7comm_blocks_block_t *)g_hash_table_lookup(plc->blocks, GUINT_TO_POINTER(key));
+    if (block == NULL) {
+        block = g_new0(s7comm_blocks_block_t, 1);
+        block->block_type = block_type;
+        block->number = number;
+        block->first_frame = pinfo->fd->num;
+        g_hash_table_insert(plc->blocks, GUINT_TO_POINTER(key), block);
+    }
+    block->last_frame = pinfo->fd->num;
+    return block;
+}
+
+/* Take the header of a block from a block info */
+static void
+s7comm_blocks_set_info(s7comm_blocks_block_t *block,
+                       packet_info *pinfo,
+                       const s7comm_block_tap_info_t *info)
+{
+    if (block->has_info && block->info_crc != info->info_crc) {
+        block->n_info_changes++;
+    }
+    block->has_info = TRUE;
+    block->info_frame = pinfo->fd->num;
+    block->flags = info->flags;
+    block->lang = info->lang;
+    block->load_mem_len = info->load_mem_len;
+    block->security = info->security;
+    block->ssb_len = info->ssb_len;
+    block->add_len = info->add_len;
+    block->localdata_len = info->localdata_len;
+    block->mc7_len = info->mc7_len;
+    block->checksum = info->checksum;
+    block->info_crc = info->info_crc;
+    g_free(block->code_timestamp);
+    block->code_timestamp = g_strdup(info->code_timestamp);
+    g_free(block->interface_timestamp);
+    block->interface_timestamp = g_strdup(info->interface_timestamp);
+    g_free(block->author);
+    block->author = g_strdup(info->author);
+    g_free(block->family);
+    block->family = g_strdup(info->family);
+    g_free(block->name);
+    block->name = g_strdup(info->name);
+    g_free(block->version);
+    block->version = g_strdup(info->version);
+}
+
+static int
+s7comm_blocks_packet(void *tapdata,
+                     packet_info *pinfo,
+                     epan_dissect_t *edt _U_,
+                     const void *data)
+{
+    s7comm_blocks_t *blocks = (s7comm_blocks_t *)tapdata;
+    const s7comm_block_tap_t *block_tap = (const s7comm_block_tap_t *)data;
+    const s7comm_block_tap_info_t *info;
+    s7comm_blocks_plc_t *plc;
+    s7comm_blocks_block_t *block;
+    guint16 i;
+
+    /* All of the tapped responses are sent by the PLC */
+    plc = s7comm_blocks_get_plc(blocks, &pinfo->src);
+    for (i = 0; i < block_tap->count; i++) {
+        info = &block_tap->blocks[i];
+        switch (block_tap->subfunc) {
+            case S7COMM_UD_SUBF_BLOCK_LIST:
+                /* The number is the count of blocks of the type */
+                g_hash_table_insert(plc->type_counts, GUINT_TO_POINTER((guint)info->block_type),
+                    GUINT_TO_POINTER((guint)info->number));
+                break;
+            case S7COMM_UD_SUBF_BLOCK_LISTTYPE:
+                block = s7comm_blocks_get_block(plc, pinfo, info->block_type, info->number);
+                block->flags = info->flags;
+                block->lang = info->lang;
+                break;
+            case S7COMM_UD_SUBF_BLOCK_BLOCKINFO:
+                block = s7comm_blocks_get_block(plc, pinfo, info->block_type, info->number);
+                s7comm_blocks_set_info(block, pinfo, info);
+                break;
+        }
+    }
+    return TRUE;
+}
+
+static void
+s7comm_blocks_reset(void *tapdata)
+{
+    s7comm_blocks_t *blocks = (s7comm_blocks_t *)tapdata;
+
+    g_hash_table_remove_all(blocks->plcs);
+}
+
+static gint
+s7comm_blocks_compare_plc(gconstpointer a,
+                          gconstpointer b)
+{
+    const s7comm_blocks_plc_t *plc1 = *(const s7comm_blocks_plc_t * const *)a;
+    const s7comm_blocks_plc_t *plc2 = *(const s7comm_blocks_plc_t * const *)b;
+
+    return strcmp(plc1->name, plc2->name);
+}
+
+static gint
+s7comm_blocks_compare_block(gconstpointer a,
+                            gconstpointer b)
+{
+    const s7comm_blocks_block_t *block1 = *(const s7comm_blocks_block_t * const *)a;
+    const s7comm_blocks_block_t *block2 = *(const s7comm_blocks_block_t * const *)b;
+
+    if (block1->block_type != block2->block_type) {
+        return block1->block_type < block2->block_type ? -1 : 1;
+    }
+    if (block1->number < block2->number) {
+        return -1;
+    }
+    return block1->number > block2->number;
+}
+
+/* Array of the PLCs or of the blocks of a PLC, sorted for the output */
+static GPtrArray *
+s7comm_blocks_sorted(GHashTable *table,
+                     GCompareFunc compare)
+{
+    GPtrArray *array;
+
+    array = g_ptr_array_new();
+    g_hash_table_foreach(table, s7comm_tap_collect, array);
+    g_ptr_array_sort(array, compare);
+    return array;
+}
+
+static const gchar *
+s7comm_blocks_type_name(guint8 block_type)
+{
+    switch (block_type) {
+        case S7COMM_BLOCKTYPE_OB:
+            return "OB";
+        case S7COMM_BLOCKTYPE_DB:
+            return "DB";
+        case S7COMM_BLOCKTYPE_SDB:
+            return "SDB";
+        case S7COMM_BLOCKTYPE_FC:
+            return "FC";
+        case S7COMM_BLOCKTYPE_SFC:
+            return "SFC";
+        case S7COMM_BLOCKTYPE_FB:
+            return "FB";
+        case S7COMM_BLOCKTYPE_SFB:
+            return "SFB";
+        default:
+            return "?";
+    }
+}
+
+static void
+s7comm_blocks_print_type_count(gpointer key,
+                               gpointer value,
+                               gpointer user_data _U_)
+{
+    printf(" %s=%u", s7comm_blocks_type_name((guint8)GPOINTER_TO_UINT(key)), GPOINTER_TO_UINT(value));
+}
+
+static void
+s7comm_blocks_print_plc(s7comm_blocks_plc_t *plc)
+{
+    s7comm_blocks_block_t *block;
+    GPtrArray *array;
+    guint i;
+
+    printf("\nPLC %s: %u blocks known", plc->name, g_hash_table_size(plc->blocks));
+    if (g_hash_table_size(plc->type_counts) > 0) {
+        printf(", block list:");
+        g_hash_table_foreach(plc->type_counts, s7comm_blocks_print_type_count, NULL);
+    }
+    printf("\n  Block      Lang  Name      Family    Author    Version  Code timestamp           MC7 len  Load len  Checksum  Info CRC  Changes\n");
+    array = s7comm_blocks_sorted(plc->blocks, s7comm_blocks_compare_block);
+    for (i = 0; i < array->len; i++) {
+        block = (s7comm_blocks_block_t *)g_ptr_array_index(array, i);
+        printf("  %-3s %-5u  0x%02x", s7comm_blocks_type_name(block->block_type), block->number, block->lang);
+        if (block->has_info) {
+            printf("  %-8s  %-8s  %-8s  %-7s  %-23s  %-7u  %-8u  0x%04x    %08x  %u\n",
+                block->name, block->family, block->author, block->version, block->code_timestamp,
+                block->mc7_len, block->load_mem_len, block->checksum, block->info_crc, block->n_info_changes);
+        } else {
+            printf("  (no block info)\n");
+        }
+    }
+    g_ptr_array_free(array, TRUE);
+}
+
+static void
+s7comm_blocks_write_csv(s7comm_blocks_t *blocks,
+                        GPtrArray *plcs)
+{
+    s7comm_blocks_plc_t *plc;
+    s7comm_blocks_block_t *block;
+    GPtrArray *array;
+    guint i, j;
+    FILE *fh;
+
+    fh = ws_fopen(blocks->filename, "w");
+    if (fh == NULL) {
+        fprintf(stderr, "tshark: Can't write \"%s\": %s\n", blocks->filename, g_strerror(errno));
+        return;
+    }
+    fprintf(fh, "plc,type,number,flags,language,name,family,author,version,code_timestamp,interface_timestamp,"
+        "load_mem_len,mc7_len,ssb_len,add_len,localdata_len,security,checksum,info_crc,first_frame,info_frame\n");
+    for (i = 0; i < plcs->len; i++) {
+        plc = (s7comm_blocks_plc_t *)g_ptr_array_index(plcs, i);
+        array = s7comm_blocks_sorted(plc->blocks, s7comm_blocks_compare_block);
+        for (j = 0; j < array->len; j++) {
+            block = (s7comm_blocks_block_t *)g_ptr_array_index(array, j);
+            fprintf(fh, "%s,%s,%u,0x%02x,0x%02x,", plc->name, s7comm_blocks_type_name(block->block_type),
+                block->number, block->flags, block->lang);
+            if (block->has_info) {
+                s7comm_tap_write_csv_text(fh, block->name);
+                fputc(',', fh);
+                s7comm_tap_write_csv_text(fh, block->family);
+                fputc(',', fh);
+                s7comm_tap_write_csv_text(fh, block->author);
+                fprintf(fh, ",%s,%s,%s,%u,%u,%u,%u,%u,%u,0x%04x,%08x,%u,%u\n", block->version,
+                    block->code_timestamp, block->interface_timestamp, block->load_mem_len, block->mc7_len,
+                    block->ssb_len, block->add_len, block->localdata_len, block->security, block->checksum,
+                    block->info_crc, block->first_frame, block->info_frame);
+            } else {
+                fprintf(fh, ",,,,,,,,,,,,,,%u,\n", block->first_frame);
+            }
+        }
+        g_ptr_array_free(array, TRUE);
+    }
+    fclose(fh);
+}
+
+static void
+s7comm_blocks_draw(void *tapdata)
+{
+    s7comm_blocks_t *blocks = (s7comm_blocks_t *)tapdata;
+    GPtrArray *plcs;
+    guint i;
+
+    plcs = s7comm_blocks_sorted(blocks->plcs, s7comm_blocks_compare_plc);
+    printf("\n===================================================================\n");
+    printf("S7 blocks\n");
+    for (i = 0; i < plcs->len; i++) {
+        s7comm_blocks_print_plc((s7comm_blocks_plc_t *)g_ptr_array_index(plcs, i));
+    }
+    printf("===================================================================\n");
+    if (blocks->filename != NULL) {
+        s7comm_blocks_write_csv(blocks, plcs);
+    }
+    g_ptr_array_free(plcs, TRUE);
+}
+
+/*******************************************************************************************************
+ *
+ * -z "s7comm,blocks[,<file>]"
+ *
+ *******************************************************************************************************/
+static void
+s7comm_blocks_init(const char *optarg,
+                   void *userdata _U_)
+{
+    s7comm_blocks_t *blocks;
+    gchar **fields;
+    GString *error_string;
+
+    blocks = g_new0(s7comm_blocks_t, 1);
+    fields = g_strsplit(optarg, ",", 3);
+    if (g_strv_length(fields) > 2) {
+        if (fields[2][0] == '\0') {
+            fprintf(stderr, "tshark: invalid \"-z s7comm,blocks[,<file>]\" argument\n");
+            exit(1);
+        }
+        blocks->filename = g_strdup(fields[2]);
+    }
+    g_strfreev(fields);
+    blocks->plcs = g_hash_table_new_full(s7comm_tap_addr_hash, s7comm_tap_addr_equal, NULL, s7comm_blocks_free_plc);
+
+    error_string = register_tap_listener("s7comm_block", blocks, NULL, TL_REQUIRES_NOTHING,
+        s7comm_blocks_reset, s7comm_blocks_packet, s7comm_blocks_draw);
+    if (error_string) {
+        fprintf(stderr, "tshark: Couldn't register s7comm,blocks tap: %s\n", error_string->str);
+        g_string_free(error_string, TRUE);
+        exit(1);
+    }
+}
+
+void
+s7comm_register_blocks_tap(void)
+{
+    register_stat_cmd_arg("s7comm,blocks", s7comm_blocks_init, NULL);
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,922 @@
+/* packet-s7comm_dblayout.c
+ *
+ * Author:      Thomas Wiens, 2014 (th.wiens@gmx.de)
+ * Description: Wireshark dissector for S7-Communication
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**************************************************************************
+ * Layout of data blocks from a TIA Portal export
+ *
+ * The export is a XML file with one element per data block, and one element
+ * per tag of the DB:
+ *   <dataBlock name="DB4" logicalAddress="%DB4" supportsAddressingByOffset="true" ...>
+ *     <dataTag name="Word0" offset="0.0" datatype="Word" ... />
+ *     <dataTag name="Struct" offset="632.0" datatype="Struct" ...>
+ *       <dataTag name="Struct_Word" offset="0.0" datatype="Word" ... />
+ *     </dataTag>
+ *   </dataBlock>
+ * Only DBs which can be accessed by offset (not optimized) are loaded, because
+ * only these can be read with the classic S7ANY addressing.
+ * Tags in structs have an offset relative to the struct, they are stored with
+ * their absolute offset and the full name like "Struct.Struct_Word".
+ * The tags of a DB are stored in an array sorted by the bit offset, so that the
+ * tags of a read/write item are found with a binary search.
+ *
+ * The S7-1200 symbolic addressing (syntax-id 0xb2) addresses a tag by the DB
+ * number, the CRC of the DB and a path of LIDs, one per struct level:
+ *   <dataBlock ... CRC="0x7AB386AB">
+ *     <dataTag name="Struct" ... lid="130">
+ *       <dataTag name="Struct_Word" ... lid="11" />
+ * For these all DBs with a CRC are loaded, also the optimized ones. The DBs
+ * are found in a hash table with (DB number, CRC) as key, the LIDs of a DB
+ * are stored in a trie with the members of every level sorted by LID.
+ **************************************************************************/
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+#include <epan/packet.h>
+#include <epan/report_err.h>
+
+#include "packet-s7comm.h"
+#include "packet-s7comm_dblayout.h"
+
+static gint ett_s7comm_tag = -1;
+
+static gint hf_s7comm_tag = -1;                             /* Tag from DB layout */
+static gint hf_s7comm_tag_name = -1;                        /* Full name of the tag, e.g. DB4.Struct.Struct_Word */
+static gint hf_s7comm_tag_datatype = -1;                    /* Datatype as in TIA Portal */
+static gint hf_s7comm_tag_value_bool = -1;
+static gint hf_s7comm_tag_value_hex = -1;
+static gint hf_s7comm_tag_value_uint = -1;
+static gint hf_s7comm_tag_value_int = -1;
+static gint hf_s7comm_tag_value_hex64 = -1;
+static gint hf_s7comm_tag_value_uint64 = -1;
+static gint hf_s7comm_tag_value_int64 = -1;
+static gint hf_s7comm_tag_value_real = -1;
+static gint hf_s7comm_tag_value_lreal = -1;
+static gint hf_s7comm_tag_value_string = -1;
+static gint hf_s7comm_tag_value_bytes = -1;
+
+/**************************************************************************
+ * Decoding of the tag values
+ */
+#define S7COMM_DBL_TYPE_BYTES               0           /* unknown datatype, arrays, structs, UDTs */
+#define S7COMM_DBL_TYPE_BOOL                1
+#define S7COMM_DBL_TYPE_HEX                 2
+#define S7COMM_DBL_TYPE_UINT                3
+#define S7COMM_DBL_TYPE_INT                 4
+#define S7COMM_DBL_TYPE_HEX64               5
+#define S7COMM_DBL_TYPE_UINT64              6
+#define S7COMM_DBL_TYPE_INT64               7
+#define S7COMM_DBL_TYPE_REAL                8
+#define S7COMM_DBL_TYPE_LREAL               9
+#define S7COMM_DBL_TYPE_CHAR                10
+#define S7COMM_DBL_TYPE_STRING              11
+
+typedef struct {
+    const gchar *name;                      /* Name of the datatype in the export */
+    guint32 bitsize;
+    guint8 type;
+    const gchar *unit;
+} s7comm_dbl_datatype_t;
+
+static const s7comm_dbl_datatype_t s7comm_dbl_datatypes[] = {
+    { "Bool",                               1,      S7COMM_DBL_TYPE_BOOL,       "" },
+    { "Byte",                               8,      S7COMM_DBL_TYPE_HEX,        "" },
+    { "Char",                               8,      S7COMM_DBL_TYPE_CHAR,       "" },
+    { "SInt",                               8,      S7COMM_DBL_TYPE_INT,        "" },
+    { "USInt",                              8,      S7COMM_DBL_TYPE_UINT,       "" },
+    { "Word",                               16,     S7COMM_DBL_TYPE_HEX,        "" },
+    { "Int",                                16,     S7COMM_DBL_TYPE_INT,        "" },
+    { "UInt",                               16,     S7COMM_DBL_TYPE_UINT,       "" },
+    { "S5Time",                             16,     S7COMM_DBL_TYPE_HEX,        "" },
+    { "Date",                               16,     S7COMM_DBL_TYPE_UINT,       " days since 1990-01-01" },
+    { "DWord",                              32,     S7COMM_DBL_TYPE_HEX,        "" },
+    { "DInt",                               32,     S7COMM_DBL_TYPE_INT,        "" },
+    { "UDInt",                              32,     S7COMM_DBL_TYPE_UINT,       "" },
+    { "Real",                               32,     S7COMM_DBL_TYPE_REAL,       "" },
+    { "Time",                               32,     S7COMM_DBL_TYPE_INT,        " ms" },
+    { "Time_Of_Day",                        32,     S7COMM_DBL_TYPE_UINT,       " ms since midnight" },
+    { "LWord",                              64,     S7COMM_DBL_TYPE_HEX64,      "" },
+    { "LInt",                               64,     S7COMM_DBL_TYPE_INT64,      "" },
+    { "ULInt",                              64,     S7COMM_DBL_TYPE_UINT64,     "" },
+    { "LReal",                              64,     S7COMM_DBL_TYPE_LREAL,      "" },
+    { "LTime",                              64,     S7COMM_DBL_TYPE_INT64,      " ns" },
+    { "LTime_Of_Day",                       64,     S7COMM_DBL_TYPE_UINT64,     " ns since midnight" },
+    { "LDT",                                64,     S7COMM_DBL_TYPE_UINT64,     " ns since 1970-01-01" },
+    { "Date_And_Time",                      64,     S7COMM_DBL_TYPE_BYTES,      "" },
+    { "DTL",                                96,     S7COMM_DBL_TYPE_BYTES,      "" },
+    { "String",                             2048,   S7COMM_DBL_TYPE_STRING,     "" },
+    { NULL,                                 0,      S7COMM_DBL_TYPE_BYTES,      "" }
+};
+#define S7COMM_DBL_DATATYPE_STRING          (&s7comm_dbl_datatypes[G_N_ELEMENTS(s7comm_dbl_datatypes) - 2])
+
+typedef struct {
+    guint32 bitoffset;                      /* Absolute offset in the DB in bits */
+    guint32 bitsize;                        /* 0 when unknown, then the tag reaches up to the next tag */
+    const s7comm_dbl_datatype_t *datatype;  /* NULL when the datatype is unknown */
+    gchar *name;                            /* Full name, including the name of the DB */
+    gchar *datatype_name;
+    gboolean is_struct;                     /* Only used while loading, structs are replaced by their members */
+} s7comm_dbl_tag_t;
+
+typedef struct {
+    gchar *name;
+    GArray *tags;                           /* of s7comm_dbl_tag_t, sorted by bitoffset */
+} s7comm_dbl_db_t;
+
+/* Node of the LID trie, the root node is the DB itself */
+typedef struct {
+    guint32 lid;
+    gchar *name;                            /* Name of the tag, for the root the name of the DB */
+    GPtrArray *members;                     /* of s7comm_dbl_sym_t, sorted by LID. NULL when there are none */
+} s7comm_dbl_sym_t;
+
+/* DB number -> s7comm_dbl_db_t */
+static GHashTable *s7comm_dbl_table = NULL;
+typedef struct {
+    guint16 db;
+    guint32 crc;
+} s7comm_dbl_sym_key_t;
+
+/* s7comm_dbl_sym_key_t -> s7comm_dbl_sym_t */
+static GHashTable *s7comm_dbl_sym_table = NULL;
+static gchar *s7comm_dbl_loaded_filename = NULL;
+
+/* Parser state while loading the export */
+#define S7COMM_DBL_MAX_DEPTH                16
+
+typedef struct {
+    s7comm_dbl_db_t *db;
+    guint depth;                            /* depth of the current dataTag, 0 = directly in dataBlock */
+    guint32 base[S7COMM_DBL_MAX_DEPTH];     /* absolute bit offset of the enclosing tags */
+    guint index[S7COMM_DBL_MAX_DEPTH];      /* index of the enclosing tags in db->tags, G_MAXUINT if invalid */
+    s7comm_dbl_sym_t *sym[S7COMM_DBL_MAX_DEPTH + 1];   /* LID trie nodes of the DB and the enclosing tags */
+    guint n_tags;
+} s7comm_dbl_parser_t;
+
+/*******************************************************************************************************
+ *
+ * Free the layout of a DB
+ *
+ *******************************************************************************************************/
+static void
+s7comm_dbl_free_db(gpointer data)
+{
+    s7comm_dbl_db_t *db = (s7comm_dbl_db_t *)data;
+    s7comm_dbl_tag_t *tag;
+    guint i;
+
+    for (i = 0; i < db->tags->len; i++) {
+        tag = &g_array_index(db->tags, s7comm_dbl_tag_t, i);
+        g_free(tag->name);
+        g_free(tag->datatype_name);
+    }
+    g_array_free(db->tags, TRUE);
+    g_free(db->name);
+    g_free(db);
+}
+
+/*******************************************************************************************************
+ *
+ * Free a node of the LID trie with all its members
+ *
+ *******************************************************************************************************/
+static void
+s7comm_dbl_free_sym(gpointer data)
+{
+    s7comm_dbl_sym_t *sym = (s7comm_dbl_sym_t *)data;
+    guint i;
+
+    if (sym->members != NULL) {
+        for (i = 0; i < sym->members->len; i++) {
+            s7comm_dbl_free_sym(g_ptr_array_index(sym->members, i));
+        }
+        g_ptr_array_free(sym->members, TRUE);
+    }
+    g_free(sym->name);
+    g_free(sym);
+}
+
+static s7comm_dbl_sym_t *
+s7comm_dbl_new_sym(s7comm_dbl_sym_t *parent,
+                   guint32 lid,
+                   const gchar *name)
+{
+    s7comm_dbl_sym_t *sym;
+
+    sym = g_new0(s7comm_dbl_sym_t, 1);
+    sym->lid = lid;
+    sym->name = g_strdup(name);
+    if (parent != NULL) {
+        if (parent->members == NULL) {
+            parent->members = g_ptr_array_new();
+        }
+        g_ptr_array_add(parent->members, sym);
+    }
+    return sym;
+}
+
+static gint
+s7comm_dbl_compare_syms(gconstpointer a,
+                        gconstpointer b)
+{
+    const s7comm_dbl_sym_t *sa = *(const s7comm_dbl_sym_t * const *)a;
+    const s7comm_dbl_sym_t *sb = *(const s7comm_dbl_sym_t * const *)b;
+
+    if (sa->lid < sb->lid) {
+        return -1;
+    }
+    return (sa->lid > sb->lid) ? 1 : 0;
+}
+
+/* Sort the members of all levels by LID */
+static void
+s7comm_dbl_sort_sym(s7comm_dbl_sym_t *sym)
+{
+    guint i;
+
+    if (sym->members == NULL) {
+        return;
+    }
+    g_ptr_array_sort(sym->members, s7comm_dbl_compare_syms);
+    for (i = 0; i < sym->members->len; i++) {
+        s7comm_dbl_sort_sym((s7comm_dbl_sym_t *)g_ptr_array_index(sym->members, i));
+    }
+}
+
+static guint
+s7comm_dbl_sym_key_hash(gconstpointer key)
+{
+    const s7comm_dbl_sym_key_t *k = (const s7comm_dbl_sym_key_t *)key;
+
+    return k->crc ^ k->db;
+}
+
+static gboolean
+s7comm_dbl_sym_key_equal(gconstpointer a,
+                         gconstpointer b)
+{
+    const s7comm_dbl_sym_key_t *ka = (const s7comm_dbl_sym_key_t *)a;
+    const s7comm_dbl_sym_key_t *kb = (const s7comm_dbl_sym_key_t *)b;
+
+    return ka->db == kb->db && ka->crc == kb->crc;
+}
+
+static void
+s7comm_dbl_sort_sym_table(gpointer key _U_,
+                          gpointer value,
+                          gpointer user_data _U_)
+{
+    s7comm_dbl_sort_sym((s7comm_dbl_sym_t *)value);
+}
+
+/*******************************************************************************************************
+ *
+ * Get the datatype of a tag, and the size in bits. Strings with maximum length like String[20]
+ * and arrays of simple types are calculated, arrays of Bool are packed by bits. For all other
+ * datatypes the size remains 0.
+ *
+ *******************************************************************************************************/
+static const s7comm_dbl_datatype_t *
+s7comm_dbl_get_datatype(const gchar *name,
+                        guint32 *bitsize)
+{
+    const s7comm_dbl_datatype_t *dt;
+    const gchar *elem;
+    glong lo, hi;
+    gchar *end;
+
+    *bitsize = 0;
+    if (g_ascii_strncasecmp(name, "String[", 7) == 0) {
+        *bitsize = ((guint32)strtoul(name + 7, NULL, 10) + 2) * 8;
+        return S7COMM_DBL_DATATYPE_STRING;
+    }
+    /* Array [0..10] of Word */
+    if (g_ascii_strncasecmp(name, "Array", 5) == 0) {
+        elem = strchr(name, '[');
+        if (elem != NULL) {
+            lo = strtol(elem + 1, &end, 10);
+            if (end[0] == '.' && end[1] == '.') {
+                hi = strtol(end + 2, &end, 10);
+                elem = strstr(end, " of ");
+                if (end[0] == ']' && elem != NULL && hi >= lo) {
+                    for (dt = s7comm_dbl_datatypes; dt->name != NULL; dt++) {
+                        if (g_ascii_strcasecmp(elem + 4, dt->name) == 0) {
+                            *bitsize = (guint32)(hi - lo + 1) * dt->bitsize;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        return NULL;
+    }
+    for (dt = s7comm_dbl_datatypes; dt->name != NULL; dt++) {
+        if (g_ascii_strcasecmp(name, dt->name) == 0) {
+            *bitsize = dt->bitsize;
+            return dt;
+        }
+    }
+    return NULL;
+}
+
+static const gchar *
+s7comm_dbl_get_attribute(const gchar **attribute_names,
+                         const gchar **attribute_values,
+                         const gchar *name)
+{
+    for (; *attribute_names != NULL; attribute_names++, attribute_values++) {
+        if (strcmp(*attribute_names, name) == 0) {
+            return *attribute_values;
+        }
+    }
+    return NULL;
+}
+
+static void
+s7comm_dbl_start_element(GMarkupParseContext *context _U_,
+                         const gchar *element_name,
+                         const gchar **attribute_names,
+                         const gchar **attribute_values,
+                         gpointer user_data,
+                         GError **error _U_)
+{
+    s7comm_dbl_parser_t *parser = (s7comm_dbl_parser_t *)user_data;
+    s7comm_dbl_tag_t tag;
+    const gchar *name;
+    const gchar *offset;
+    const gchar *datatype;
+    const gchar *address;
+    const gchar *by_offset;
+    const gchar *parent_name;
+    const gchar *crc;
+    const gchar *lid;
+    gchar *end;
+    guint32 bitoffset;
+    guint16 db_number;
+    s7comm_dbl_sym_key_t *key;
+
+    if (strcmp(element_name, "dataBlock") == 0) {
+        parser->db = NULL;
+        parser->sym[0] = NULL;
+        parser->depth = 0;
+        name = s7comm_dbl_get_attribute(attribute_names, attribute_values, "name");
+        address = s7comm_dbl_get_attribute(attribute_names, attribute_values, "logicalAddress");
+        if (name == NULL || address == NULL || g_ascii_strncasecmp(address, "%DB", 3) != 0) {
+            return;
+        }
+        db_number = (guint16)strtoul(address + 3, NULL, 10);
+        crc = s7comm_dbl_get_attribute(attribute_names, attribute_values, "CRC");
+        if (crc != NULL) {
+            key = g_new(s7comm_dbl_sym_key_t, 1);
+            key->db = db_number;
+            key->crc = (guint32)strtoul(crc, NULL, 16);
+            parser->sym[0] = s7comm_dbl_new_sym(NULL, 0, name);
+            g_hash_table_replace(s7comm_dbl_sym_table, key, parser->sym[0]);
+        }
+        by_offset = s7comm_dbl_get_attribute(attribute_names, attribute_values, "supportsAddressingByOffset");
+        if (by_offset == NULL || g_ascii_strcasecmp(by_offset, "true") != 0) {
+            return;
+        }
+        parser->db = g_new0(s7comm_dbl_db_t, 1);
+        parser->db->name = g_strdup(name);
+        parser->db->tags = g_array_new(FALSE, FALSE, sizeof(s7comm_dbl_tag_t));
+        /* a DB which is listed twice replaces the first one */
+        g_hash_table_replace(s7comm_dbl_table, GUINT_TO_POINTER(db_number), parser->db);
+    } else if (strcmp(element_name, "dataTag") == 0) {
+        parser->depth++;
+        if (parser->depth > S7COMM_DBL_MAX_DEPTH) {
+            return;
+        }
+        name = s7comm_dbl_get_attribute(attribute_names, attribute_values, "name");
+        offset = s7comm_dbl_get_attribute(attribute_names, attribute_values, "offset");
+        datatype = s7comm_dbl_get_attribute(attribute_names, attribute_values, "datatype");
+        lid = s7comm_dbl_get_attribute(attribute_names, attribute_values, "lid");
+        parser->sym[parser->depth] = NULL;
+        if (name != NULL && lid != NULL && parser->sym[parser->depth - 1] != NULL) {
+            parser->sym[parser->depth] = s7comm_dbl_new_sym(parser->sym[parser->depth - 1],
+                (guint32)strtoul(lid, NULL, 10), name);
+        }
+        if (parser->db == NULL) {
+            return;
+        }
+        parser->index[parser->depth - 1] = G_MAXUINT;
+        if (name == NULL || offset == NULL || datatype == NULL ||
+            (parser->depth > 1 && parser->index[parser->depth - 2] == G_MAXUINT)) {
+            return;
+        }
+        /* offset is given as byte.bit */
+        bitoffset = (guint32)strtoul(offset, &end, 10) * 8;
+        if (*end == '.') {
+            bitoffset += (guint32)strtoul(end + 1, NULL, 10) & 0x07;
+        }
+        memset(&tag, 0, sizeof(tag));
+        if (parser->depth > 1) {
+            /* member of a struct */
+            g_array_index(parser->db->tags, s7comm_dbl_tag_t, parser->index[parser->depth - 2]).is_struct = TRUE;
+            parent_name = g_array_index(parser->db->tags, s7comm_dbl_tag_t, parser->index[parser->depth - 2]).name;
+            tag.bitoffset = parser->base[parser->depth - 2] + bitoffset;
+            tag.name = g_strdup_printf("%s.%s", parent_name, name);
+        } else {
+            tag.bitoffset = bitoffset;
+            tag.name = g_strdup_printf("%s.%s", parser->db->name, name);
+        }
+        tag.datatype = s7comm_dbl_get_datatype(datatype, &tag.bitsize);
+        tag.datatype_name = g_strdup(datatype);
+        parser->base[parser->depth - 1] = tag.bitoffset;
+        parser->index[parser->depth - 1] = parser->db->tags->len;
+        g_array_append_val(parser->db->tags, tag);
+    }
+}
+
+static gint
+s7comm_dbl_compare_tags(gconstpointer a,
+                        gconstpointer b)
+{
+    const s7comm_dbl_tag_t *ta = (const s7comm_dbl_tag_t *)a;
+    const s7comm_dbl_tag_t *tb = (const s7comm_dbl_tag_t *)b;
+
+    if (ta->bitoffset < tb->bitoffset) {
+        return -1;
+    }
+    return (ta->bitoffset > tb->bitoffset) ? 1 : 0;
+}
+
+/*******************************************************************************************************
+ *
+ * A DB was read completely: drop the structs whose members are known, sort the tags by offset
+ * and limit tags of unknown size by the next tag.
+ *
+ *******************************************************************************************************/
+static void
+s7comm_dbl_finish_db(s7comm_dbl_parser_t *parser)
+{
+    GArray *tags = parser->db->tags;
+    s7comm_dbl_tag_t *tag;
+    guint i, j, n;
+
+    for (i = 0, n = 0; i < tags->len; i++) {
+        tag = &g_array_index(tags, s7comm_dbl_tag_t, i);
+        if (tag->is_struct) {
+            g_free(tag->name);
+            g_free(tag->datatype_name);
+        } else {
+            g_array_index(tags, s7comm_dbl_tag_t, n++) = *tag;
+        }
+    }
+    g_array_set_size(tags, n);
+    g_array_sort(tags, s7comm_dbl_compare_tags);
+    for (i = 0; i + 1 < tags->len; i++) {
+        tag = &g_array_index(tags, s7comm_dbl_tag_t, i);
+        if (tag->bitsize == 0) {
+            /* Tags at the same offset (views of AT) don't limit it, take the next one behind */
+            for (j = i + 1; j < tags->len && g_array_index(tags, s7comm_dbl_tag_t, j).bitoffset == tag->bitoffset; j++)
+                ;
+            if (j < tags->len) {
+                tag->bitsize = g_array_index(tags, s7comm_dbl_tag_t, j).bitoffset - tag->bitoffset;
+            }
+        }
+    }
+    parser->n_tags += tags->len;
+}
+
+static void
+s7comm_dbl_end_element(GMarkupParseContext *context _U_,
+                       const gchar *element_name,
+                       gpointer user_data,
+                       GError **error _U_)
+{
+    s7comm_dbl_parser_t *parser = (s7comm_dbl_parser_t *)user_data;
+
+    if (strcmp(element_name, "dataBlock") == 0) {
+        if (parser->db != NULL) {
+            s7comm_dbl_finish_db(parser);
+        }
+        parser->db = NULL;
+        parser->sym[0] = NULL;
+    } else if (strcmp(element_name, "dataTag") == 0 && parser->depth > 0) {
+        parser->depth--;
+    }
+}
+
+/*******************************************************************************************************
+ *
+ * Load the DB layouts from a TIA Portal export. An empty filename removes all layouts.
+ *
+ *******************************************************************************************************/
+void
+s7comm_load_dblayout(const gchar *filename)
+{
+    static const GMarkupParser markup_parser = {
+        s7comm_dbl_start_element,
+        s7comm_dbl_end_element,
+        NULL,
+        NULL,
+        NULL
+    };
+    GMarkupParseContext *context;
+    s7comm_dbl_parser_t parser;
+    GError *err = NULL;
+    gchar *contents = NULL;
+    gsize length = 0;
+
+    if (filename == NULL) {
+        filename = "";
+    }
+    if (s7comm_dbl_loaded_filename != NULL && strcmp(filename, s7comm_dbl_loaded_filename) == 0) {
+        return;
+    }
+    g_free(s7comm_dbl_loaded_filename);
+    s7comm_dbl_loaded_filename = g_strdup(filename);
+    if (s7comm_dbl_table != NULL) {
+        g_hash_table_destroy(s7comm_dbl_table);
+        g_hash_table_destroy(s7comm_dbl_sym_table);
+        s7comm_dbl_table = NULL;
+        s7comm_dbl_sym_table = NULL;
+    }
+    if (filename[0] == '\0') {
+        return;
+    }
+    if (!g_file_get_contents(filename, &contents, &length, &err)) {
+        report_failure("S7COMM: Can't read DB layout file %s: %s", filename, err->message);
+        g_error_free(err);
+        return;
+    }
+    s7comm_dbl_table = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, s7comm_dbl_free_db);
+    s7comm_dbl_sym_table = g_hash_table_new_full(s7comm_dbl_sym_key_hash, s7comm_dbl_sym_key_equal, g_free, s7comm_dbl_free_sym);
+    memset(&parser, 0, sizeof(parser));
+    context = g_markup_parse_context_new(&markup_parser, (GMarkupParseFlags)0, &parser, NULL);
+    /* The export may contain a list of dataBlock elements without a common root element */
+    if (!g_markup_parse_context_parse(context, "<s7comm-dblayout>", -1, &err) ||
+        !g_markup_parse_context_parse(context, contents, (gssize)length, &err) ||
+        !g_markup_parse_context_parse(context, "</s7comm-dblayout>", -1, &err) ||
+        !g_markup_parse_context_end_parse(context, &err)) {
+        report_failure("S7COMM: Error in DB layout file %s: %s", filename, err->message);
+        g_error_free(err);
+        /* a DB which was interrupted has no sorted tags, drop it */
+        if (parser.db != NULL) {
+            s7comm_dbl_finish_db(&parser);
+        }
+    }
+    g_markup_parse_context_free(context);
+    g_free(contents);
+    g_hash_table_foreach(s7comm_dbl_sym_table, s7comm_dbl_sort_sym_table, NULL);
+}
+
+/*******************************************************************************************************
+ *
+ * Add one tag with its value to the tree
+ *
+ *******************************************************************************************************/
+static void
+s7comm_dbl_add_tag_to_tree(tvbuff_t *tvb,
+                           proto_tree *tree,
+                           const s7comm_dbl_tag_t *tag,
+                           guint32 offset,
+                           guint32 len,
+                           gboolean bit_access)
+{
+    proto_item *item = NULL;
+    proto_tree *tag_tree = NULL;
+    guint8 type;
+    guint8 bitval;
+    guint8 strlen_max;
+    guint8 strlen_act;
+    guint32 uval = 0;
+    gint32 ival = 0;
+    guint64 uval64;
+    gfloat fval;
+    gdouble dval;
+    const gchar *unit;
+    guint8 *str;
+
+    type = (tag->datatype != NULL) ? tag->datatype->type : S7COMM_DBL_TYPE_BYTES;
+    unit = (tag->datatype != NULL) ? tag->datatype->unit : "";
+
+    item = proto_tree_add_item(tree, hf_s7comm_tag, tvb, offset, len, ENC_NA);
+    tag_tree = proto_item_add_subtree(item, ett_s7comm_tag);
+    proto_item_append_text(item, ": %s (%s)", tag->name, tag->datatype_name);
+    proto_tree_add_string(tag_tree, hf_s7comm_tag_name, tvb, offset, len, tag->name);
+    proto_tree_add_string(tag_tree, hf_s7comm_tag_datatype, tvb, offset, len, tag->datatype_name);
+
+    if (len == 1 || len == 2 || len == 4) {
+        switch (len) {
+            case 1:
+                uval = tvb_get_guint8(tvb, offset);
+                ival = (gint8)uval;
+                break;
+            case 2:
+                uval = tvb_get_ntohs(tvb, offset);
+                ival = (gint16)uval;
+                break;
+            case 4:
+                uval = tvb_get_ntohl(tvb, offset);
+                ival = (gint32)uval;
+                break;
+        }
+    }
+
+    switch (type) {
+        case S7COMM_DBL_TYPE_BOOL:
+            /* with bit access the value is always in bit 0 */
+            bitval = tvb_get_guint8(tvb, offset);
+            bitval = bit_access ? (bitval & 0x01) : ((bitval >> (tag->bitoffset % 8)) & 0x01);
+            proto_tree_add_boolean(tag_tree, hf_s7comm_tag_value_bool, tvb, offset, 1, bitval);
+            proto_item_append_text(item, " = %s", bitval ? "TRUE" : "FALSE");
+            break;
+        case S7COMM_DBL_TYPE_HEX:
+            proto_tree_add_uint(tag_tree, hf_s7comm_tag_value_hex, tvb, offset, len, uval);
+            proto_item_append_text(item, " = 0x%0*x", len * 2, uval);
+            break;
+        case S7COMM_DBL_TYPE_UINT:
+            proto_tree_add_uint(tag_tree, hf_s7comm_tag_value_uint, tvb, offset, len, uval);
+            proto_item_append_text(item, " = %u%s", uval, unit);
+            break;
+        case S7COMM_DBL_TYPE_INT:
+            proto_tree_add_int(tag_tree, hf_s7comm_tag_value_int, tvb, offset, len, ival);
+            proto_item_append_text(item, " = %d%s", ival, unit);
+            break;
+        case S7COMM_DBL_TYPE_HEX64:
+            uval64 = tvb_get_ntoh64(tvb, offset);
+            proto_tree_add_uint64(tag_tree, hf_s7comm_tag_value_hex64, tvb, offset, len, uval64);
+            proto_item_append_text(item, " = 0x%016" G_GINT64_MODIFIER "x", uval64);
+            break;
+        case S7COMM_DBL_TYPE_UINT64:
+            uval64 = tvb_get_ntoh64(tvb, offset);
+            proto_tree_add_uint64(tag_tree, hf_s7comm_tag_value_uint64, tvb, offset, len, uval64);
+            proto_item_append_text(item, " = %" G_GINT64_MODIFIER "u%s", uval64, unit);
+            break;
+        case S7COMM_DBL_TYPE_INT64:
+            uval64 = tvb_get_ntoh64(tvb, offset);
+            proto_tree_add_int64(tag_tree, hf_s7comm_tag_value_int64, tvb, offset, len, (gint64)uval64);
+            proto_item_append_text(item, " = %" G_GINT64_MODIFIER "d%s", (gint64)uval64, unit);
+            break;
+        case S7COMM_DBL_TYPE_REAL:
+            fval = tvb_get_ntohieee_float(tvb, offset);
+            proto_tree_add_float(tag_tree, hf_s7comm_tag_value_real, tvb, offset, len, fval);
+            proto_item_append_text(item, " = %f", fval);
+            break;
+        case S7COMM_DBL_TYPE_LREAL:
+            dval = tvb_get_ntohieee_double(tvb, offset);
+            proto_tree_add_double(tag_tree, hf_s7comm_tag_value_lreal, tvb, offset, len, dval);
+            proto_item_append_text(item, " = %f", dval);
+            break;
+        case S7COMM_DBL_TYPE_CHAR:
+            str = tvb_get_string_enc(wmem_packet_scope(), tvb, offset, 1, ENC_ASCII);
+            proto_tree_add_string(tag_tree, hf_s7comm_tag_value_string, tvb, offset, 1, (const gchar *)str);
+            proto_item_append_text(item, " = '%s'", str);
+            break;
+        case S7COMM_DBL_TYPE_STRING:
+            /* 1 byte maximum length, 1 byte actual length, then the characters */
+            if (len > 2) {
+                strlen_max = tvb_get_guint8(tvb, offset);
+                strlen_act = tvb_get_guint8(tvb, offset + 1);
+                if (strlen_act > strlen_max) {
+                    strlen_act = strlen_max;
+                }
+                if (strlen_act > len - 2) {
+                    strlen_act = (guint8)(len - 2);
+                }
+                str = tvb_get_string_enc(wmem_packet_scope(), tvb, offset + 2, strlen_act, ENC_ASCII);
+                proto_tree_add_string(tag_tree, hf_s7comm_tag_value_string, tvb, offset + 2, strlen_act, (const gchar *)str);
+                proto_item_append_text(item, " = \"%s\"", str);
+            }
+            break;
+        default:
+            proto_tree_add_item(tag_tree, hf_s7comm_tag_value_bytes, tvb, offset, len, ENC_NA);
+            break;
+    }
+}
+
+/*******************************************************************************************************
+ *
+ * Add the tags of a DB which are completely inside of the data of a read/write item to the tree.
+ * bitaddr/bitlen are the address and size of the item in the DB, offset is the position of the
+ * data in the tvb. Returns the number of tags added.
+ *
+ *******************************************************************************************************/
+guint32
+s7comm_add_dblayout_tags_to_tree(tvbuff_t *tvb,
+                                 proto_tree *tree,
+                                 guint16 db,
+                                 guint32 bitaddr,
+                                 guint32 bitlen,
+                                 guint32 offset)
+{
+    s7comm_dbl_db_t *dbl;
+    s7comm_dbl_tag_t *tags;
+    guint32 lo, hi, mid;
+    guint32 bitend;
+    guint32 tagend;
+    guint32 count = 0;
+    gboolean bit_access;
+
+    if (s7comm_dbl_table == NULL || bitlen == 0) {
+        return 0;
+    }
+    dbl = (s7comm_dbl_db_t *)g_hash_table_lookup(s7comm_dbl_table, GUINT_TO_POINTER((guint32)db));
+    if (dbl == NULL || dbl->tags->len == 0) {
+        return 0;
+    }
+    tags = (s7comm_dbl_tag_t *)(void *)dbl->tags->data;
+    bit_access = (bitlen == 1);
+    if (!bit_access) {
+        /* data of byte accesses always starts at a byte boundary */
+        bitaddr &= ~0x07;
+    }
+    bitend = bitaddr + bitlen;
+
+    /* binary search for the first tag at or behind the start address */
+    lo = 0;
+    hi = dbl->tags->len;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (tags[mid].bitoffset < bitaddr) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    for (; lo < dbl->tags->len && tags[lo].bitoffset < bitend; lo++) {
+        tagend = (tags[lo].bitsize > 0) ? tags[lo].bitoffset + tags[lo].bitsize : bitend;
+        if (tagend > bitend) {
+            break;
+        }
+        s7comm_dbl_add_tag_to_tree(tvb, tree, &tags[lo],
+            offset + (tags[lo].bitoffset / 8 - bitaddr / 8),
+            (tagend - (tags[lo].bitoffset & ~0x07) + 7) / 8,
+            bit_access);
+        count++;
+    }
+    return count;
+}
+
+/*******************************************************************************************************
+ *
+ * Get the name of a tag addressed with S7-1200 symbolic addressing. lid_flags and lid_values are
+ * the LID path of the item. LIDs select the member of a struct, indices are added as [n].
+ * Returns FALSE if the DB with this CRC, or one of the LIDs is not known.
+ *
+ *******************************************************************************************************/
+gboolean
+s7comm_get_dblayout_symbol(guint16 db,
+                           guint32 crc,
+                           const guint8 *lid_flags,
+                           const guint32 *lid_values,
+                           guint count,
+                           gchar *str,
+                           gsize max)
+{
+    s7comm_dbl_sym_t *sym;
+    s7comm_dbl_sym_t *member;
+    s7comm_dbl_sym_key_t key;
+    gsize pos;
+    guint lo, hi, mid;
+    guint i;
+
+    if (s7comm_dbl_sym_table == NULL) {
+        return FALSE;
+    }
+    key.db = db;
+    key.crc = crc;
+    sym = (s7comm_dbl_sym_t *)g_hash_table_lookup(s7comm_dbl_sym_table, &key);
+    if (sym == NULL) {
+        return FALSE;
+    }
+    pos = g_strlcpy(str, sym->name, max);
+    for (i = 0; i < count && pos < max; i++) {
+        switch (lid_flags[i]) {
+            case S7COMM_TIA1200_VAR_ENCAPS_LID:
+            case S7COMM_TIA1200_VAR_OBTAIN_LID:
+                if (sym->members == NULL) {
+                    return FALSE;
+                }
+                /* binary search for the member with this LID */
+                member = NULL;
+                lo = 0;
+                hi = sym->members->len;
+                while (lo < hi) {
+                    mid = lo + (hi - lo) / 2;
+                    member = (s7comm_dbl_sym_t *)g_ptr_array_index(sym->members, mid);
+                    if (member->lid < lid_values[i]) {
+                        lo = mid + 1;
+                    } else if (member->lid > lid_values[i]) {
+                        hi = mid;
+                    } else {
+                        break;
+                    }
+                }
+                if (lo >= hi) {
+                    return FALSE;
+                }
+                sym = member;
+                pos += g_snprintf(str + pos, (gulong)(max - pos), ".%s", sym->name);
+                break;
+            case S7COMM_TIA1200_VAR_ENCAPS_IDX:
+            case S7COMM_TIA1200_VAR_OBTAIN_IDX:
+                pos += g_snprintf(str + pos, (gulong)(max - pos), "[%u]", lid_values[i]);
+                break;
+            default:
+                /* part access of the tag, the name remains the same */
+                break;
+        }
+    }
+    return TRUE;
+}
+
+/*******************************************************************************************************
+ *
+ * Register the fields of the tags
+ *
+ *******************************************************************************************************/
+void
+s7comm_register_dblayout(int proto)
+{
+    static hf_register_info hf[] = {
+        { &hf_s7comm_tag,
+        { "Tag", "s7comm.tag", FT_NONE, BASE_NONE, NULL, 0x0,
+          "Tag from the DB layout file", HFILL }},
+        { &hf_s7comm_tag_name,
+        { "Name", "s7comm.tag.name", FT_STRING, BASE_NONE, NULL, 0x0,
+          NULL, HFILL }},
+        { &hf_s7comm_tag_datatype,
+        { "Datatype", "s7comm.tag.datatype", FT_STRING, BASE_NONE, NULL, 0x0,
+          NULL, HFILL }},
+        { &hf_s7comm_tag_value_bool,
+        { "Value", "s7comm.tag.value", FT_BOOLEAN, BASE_NONE, NULL, 0x0,
+          NULL, HFILL }},
+        { &hf_s7comm_tag_value_hex,
+        { "Value", "s7comm.tag.value", FT_UINT32, BASE_HEX, NULL, 0x0,
+          NULL, HFILL }},
+        { &hf_s7comm_tag_value_uint,
+        { "Value", "s7comm.tag.value", FT_UINT32, BASE_DEC, NULL, 0x0,
+          NULL, HFILL }},
+        { &hf_s7comm_tag_value_int,
+        { "Value", "s7comm.tag.value", FT_INT32, BASE_DEC, NULL, 0x0,
+          NULL, HFILL }},
+        { &hf_s7comm_tag_value_hex64,
+        { "Value", "s7comm.tag.value", FT_UINT64, BASE_HEX, NULL, 0x0,
+          NULL, HFILL }},
+        { &hf_s7comm_tag_value_uint64,
+        { "Value", "s7comm.tag.value", FT_UINT64, BASE_DEC, NULL, 0x0,
+          NULL, HFILL }},
+        { &hf_s7comm_tag_value_int64,
+        { "Value", "s7comm.tag.value", FT_INT64, BASE_DEC, NULL, 0x0,
+          NULL, HFILL }},
+        { &hf_s7comm_tag_value_real,
+        { "Value", "s7comm.tag.value", FT_FLOAT, BASE_NONE, NULL, 0x0,
+          NULL, HFILL }},
+        { &hf_s7comm_tag_value_lreal,
+        { "Value", "s7comm.tag.value", FT_DOUBLE, BASE_NONE, NULL, 0x0,
+          NULL, HFILL }},
+        { &hf_s7comm_tag_value_string,
+        { "Value", "s7comm.tag.value", FT_STRING, BASE_NONE, NULL, 0x0,
+          NULL, HFILL }},
+        { &hf_s7comm_tag_value_bytes,
+        { "Value", "s7comm.tag.value", FT_BYTES, BASE_NONE, NULL, 0x0,
+          NULL, HFILL }},
+    };
+
+    static gint *ett[] = {
+        &ett_s7comm_tag,
+    };
+
+    proto_register_subtree_array(ett, array_length (ett));
+    proto_register_field_array(proto, hf, array_length(hf));
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,46 @@
+/* packet-s7comm_dblayout.h
+ *
+ * Author:      Thomas Wiens, 2014 (th.wiens@gmx.de)
+ * Description: Wireshark dissector for S7-Communication
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __PACKET_S7COMM_DBLAYOUT_H__
+#define __PACKET_S7COMM_DBLAYOUT_H__
+
+void s7comm_register_dblayout(int proto);
+void s7comm_load_dblayout(const gchar *filename);
+guint32 s7comm_add_dblayout_tags_to_tree(tvbuff_t *tvb, proto_tree *tree, guint16 db, guint32 bitaddr, guint32 bitlen, guint32 offset);
+gboolean s7comm_get_dblayout_symbol(guint16 db, guint32 crc, const guint8 *lid_flags, const guint32 *lid_values, guint count, gchar *str, gsize max);
+
+#endif
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,239 @@
+/* packet-s7comm_diag.c
+ *
+ * Author:      Thomas Wiens, 2014 (th.wiens@gmx.de)
+ * Description: Wireshark dissector for S7-Communication
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**************************************************************************
+ * Export of the diagnostic buffer events for tshark
+ *
+ * -z "s7comm,diag,<file>"
+ *   Appends a CSV line to <file> for every event read from the diagnostic
+ *   buffer of a PLC (SZL-ID xyA0). A diagnostic buffer is usually polled,
+ *   and every poll returns the events of the poll before again. An event
+ *   is written only the first time it is seen from a PLC, the events are
+ *   identified by their whole record including the time stamp.
+ *   The events of a response are written oldest first, so the file is in
+ *   the order the events happened. Lines are written when the response is
+ *   dissected, as with the audit log.
+ *   A response which doesn't fit one PDU is sent in several data units,
+ *   the following ones are decoded with the header of the first one. Their
+ *   events are written per data unit, so the older events of a following
+ *   data unit come after the ones of the first data unit. Without the first
+ *   data unit in the capture, the events of the following ones are lost.
+ **************************************************************************/
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <glib.h>
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/to_str.h>
+#include <epan/stat_cmd_args.h>
+#include <wsutil/file_util.h>
+
+#include "packet-s7comm.h"
+#include "packet-s7comm_tap.h"
+
+typedef struct {
+    address addr;                           /* Address of the PLC, with own copy of the data */
+    GHashTable *seen;                       /* Records written of the PLC */
+} s7comm_diag_plc_t;
+
+typedef struct {
+    gchar *filename;
+    FILE *fh;
+    GHashTable *plcs;                       /* Address of the PLC -> s7comm_diag_plc_t */
+    guint32 n_events;
+    guint32 n_repeated;
+} s7comm_diag_t;
+
+static guint
+s7comm_diag_record_hash(gconstpointer key)
+{
+    const guint8 *record = (const guint8 *)key;
+    guint hash = 5381;
+    guint i;
+
+    for (i = 0; i < S7COMM_DIAG_RECORD_LEN; i++) {
+        hash = hash * 33 + record[i];
+    }
+    return hash;
+}
+
+static gboolean
+s7comm_diag_record_equal(gconstpointer a,
+                         gconstpointer b)
+{
+    return memcmp(a, b, S7COMM_DIAG_RECORD_LEN) == 0;
+}
+
+static void
+s7comm_diag_free_plc(gpointer data)
+{
+    s7comm_diag_plc_t *plc = (s7comm_diag_plc_t *)data;
+
+    g_hash_table_destroy(plc->seen);
+    g_free((gpointer)plc->addr.data);
+    g_free(plc);
+}
+
+static void
+s7comm_diag_write_time(FILE *fh,
+                       const nstime_t *ts)
+{
+    time_t secs;
+    struct tm *tm;
+
+    secs = ts->secs;
+    tm = localtime(&secs);
+    if (tm != NULL) {
+        fprintf(fh, "%04d-%02d-%02d %02d:%02d:%02d.%03d", tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday,
+            tm->tm_hour, tm->tm_min, tm->tm_sec, ts->nsecs / 1000000);
+    }
+}
+
+static int
+s7comm_diag_packet(void *tapdata,
+                   packet_info *pinfo,
+                   epan_dissect_t *edt _U_,
+                   const void *data)
+{
+    s7comm_diag_t *diag = (s7comm_diag_t *)tapdata;
+    const s7comm_diag_tap_t *diag_tap = (const s7comm_diag_tap_t *)data;
+    const s7comm_diag_event_t *event;
+    s7comm_diag_plc_t *plc;
+    guint16 i;
+
+    /* The responses are sent by the PLC */
+    plc = (s7comm_diag_plc_t *)g_hash_table_lookup(diag->plcs, &pinfo->src);
+    if (plc == NULL) {
+        plc = g_new0(s7comm_diag_plc_t, 1);
+        plc->addr.type = pinfo->src.type;
+        plc->addr.len = pinfo->src.len;
+        plc->addr.data = g_memdup(pinfo->src.data, pinfo->src.len);
+        plc->seen = g_hash_table_new_full(s7comm_diag_record_hash, s7comm_diag_record_equal, g_free, NULL);
+        g_hash_table_insert(diag->plcs, &plc->addr, plc);
+    }
+    for (i = diag_tap->count; i > 0; i--) {
+        event = &diag_tap->events[i - 1];
+        if (g_hash_table_lookup(plc->seen, event->record) != NULL) {
+            diag->n_repeated++;
+            continue;
+        }
+        g_hash_table_insert(plc->seen, g_memdup(event->record, S7COMM_DIAG_RECORD_LEN), GUINT_TO_POINTER(1));
+        diag->n_events++;
+        fprintf(diag->fh, "%u,", pinfo->fd->num);
+        s7comm_diag_write_time(diag->fh, &pinfo->fd->abs_ts);
+        fprintf(diag->fh, ",%s,", ep_address_to_str(&plc->addr));
+        s7comm_diag_write_time(diag->fh, &event->ts);
+        fprintf(diag->fh, ",0x%04x,%s,%u,%u,0x%04x,0x%04x,0x%08x\n", event->event_id, event->event_class,
+            event->priority, event->ob, event->dat_id, event->info1, event->info2);
+    }
+    return TRUE;
+}
+
+static void
+s7comm_diag_reset(void *tapdata)
+{
+    s7comm_diag_t *diag = (s7comm_diag_t *)tapdata;
+
+    g_hash_table_remove_all(diag->plcs);
+    diag->n_events = 0;
+    diag->n_repeated = 0;
+}
+
+static void
+s7comm_diag_draw(void *tapdata)
+{
+    s7comm_diag_t *diag = (s7comm_diag_t *)tapdata;
+
+    fflush(diag->fh);
+    printf("\n===================================================================\n");
+    printf("S7 diagnostic buffer: %u events of %u PLCs written to %s, %u repeated events skipped\n",
+        diag->n_events, g_hash_table_size(diag->plcs), diag->filename, diag->n_repeated);
+    printf("===================================================================\n");
+}
+
+/*******************************************************************************************************
+ *
+ * -z "s7comm,diag,<file>"
+ *
+ *******************************************************************************************************/
+static void
+s7comm_diag_init(const char *optarg,
+                 void *userdata _U_)
+{
+    s7comm_diag_t *diag;
+    GString *error_string;
+
+    diag = g_new0(s7comm_diag_t, 1);
+    diag->filename = g_strdup(optarg + strlen("s7comm,diag,"));
+    if (diag->filename[0] == '\0') {
+        fprintf(stderr, "tshark: invalid \"-z s7comm,diag,<file>\" argument\n");
+        exit(1);
+    }
+    diag->fh = ws_fopen(diag->filename, "a");
+    if (diag->fh == NULL) {
+        fprintf(stderr, "tshark: Can't open \"%s\": %s\n", diag->filename, g_strerror(errno));
+        exit(1);
+    }
+    setvbuf(diag->fh, NULL, _IOLBF, BUFSIZ);
+    fseek(diag->fh, 0, SEEK_END);
+    if (ftell(diag->fh) == 0) {
+        fprintf(diag->fh, "frame,time,plc,event_time,event_id,event_class,priority,ob,dat_id,info1,info2\n");
+    }
+    diag->plcs = g_hash_table_new_full(s7comm_tap_addr_hash, s7comm_tap_addr_equal, NULL, s7comm_diag_free_plc);
+
+    error_string = register_tap_listener("s7comm_diag", diag, NULL, TL_REQUIRES_NOTHING,
+        s7comm_diag_reset, s7comm_diag_packet, s7comm_diag_draw);
+    if (error_string) {
+        fprintf(stderr, "tshark: Couldn't register s7comm,diag tap: %s\n", error_string->str);
+        g_string_free(error_string, TRUE);
+        exit(1);
+    }
+}
+
+void
+s7comm_register_diag_tap(void)
+{
+    register_stat_cmd_arg("s7comm,diag,", s7comm_diag_init, NULL);
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
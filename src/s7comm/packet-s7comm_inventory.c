@@ -0,0 +1,337 @@
+/* packet-s7comm_inventory.c
+ *
+ * Author:      Thomas Wiens, 2014 (th.wiens@gmx.de)
+ * Description: Wireshark dissector for S7-Communication
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**************************************************************************
+ * PLC asset inventory for tshark
+ *
+ * -z "s7comm,inventory[,<file>]"
+ *   Keeps the latest facts about every PLC from the SZL responses in one
+ *   pass over the capture:
+ *     SZL-ID xy11  Order number, hardware version and firmware version
+ *     SZL-ID 0131  Maximum PDU size and number of connections
+ *     SZL-ID 0132  Connections in use, protection level and mode switch
+ *     SZL-ID xy24  Operating mode after the last mode transition
+ *     SZL-ID xy74  LEDs which are on or flashing
+ *   A later response replaces the facts of an earlier one. At the end a
+ *   table with one line per PLC is printed. With <file> the inventory is
+ *   also written as CSV.
+ **************************************************************************/
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/to_str.h>
+#include <epan/stat_cmd_args.h>
+#include <wsutil/file_util.h>
+
+#include "packet-s7comm.h"
+#include "packet-s7comm_tap.h"
+
+typedef struct {
+    address addr;                           /* Address of the PLC, with own copy of the data */
+    gchar *name;                            /* Address of the PLC as text */
+    guint32 first_frame;
+    guint32 last_frame;                     /* Last SZL response of the PLC */
+    guint32 n_responses;
+    gchar *order_number;
+    gchar *hardware;
+    gchar *firmware;
+    guint16 max_pdu;
+    guint16 max_connections;
+    gboolean has_conn_status;
+    guint16 used_connections;
+    guint16 protection_level;
+    gchar *mode_switch;
+    gchar *mode;
+    guint32 mode_frame;
+    gchar *leds;
+} s7comm_inventory_plc_t;
+
+typedef struct {
+    gchar *filename;                        /* CSV file, or NULL */
+    GHashTable *plcs;                       /* Address of the PLC -> s7comm_inventory_plc_t */
+} s7comm_inventory_t;
+
+static void
+s7comm_inventory_free_plc(gpointer data)
+{
+    s7comm_inventory_plc_t *plc = (s7comm_inventory_plc_t *)data;
+
+    g_free(plc->order_number);
+    g_free(plc->hardware);
+    g_free(plc->firmware);
+    g_free(plc->mode_switch);
+    g_free(plc->mode);
+    g_free(plc->leds);
+    g_free((gpointer)plc->addr.data);
+    g_free(plc->name);
+    g_free(plc);
+}
+
+/* Replace a text fact, if the response has it */
+static void
+s7comm_inventory_set_text(gchar **fact,
+                          const gchar *value)
+{
+    if (value != NULL) {
+        g_free(*fact);
+        *fact = g_strdup(value);
+    }
+}
+
+static int
+s7comm_inventory_packet(void *tapdata,
+                        packet_info *pinfo,
+                        epan_dissect_t *edt _U_,
+                        const void *data)
+{
+    s7comm_inventory_t *inventory = (s7comm_inventory_t *)tapdata;
+    const s7comm_inventory_tap_t *facts = (const s7comm_inventory_tap_t *)data;
+    s7comm_inventory_plc_t *plc;
+
+    /* The responses are sent by the PLC */
+    plc = (s7comm_inventory_plc_t *)g_hash_table_lookup(inventory->plcs, &pinfo->src);
+    if (plc == NULL) {
+        plc = g_new0(s7comm_inventory_plc_t, 1);
+        plc->addr.type = pinfo->src.type;
+        plc->addr.len = pinfo->src.len;
+        plc->addr.data = g_memdup(pinfo->src.data, pinfo->src.len);
+        plc->name = g_strdup(ep_address_to_str(&pinfo->src));
+        plc->first_frame = pinfo->fd->num;
+        g_hash_table_insert(inventory->plcs, &plc->addr, plc);
+    }
+    plc->last_frame = pinfo->fd->num;
+    plc->n_responses++;
+    s7comm_inventory_set_text(&plc->order_number, facts->order_number);
+    s7comm_inventory_set_text(&plc->hardware, facts->hardware);
+    s7comm_inventory_set_text(&plc->firmware, facts->firmware);
+    if (facts->max_pdu > 0) {
+        plc->max_pdu = facts->max_pdu;
+        plc->max_connections = facts->max_connections;
+    }
+    if (facts->has_conn_status) {
+        plc->has_conn_status = TRUE;
+        plc->used_connections = facts->used_connections;
+    }
+    if (facts->protection_level > 0) {
+        plc->protection_level = facts->protection_level;
+    }
+    s7comm_inventory_set_text(&plc->mode_switch, facts->mode_switch);
+    if (facts->mode != NULL) {
+        s7comm_inventory_set_text(&plc->mode, facts->mode);
+        plc->mode_frame = pinfo->fd->num;
+    }
+    if (facts->leds != NULL) {
+        s7comm_inventory_set_text(&plc->leds, wmem_strbuf_get_str(facts->leds));
+    }
+    return TRUE;
+}
+
+static void
+s7comm_inventory_reset(void *tapdata)
+{
+    s7comm_inventory_t *inventory = (s7comm_inventory_t *)tapdata;
+
+    g_hash_table_remove_all(inventory->plcs);
+}
+
+static gint
+s7comm_inventory_compare_plc(gconstpointer a,
+                             gconstpointer b)
+{
+    const s7comm_inventory_plc_t *plc1 = *(const s7comm_inventory_plc_t * const *)a;
+    const s7comm_inventory_plc_t *plc2 = *(const s7comm_inventory_plc_t * const *)b;
+
+    return strcmp(plc1->name, plc2->name);
+}
+
+/* A fact which was never in a response is printed as "-" */
+static const gchar *
+s7comm_inventory_text(const gchar *text)
+{
+    return (text != NULL) ? text : "-";
+}
+
+static void
+s7comm_inventory_print_plc(const s7comm_inventory_plc_t *plc)
+{
+    printf("%-15s  %-20s  %-3s  %-9s  ", plc->name, s7comm_inventory_text(plc->order_number),
+        s7comm_inventory_text(plc->hardware), s7comm_inventory_text(plc->firmware));
+    if (plc->max_pdu > 0) {
+        printf("%7u  %8u  ", plc->max_pdu, plc->max_connections);
+    } else {
+        printf("%7s  %8s  ", "-", "-");
+    }
+    if (plc->has_conn_status) {
+        printf("%7u  ", plc->used_connections);
+    } else {
+        printf("%7s  ", "-");
+    }
+    if (plc->protection_level > 0) {
+        printf("%4u  ", plc->protection_level);
+    } else {
+        printf("%4s  ", "-");
+    }
+    printf("%-6s  %-26s  %s\n", s7comm_inventory_text(plc->mode_switch), s7comm_inventory_text(plc->mode),
+        s7comm_inventory_text(plc->leds));
+}
+
+static void
+s7comm_inventory_write_csv(s7comm_inventory_t *inventory,
+                           GPtrArray *plcs)
+{
+    const s7comm_inventory_plc_t *plc;
+    guint i;
+    FILE *fh;
+
+    fh = ws_fopen(inventory->filename, "w");
+    if (fh == NULL) {
+        fprintf(stderr, "tshark: Can't write \"%s\": %s\n", inventory->filename, g_strerror(errno));
+        return;
+    }
+    fprintf(fh, "plc,order_number,hardware,firmware,max_pdu,max_connections,used_connections,"
+        "protection_level,mode_switch,mode,mode_frame,leds,first_frame,last_frame,responses\n");
+    for (i = 0; i < plcs->len; i++) {
+        plc = (const s7comm_inventory_plc_t *)g_ptr_array_index(plcs, i);
+        fprintf(fh, "%s,", plc->name);
+        s7comm_tap_write_csv_text(fh, plc->order_number);
+        fputc(',', fh);
+        s7comm_tap_write_csv_text(fh, plc->hardware);
+        fputc(',', fh);
+        s7comm_tap_write_csv_text(fh, plc->firmware);
+        fputc(',', fh);
+        if (plc->max_pdu > 0) {
+            fprintf(fh, "%u,%u,", plc->max_pdu, plc->max_connections);
+        } else {
+            fprintf(fh, ",,");
+        }
+        if (plc->has_conn_status) {
+            fprintf(fh, "%u,", plc->used_connections);
+        } else {
+            fprintf(fh, ",");
+        }
+        if (plc->protection_level > 0) {
+            fprintf(fh, "%u,", plc->protection_level);
+        } else {
+            fprintf(fh, ",");
+        }
+        s7comm_tap_write_csv_text(fh, plc->mode_switch);
+        fputc(',', fh);
+        s7comm_tap_write_csv_text(fh, plc->mode);
+        fputc(',', fh);
+        if (plc->mode != NULL) {
+            fprintf(fh, "%u,", plc->mode_frame);
+        } else {
+            fprintf(fh, ",");
+        }
+        s7comm_tap_write_csv_text(fh, plc->leds);
+        fprintf(fh, ",%u,%u,%u\n", plc->first_frame, plc->last_frame, plc->n_responses);
+    }
+    fclose(fh);
+}
+
+static void
+s7comm_inventory_draw(void *tapdata)
+{
+    s7comm_inventory_t *inventory = (s7comm_inventory_t *)tapdata;
+    GPtrArray *plcs;
+    guint i;
+
+    plcs = g_ptr_array_new();
+    g_hash_table_foreach(inventory->plcs, s7comm_tap_collect, plcs);
+    g_ptr_array_sort(plcs, s7comm_inventory_compare_plc);
+    printf("\n===================================================================\n");
+    printf("S7 PLC inventory\n");
+    printf("%-15s  %-20s  %-3s  %-9s  %7s  %8s  %7s  %4s  %-6s  %-26s  %s\n", "PLC", "Order number", "HW",
+        "Firmware", "Max PDU", "Max conn", "In use", "Prot", "Switch", "Mode", "LEDs");
+    for (i = 0; i < plcs->len; i++) {
+        s7comm_inventory_print_plc((const s7comm_inventory_plc_t *)g_ptr_array_index(plcs, i));
+    }
+    printf("===================================================================\n");
+    if (inventory->filename != NULL) {
+        s7comm_inventory_write_csv(inventory, plcs);
+    }
+    g_ptr_array_free(plcs, TRUE);
+}
+
+/*******************************************************************************************************
+ *
+ * -z "s7comm,inventory[,<file>]"
+ *
+ *******************************************************************************************************/
+static void
+s7comm_inventory_init(const char *optarg,
+                      void *userdata _U_)
+{
+    s7comm_inventory_t *inventory;
+    gchar **fields;
+    GString *error_string;
+
+    inventory = g_new0(s7comm_inventory_t, 1);
+    fields = g_strsplit(optarg, ",", 3);
+    if (g_strv_length(fields) > 2) {
+        if (fields[2][0] == '\0') {
+            fprintf(stderr, "tshark: invalid \"-z s7comm,inventory[,<file>]\" argument\n");
+            exit(1);
+        }
+        inventory->filename = g_strdup(fields[2]);
+    }
+    g_strfreev(fields);
+    inventory->plcs = g_hash_table_new_full(s7comm_tap_addr_hash, s7comm_tap_addr_equal, NULL, s7comm_inventory_free_plc);
+
+    error_string = register_tap_listener("s7comm_inventory", inventory, NULL, TL_REQUIRES_NOTHING,
+        s7comm_inventory_reset, s7comm_inventory_packet, s7comm_inventory_draw);
+    if (error_string) {
+        fprintf(stderr, "tshark: Couldn't register s7comm,inventory tap: %s\n", error_string->str);
+        g_string_free(error_string, TRUE);
+        exit(1);
+    }
+}
+
+void
+s7comm_register_inventory_tap(void)
+{
+    register_stat_cmd_arg("s7comm,inventory", s7comm_inventory_init, NULL);
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
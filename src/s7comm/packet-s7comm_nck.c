@@ -0,0 +1,425 @@
+/* packet-s7comm_nck.c
+ *
+ * Author:      Thomas Wiens, 2014 (th.wiens@gmx.de)
+ * Description: Wireshark dissector for S7-Communication
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**************************************************************************
+ * Catalog of Sinumerik NCK variables
+ *
+ * A NCK variable is addressed by area, unit, column, line and module, where
+ * area, module and column select the variable, unit and line the instance.
+ * The catalog is a text file with one variable per line, fields separated
+ * by ';', lines beginning with '#' are comments:
+ *   # area;module;column;name;datatype
+ *   C;0x7f;2;actFeedRateIpo;DOUBLE
+ *   N;0x10;1;ncType;UWORD
+ * area is the letter of the area (N, B, C, A, T, V, H, M) or its number,
+ * module and column are decimal or hexadecimal with 0x prefix.
+ * The NCK transfers the values in little endian byte order.
+ * All variables are stored in one hash table with area, module and column
+ * packed into the key, so that requests and responses need only one lookup.
+ **************************************************************************/
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+#include <epan/packet.h>
+#include <epan/report_err.h>
+
+#include "packet-s7comm.h"
+#include "packet-s7comm_nck.h"
+
+static gint ett_s7comm_nckvar = -1;
+
+static gint hf_s7comm_nckvar = -1;                          /* Variable from NCK catalog */
+static gint hf_s7comm_nckvar_name = -1;
+static gint hf_s7comm_nckvar_datatype = -1;
+static gint hf_s7comm_nckvar_line = -1;                     /* Line of the value */
+static gint hf_s7comm_nckvar_value_uint = -1;
+static gint hf_s7comm_nckvar_value_int = -1;
+static gint hf_s7comm_nckvar_value_real = -1;
+static gint hf_s7comm_nckvar_value_lreal = -1;
+static gint hf_s7comm_nckvar_value_string = -1;
+static gint hf_s7comm_nckvar_value_bytes = -1;
+
+/**************************************************************************
+ * Datatypes of NCK variables
+ */
+#define S7COMM_NCK_TYPE_BYTES               0
+#define S7COMM_NCK_TYPE_UINT                1
+#define S7COMM_NCK_TYPE_INT                 2
+#define S7COMM_NCK_TYPE_REAL                3
+#define S7COMM_NCK_TYPE_LREAL               4
+#define S7COMM_NCK_TYPE_STRING              5
+
+typedef struct {
+    const gchar *name;
+    guint8 size;                            /* Size of a value in bytes, 0 = the complete data of a line */
+    guint8 type;
+} s7comm_nck_datatype_t;
+
+static const s7comm_nck_datatype_t s7comm_nck_datatypes[] = {
+    { "BOOL",                               1,      S7COMM_NCK_TYPE_UINT },
+    { "BYTE",                               1,      S7COMM_NCK_TYPE_UINT },
+    { "CHAR",                               1,      S7COMM_NCK_TYPE_INT },
+    { "UWORD",                              2,      S7COMM_NCK_TYPE_UINT },
+    { "WORD",                               2,      S7COMM_NCK_TYPE_INT },
+    { "UINT",                               2,      S7COMM_NCK_TYPE_UINT },
+    { "INT",                                2,      S7COMM_NCK_TYPE_INT },
+    { "UDWORD",                             4,      S7COMM_NCK_TYPE_UINT },
+    { "DWORD",                              4,      S7COMM_NCK_TYPE_INT },
+    { "UDINT",                              4,      S7COMM_NCK_TYPE_UINT },
+    { "DINT",                               4,      S7COMM_NCK_TYPE_INT },
+    { "FLOAT",                              4,      S7COMM_NCK_TYPE_REAL },
+    { "REAL",                               4,      S7COMM_NCK_TYPE_REAL },
+    { "DOUBLE",                             8,      S7COMM_NCK_TYPE_LREAL },
+    { "LREAL",                              8,      S7COMM_NCK_TYPE_LREAL },
+    { "STRING",                             0,      S7COMM_NCK_TYPE_STRING },
+    { NULL,                                 0,      S7COMM_NCK_TYPE_BYTES }
+};
+
+typedef struct {
+    gchar *name;
+    gchar *datatype_name;
+    const s7comm_nck_datatype_t *datatype;  /* NULL when the datatype is unknown */
+} s7comm_nck_var_t;
+
+/* Area (3 bits) | module (8 bits) | column (16 bits) */
+#define S7COMM_NCK_KEY(area, module, column) \
+    GUINT_TO_POINTER(((guint32)(area) << 24) | ((guint32)(module) << 16) | (guint32)(column))
+
+/* Key -> s7comm_nck_var_t */
+static GHashTable *s7comm_nck_table = NULL;
+static gchar *s7comm_nck_loaded_filename = NULL;
+
+static const gchar s7comm_nck_area_letters[] = "NBCATVHM";
+
+static void
+s7comm_nck_free_var(gpointer data)
+{
+    s7comm_nck_var_t *var = (s7comm_nck_var_t *)data;
+
+    g_free(var->name);
+    g_free(var->datatype_name);
+    g_free(var);
+}
+
+/*******************************************************************************************************
+ *
+ * Parse one line of the catalog, returns FALSE if the line is not valid
+ *
+ *******************************************************************************************************/
+static gboolean
+s7comm_nck_parse_line(gchar *line)
+{
+    const s7comm_nck_datatype_t *dt;
+    s7comm_nck_var_t *var;
+    const gchar *letter;
+    gchar **fields;
+    gchar *end;
+    guint32 area;
+    guint32 module;
+    guint32 column;
+    gboolean ok = FALSE;
+
+    fields = g_strsplit(line, ";", 5);
+    if (g_strv_length(fields) < 5) {
+        g_strfreev(fields);
+        return FALSE;
+    }
+    g_strstrip(fields[0]);
+    g_strstrip(fields[3]);
+    g_strstrip(fields[4]);
+    letter = (fields[0][0] != '\0') ? strchr(s7comm_nck_area_letters, g_ascii_toupper(fields[0][0])) : NULL;
+    if (letter != NULL && fields[0][1] == '\0') {
+        area = (guint32)(letter - s7comm_nck_area_letters);
+    } else {
+        area = (guint32)strtoul(fields[0], &end, 0);
+        if (*end != '\0' || fields[0][0] == '\0') {
+            area = G_MAXUINT32;
+        }
+    }
+    module = (guint32)strtoul(fields[1], &end, 0);
+    column = (guint32)strtoul(fields[2], NULL, 0);
+    if (area <= 7 && module <= 0xff && column <= 0xffff && fields[3][0] != '\0') {
+        var = g_new0(s7comm_nck_var_t, 1);
+        var->name = g_strdup(fields[3]);
+        var->datatype_name = g_strdup(fields[4]);
+        for (dt = s7comm_nck_datatypes; dt->name != NULL; dt++) {
+            if (g_ascii_strcasecmp(fields[4], dt->name) == 0) {
+                var->datatype = dt;
+                break;
+            }
+        }
+        g_hash_table_replace(s7comm_nck_table, S7COMM_NCK_KEY(area, module, column), var);
+        ok = TRUE;
+    }
+    g_strfreev(fields);
+    return ok;
+}
+
+/*******************************************************************************************************
+ *
+ * Load the NCK variable catalog. An empty filename removes all variables.
+ *
+ *******************************************************************************************************/
+void
+s7comm_load_nck_catalog(const gchar *filename)
+{
+    GError *err = NULL;
+    gchar *contents = NULL;
+    gchar **lines;
+    gchar *line;
+    guint n_errors = 0;
+    guint first_error = 0;
+    guint i;
+
+    if (filename == NULL) {
+        filename = "";
+    }
+    if (s7comm_nck_loaded_filename != NULL && strcmp(filename, s7comm_nck_loaded_filename) == 0) {
+        return;
+    }
+    g_free(s7comm_nck_loaded_filename);
+    s7comm_nck_loaded_filename = g_strdup(filename);
+    if (s7comm_nck_table != NULL) {
+        g_hash_table_destroy(s7comm_nck_table);
+        s7comm_nck_table = NULL;
+    }
+    if (filename[0] == '\0') {
+        return;
+    }
+    if (!g_file_get_contents(filename, &contents, NULL, &err)) {
+        report_failure("S7COMM: Can't read NCK catalog %s: %s", filename, err->message);
+        g_error_free(err);
+        return;
+    }
+    s7comm_nck_table = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, s7comm_nck_free_var);
+    lines = g_strsplit(contents, "\n", -1);
+    for (i = 0; lines[i] != NULL; i++) {
+        line = g_strstrip(lines[i]);
+        if (line[0] == '\0' || line[0] == '#') {
+            continue;
+        }
+        if (!s7comm_nck_parse_line(line)) {
+            if (n_errors++ == 0) {
+                first_error = i + 1;
+            }
+        }
+    }
+    g_strfreev(lines);
+    g_free(contents);
+    if (n_errors > 0) {
+        report_failure("S7COMM: %u invalid lines in NCK catalog %s, first in line %u", n_errors, filename, first_error);
+    }
+}
+
+static const s7comm_nck_var_t *
+s7comm_nck_lookup(guint8 area,
+                  guint8 module,
+                  guint16 column)
+{
+    if (s7comm_nck_table == NULL) {
+        return NULL;
+    }
+    return (const s7comm_nck_var_t *)g_hash_table_lookup(s7comm_nck_table, S7COMM_NCK_KEY(area & 0x07, module, column));
+}
+
+/*******************************************************************************************************
+ *
+ * Get the name of a NCK variable, NULL if it's not in the catalog
+ *
+ *******************************************************************************************************/
+const gchar *
+s7comm_get_nck_var_name(guint8 area,
+                        guint8 module,
+                        guint16 column)
+{
+    const s7comm_nck_var_t *var;
+
+    var = s7comm_nck_lookup(area, module, column);
+    return (var != NULL) ? var->name : NULL;
+}
+
+/*******************************************************************************************************
+ *
+ * Add the values of a NCK variable from a read response to the tree. The data of len bytes
+ * at offset contains linecount lines, starting with line. Returns FALSE if the variable
+ * is not in the catalog.
+ *
+ *******************************************************************************************************/
+gboolean
+s7comm_add_nck_values_to_tree(tvbuff_t *tvb,
+                              proto_tree *tree,
+                              guint8 area,
+                              guint8 module,
+                              guint16 column,
+                              guint16 line,
+                              guint8 linecount,
+                              guint32 offset,
+                              guint32 len)
+{
+    const s7comm_nck_var_t *var;
+    proto_item *item = NULL;
+    proto_tree *var_tree = NULL;
+    guint8 type;
+    guint32 size;
+    guint32 i;
+    guint32 uval;
+    gint32 ival;
+    gfloat fval;
+    gdouble dval;
+    guint8 *str;
+
+    var = s7comm_nck_lookup(area, module, column);
+    if (var == NULL) {
+        return FALSE;
+    }
+    if (linecount == 0) {
+        linecount = 1;
+    }
+    type = (var->datatype != NULL) ? var->datatype->type : S7COMM_NCK_TYPE_BYTES;
+    size = (var->datatype != NULL) ? var->datatype->size : 0;
+    if (size == 0) {
+        /* strings and unknown datatypes: the data is divided into the lines */
+        size = len / linecount;
+    }
+    for (i = 0; i < linecount && size > 0 && (i + 1) * size <= len; i++) {
+        item = proto_tree_add_item(tree, hf_s7comm_nckvar, tvb, offset, size, ENC_NA);
+        var_tree = proto_item_add_subtree(item, ett_s7comm_nckvar);
+        proto_item_append_text(item, ": %s[%u] (%s)", var->name, line + i, var->datatype_name);
+        proto_tree_add_string(var_tree, hf_s7comm_nckvar_name, tvb, offset, size, var->name);
+        proto_tree_add_string(var_tree, hf_s7comm_nckvar_datatype, tvb, offset, size, var->datatype_name);
+        proto_tree_add_uint(var_tree, hf_s7comm_nckvar_line, tvb, offset, size, line + i);
+        switch (type) {
+            case S7COMM_NCK_TYPE_UINT:
+            case S7COMM_NCK_TYPE_INT:
+                switch (size) {
+                    case 1:
+                        uval = tvb_get_guint8(tvb, offset);
+                        ival = (gint8)uval;
+                        break;
+                    case 2:
+                        uval = tvb_get_letohs(tvb, offset);
+                        ival = (gint16)uval;
+                        break;
+                    default:
+                        uval = tvb_get_letohl(tvb, offset);
+                        ival = (gint32)uval;
+                        break;
+                }
+                if (type == S7COMM_NCK_TYPE_UINT) {
+                    proto_tree_add_uint(var_tree, hf_s7comm_nckvar_value_uint, tvb, offset, size, uval);
+                    proto_item_append_text(item, " = %u", uval);
+                } else {
+                    proto_tree_add_int(var_tree, hf_s7comm_nckvar_value_int, tvb, offset, size, ival);
+                    proto_item_append_text(item, " = %d", ival);
+                }
+                break;
+            case S7COMM_NCK_TYPE_REAL:
+                fval = tvb_get_letohieee_float(tvb, offset);
+                proto_tree_add_float(var_tree, hf_s7comm_nckvar_value_real, tvb, offset, size, fval);
+                proto_item_append_text(item, " = %f", fval);
+                break;
+            case S7COMM_NCK_TYPE_LREAL:
+                dval = tvb_get_letohieee_double(tvb, offset);
+                proto_tree_add_double(var_tree, hf_s7comm_nckvar_value_lreal, tvb, offset, size, dval);
+                proto_item_append_text(item, " = %f", dval);
+                break;
+            case S7COMM_NCK_TYPE_STRING:
+                str = tvb_get_string_enc(wmem_packet_scope(), tvb, offset, size, ENC_ASCII);
+                proto_tree_add_string(var_tree, hf_s7comm_nckvar_value_string, tvb, offset, size, (const gchar *)str);
+                proto_item_append_text(item, " = \"%s\"", str);
+                break;
+            default:
+                proto_tree_add_item(var_tree, hf_s7comm_nckvar_value_bytes, tvb, offset, size, ENC_NA);
+                break;
+        }
+        offset += size;
+    }
+    return TRUE;
+}
+
+/*******************************************************************************************************
+ *
+ * Register the fields of the NCK variables
+ *
+ *******************************************************************************************************/
+void
+s7comm_register_nck(int proto)
+{
+    static hf_register_info hf[] = {
+        { &hf_s7comm_nckvar,
+        { "NCK variable", "s7comm.nckvar", FT_NONE, BASE_NONE, NULL, 0x0,
+          "Variable from the NCK catalog", HFILL }},
+        { &hf_s7comm_nckvar_name,
+        { "Name", "s7comm.nckvar.name", FT_STRING, BASE_NONE, NULL, 0x0,
+          NULL, HFILL }},
+        { &hf_s7comm_nckvar_datatype,
+        { "Datatype", "s7comm.nckvar.datatype", FT_STRING, BASE_NONE, NULL, 0x0,
+          NULL, HFILL }},
+        { &hf_s7comm_nckvar_line,
+        { "Line", "s7comm.nckvar.line", FT_UINT16, BASE_DEC, NULL, 0x0,
+          NULL, HFILL }},
+        { &hf_s7comm_nckvar_value_uint,
+        { "Value", "s7comm.nckvar.value", FT_UINT32, BASE_DEC, NULL, 0x0,
+          NULL, HFILL }},
+        { &hf_s7comm_nckvar_value_int,
+        { "Value", "s7comm.nckvar.value", FT_INT32, BASE_DEC, NULL, 0x0,
+          NULL, HFILL }},
+        { &hf_s7comm_nckvar_value_real,
+        { "Value", "s7comm.nckvar.value", FT_FLOAT, BASE_NONE, NULL, 0x0,
+          NULL, HFILL }},
+        { &hf_s7comm_nckvar_value_lreal,
+        { "Value", "s7comm.nckvar.value", FT_DOUBLE, BASE_NONE, NULL, 0x0,
+          NULL, HFILL }},
+        { &hf_s7comm_nckvar_value_string,
+        { "Value", "s7comm.nckvar.value", FT_STRING, BASE_NONE, NULL, 0x0,
+          NULL, HFILL }},
+        { &hf_s7comm_nckvar_value_bytes,
+        { "Value", "s7comm.nckvar.value", FT_BYTES, BASE_NONE, NULL, 0x0,
+          NULL, HFILL }},
+    };
+
+    static gint *ett[] = {
+        &ett_s7comm_nckvar,
+    };
+
+    proto_register_subtree_array(ett, array_length (ett));
+    proto_register_field_array(proto, hf, array_length(hf));
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,417 @@
+/* packet-s7comm_pbc.c
+ *
+ * Author:      Thomas Wiens, 2014 (th.wiens@gmx.de)
+ * Description: Wireshark dissector for S7-Communication
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**************************************************************************
+ * Reassembly of PBC (BSEND/BRCV) transfers
+ *
+ * A BSEND transfer of more data than fits in one PDU is sent in segments,
+ * all with the R_ID of the transfer. The "last data unit" of the userdata
+ * parameter is set in all but the last segment. Only the first segment
+ * begins with the length of the whole data.
+ *
+ * A segment is taken as first one only when that is sure: the transfer
+ * before of the same R_ID was seen to its last segment, or it is a single
+ * segment whose length matches. If the capture starts within a transfer,
+ * its segments are shown as bytes up to its last segment.
+ *
+ * The segments are collected per connection, direction and R_ID with the
+ * reassembly functions of Wireshark. A complete message is given to the
+ * dissectors registered for its R_ID in the table "s7comm.pbc.r_id", then
+ * to the heuristic dissectors of "s7comm.pbc", otherwise it is shown as
+ * bytes. It is also passed to the tap "s7comm_pbc_eo" to export it.
+ **************************************************************************/
+
+#include "config.h"
+
+#include <glib.h>
+#include <epan/packet.h>
+#include <epan/conversation.h>
+#include <epan/expert.h>
+#include <epan/reassemble.h>
+#include <epan/tap.h>
+#include <epan/to_str.h>
+
+#include "packet-s7comm.h"
+#include "packet-s7comm_pbc.h"
+
+/* Kind of a segment */
+#define S7COMM_PBC_FIRST_SEGMENT            1
+#define S7COMM_PBC_NEXT_SEGMENT             2
+#define S7COMM_PBC_UNKNOWN_SEGMENT          3           /* The first segment of the transfer was not captured */
+
+/* Segment of a PDU, data of the frame */
+typedef struct {
+    guint8 kind;
+    guint32 total_len;                      /* Length from the first segment of the transfer */
+} s7comm_pbc_segment_t;
+
+/* Transfers of a R_ID in one direction of a connection, on the first pass */
+typedef struct {
+    gboolean synced;                        /* The last segment of a transfer was seen */
+    gboolean in_transfer;                   /* A first segment was seen, but not the last one yet */
+    guint32 total_len;
+} s7comm_pbc_transfer_t;
+
+static gint hf_s7comm_pbc_len = -1;
+static gint hf_s7comm_pbc_data = -1;
+
+static expert_field ei_s7comm_pbc_len_mismatch = EI_INIT;
+
+/* These fields used when reassembling PBC segments */
+static gint hf_s7comm_pbc_fragments = -1;
+static gint hf_s7comm_pbc_fragment = -1;
+static gint hf_s7comm_pbc_fragment_overlap = -1;
+static gint hf_s7comm_pbc_fragment_overlap_conflict = -1;
+static gint hf_s7comm_pbc_fragment_multiple_tails = -1;
+static gint hf_s7comm_pbc_fragment_too_long_fragment = -1;
+static gint hf_s7comm_pbc_fragment_error = -1;
+static gint hf_s7comm_pbc_fragment_count = -1;
+static gint hf_s7comm_pbc_reassembled_in = -1;
+static gint hf_s7comm_pbc_reassembled_length = -1;
+static gint ett_s7comm_pbc_fragment = -1;
+static gint ett_s7comm_pbc_fragments = -1;
+
+static const fragment_items s7comm_pbc_frag_items = {
+    /* Fragment subtrees */
+    &ett_s7comm_pbc_fragment,
+    &ett_s7comm_pbc_fragments,
+    /* Fragment fields */
+    &hf_s7comm_pbc_fragments,
+    &hf_s7comm_pbc_fragment,
+    &hf_s7comm_pbc_fragment_overlap,
+    &hf_s7comm_pbc_fragment_overlap_conflict,
+    &hf_s7comm_pbc_fragment_multiple_tails,
+    &hf_s7comm_pbc_fragment_too_long_fragment,
+    &hf_s7comm_pbc_fragment_error,
+    &hf_s7comm_pbc_fragment_count,
+    /* Reassembled in field */
+    &hf_s7comm_pbc_reassembled_in,
+    /* Reassembled length field */
+    &hf_s7comm_pbc_reassembled_length,
+    /* Reassembled data field */
+    NULL,
+    /* Tag */
+    "PBC segments"
+};
+
+static reassembly_table s7comm_pbc_reassembly_table;
+static wmem_tree_t *s7comm_pbc_transfers = NULL;
+static dissector_table_t s7comm_pbc_r_id_table;
+static heur_dissector_list_t s7comm_pbc_heur_subdissector_list;
+static int s7comm_pbc_eo_tap = -1;
+
+static int proto_s7comm_pbc = -1;
+
+static void
+s7comm_pbc_defragment_init(void)
+{
+    /* With the ports, as BSEND of several connections between two stations may use the same R_ID */
+    reassembly_table_init(&s7comm_pbc_reassembly_table,
+                          &addresses_ports_reassembly_table_functions);
+    s7comm_pbc_transfers = wmem_tree_new(wmem_file_scope());
+}
+
+/*******************************************************************************************************
+ *
+ * Transfers of a R_ID in the direction of the packet, created if unknown. Only on the first pass.
+ *
+ *******************************************************************************************************/
+static s7comm_pbc_transfer_t *
+s7comm_pbc_get_transfer(packet_info *pinfo,
+                        guint32 r_id)
+{
+    s7comm_pbc_transfer_t *transfer;
+    wmem_tree_key_t key[2];
+    guint32 transfer_key[3];
+    gint cmp;
+
+    cmp = cmp_address(&pinfo->src, &pinfo->dst);
+    transfer_key[0] = find_or_create_conversation(pinfo)->index;
+    transfer_key[1] = (cmp > 0 || (cmp == 0 && pinfo->srcport > pinfo->destport)) ? 1 : 0;
+    transfer_key[2] = r_id;
+    key[0].length = 3;
+    key[0].key = transfer_key;
+    key[1].length = 0;
+    key[1].key = NULL;
+    transfer = (s7comm_pbc_transfer_t *)wmem_tree_lookup32_array(s7comm_pbc_transfers, key);
+    if (transfer == NULL) {
+        transfer = wmem_new0(wmem_file_scope(), s7comm_pbc_transfer_t);
+        wmem_tree_insert32_array(s7comm_pbc_transfers, key, transfer);
+    }
+    return transfer;
+}
+
+/*******************************************************************************************************
+ *
+ * Find out on the first pass what kind of segment the PDU is, taken from the frame on the next passes
+ *
+ *******************************************************************************************************/
+static const s7comm_pbc_segment_t *
+s7comm_pbc_get_segment(tvbuff_t *tvb,
+                       packet_info *pinfo,
+                       guint32 r_id,
+                       gboolean more_data,
+                       guint32 offset,
+                       guint32 len)
+{
+    s7comm_pbc_transfer_t *transfer;
+    s7comm_pbc_segment_t *segment;
+
+    if (pinfo->fd->flags.visited) {
+        return (const s7comm_pbc_segment_t *)s7comm_get_pdu_data(pinfo, proto_s7comm_pbc, S7COMM_PROTO_DATA_PBC, r_id);
+    }
+    transfer = s7comm_pbc_get_transfer(pinfo, r_id);
+    segment = wmem_new0(wmem_file_scope(), s7comm_pbc_segment_t);
+    if (transfer->in_transfer) {
+        segment->kind = S7COMM_PBC_NEXT_SEGMENT;
+    } else if (len >= 2 && (transfer->synced || (!more_data && tvb_get_ntohs(tvb, offset) == len - 2))) {
+        segment->kind = S7COMM_PBC_FIRST_SEGMENT;
+        transfer->total_len = tvb_get_ntohs(tvb, offset);
+    } else {
+        segment->kind = S7COMM_PBC_UNKNOWN_SEGMENT;
+    }
+    segment->total_len = transfer->total_len;
+    transfer->in_transfer = more_data && segment->kind != S7COMM_PBC_UNKNOWN_SEGMENT;
+    if (!more_data) {
+        transfer->synced = TRUE;
+    }
+    s7comm_add_pdu_data(pinfo, proto_s7comm_pbc, S7COMM_PROTO_DATA_PBC, r_id, segment);
+    return segment;
+}
+
+/*******************************************************************************************************
+ *
+ * Compare the length from the first segment with the data of the transfer
+ *
+ *******************************************************************************************************/
+static void
+s7comm_pbc_check_len(packet_info *pinfo,
+                     proto_tree *tree,
+                     tvbuff_t *msg_tvb,
+                     guint32 total_len)
+{
+    proto_item *item;
+
+    if (tvb_reported_length(msg_tvb) != total_len) {
+        item = proto_tree_add_uint(tree, hf_s7comm_pbc_len, msg_tvb, 0, 0, total_len);
+        PROTO_ITEM_SET_GENERATED(item);
+        expert_add_info_format(pinfo, item, &ei_s7comm_pbc_len_mismatch,
+            "Length of the whole data %u from the first segment doesn't match the %u bytes received",
+            total_len, tvb_reported_length(msg_tvb));
+    }
+}
+
+/*******************************************************************************************************
+ *
+ * A complete message, to the subdissectors and the tap
+ *
+ *******************************************************************************************************/
+static void
+s7comm_pbc_dissect_message(tvbuff_t *msg_tvb,
+                           packet_info *pinfo,
+                           proto_tree *tree,
+                           guint32 r_id)
+{
+    s7comm_pbc_eo_t *eo;
+    heur_dtbl_entry_t *hdtbl_entry;
+    guint32 len;
+
+    len = tvb_reported_length(msg_tvb);
+    if (have_tap_listener(s7comm_pbc_eo_tap)) {
+        eo = wmem_new0(wmem_packet_scope(), s7comm_pbc_eo_t);
+        eo->pkt_num = pinfo->fd->num;
+        eo->hostname = ep_address_to_str(&pinfo->src);
+        eo->content_type = "application/octet-stream";
+        eo->filename = wmem_strdup_printf(wmem_packet_scope(), "r_id_%08x_frame_%u.bin", r_id, pinfo->fd->num);
+        eo->r_id = r_id;
+        eo->payload_len = len;
+        eo->payload_data = (const guint8 *)tvb_memdup(wmem_packet_scope(), msg_tvb, 0, len);
+        tap_queue_packet(s7comm_pbc_eo_tap, pinfo, eo);
+    }
+    if (dissector_try_uint(s7comm_pbc_r_id_table, r_id, msg_tvb, pinfo, tree)) {
+        return;
+    }
+    if (dissector_try_heuristic(s7comm_pbc_heur_subdissector_list, msg_tvb, pinfo, tree, &hdtbl_entry, NULL)) {
+        return;
+    }
+    proto_tree_add_item(tree, hf_s7comm_pbc_data, msg_tvb, 0, len, ENC_NA);
+}
+
+/*******************************************************************************************************
+ *
+ * Data of a BSEND/BRCV PDU behind the R_ID, len bytes at offset.
+ * more_data is set when the last data unit of the userdata parameter says that segments follow.
+ *
+ *******************************************************************************************************/
+guint32
+s7comm_decode_pbc_data(tvbuff_t *tvb,
+                       packet_info *pinfo,
+                       proto_tree *tree,
+                       guint32 r_id,
+                       gboolean more_data,
+                       guint32 offset,
+                       guint32 len)
+{
+    const s7comm_pbc_segment_t *segment;
+    gboolean first;
+    gboolean save_fragmented;
+    fragment_head *fd_head;
+    tvbuff_t *msg_tvb = NULL;
+    guint32 total_len;
+
+    segment = s7comm_pbc_get_segment(tvb, pinfo, r_id, more_data, offset, len);
+    if (segment == NULL || segment->kind == S7COMM_PBC_UNKNOWN_SEGMENT) {
+        col_append_str(pinfo->cinfo, COL_INFO, " (PBC segment, start of transfer not captured)");
+        proto_tree_add_item(tree, hf_s7comm_pbc_data, tvb, offset, len, ENC_NA);
+        return offset + len;
+    }
+    first = segment->kind == S7COMM_PBC_FIRST_SEGMENT;
+    if (first) {
+        total_len = tvb_get_ntohs(tvb, offset);
+        proto_tree_add_uint(tree, hf_s7comm_pbc_len, tvb, offset, 2, total_len);
+        offset += 2;
+        len -= 2;
+        if (!more_data) {
+            /* Not segmented */
+            msg_tvb = tvb_new_subset(tvb, offset, MIN(len, total_len), MIN(len, total_len));
+            s7comm_pbc_check_len(pinfo, tree, tvb_new_subset(tvb, offset, len, len), total_len);
+            s7comm_pbc_dissect_message(msg_tvb, pinfo, tree, r_id);
+            return offset + len;
+        }
+    }
+    if (len == 0) {
+        return offset;
+    }
+
+    save_fragmented = pinfo->fragmented;
+    pinfo->fragmented = TRUE;
+    /* The segments of a transfer are sent one after the other, each one is acknowledged */
+    fd_head = fragment_add_seq_next(&s7comm_pbc_reassembly_table,
+                                    tvb, offset, pinfo,
+                                    r_id,                   /* ID for fragments belonging together */
+                                    NULL,                   /* void *data */
+                                    len,                    /* fragment length - to the end */
+                                    more_data);             /* More fragments? */
+    msg_tvb = process_reassembled_data(tvb, offset, pinfo,
+                                       "Reassembled PBC", fd_head, &s7comm_pbc_frag_items,
+                                       NULL, tree);
+    pinfo->fragmented = save_fragmented;
+
+    if (msg_tvb) {
+        col_append_str(pinfo->cinfo, COL_INFO, " (PBC reassembled)");
+        s7comm_pbc_check_len(pinfo, tree, msg_tvb, segment->total_len);
+        s7comm_pbc_dissect_message(msg_tvb, pinfo, tree, r_id);
+    } else {
+        col_append_fstr(pinfo->cinfo, COL_INFO, " (PBC %s segment)", first ? "first" : "next");
+        proto_tree_add_item(tree, hf_s7comm_pbc_data, tvb, offset, len, ENC_NA);
+    }
+    return offset + len;
+}
+
+/*******************************************************************************************************
+ *
+ * Register the fields, the subdissector tables and the tap of the PBC reassembly
+ *
+ *******************************************************************************************************/
+void
+s7comm_register_pbc(int proto)
+{
+    static hf_register_info hf[] = {
+        { &hf_s7comm_pbc_len,
+        { "PBC BSEND/BRECV length", "s7comm.pbc.bsend.len", FT_UINT16, BASE_DEC, NULL, 0x0,
+          "Length of the whole data, only in the first segment", HFILL }},
+        { &hf_s7comm_pbc_data,
+        { "PBC BSEND/BRECV data", "s7comm.pbc.data", FT_BYTES, BASE_NONE, NULL, 0x0,
+          NULL, HFILL }},
+
+        /* Fragment fields */
+        { &hf_s7comm_pbc_fragment_overlap,
+          { "Fragment overlap", "s7comm.pbc.fragment.overlap", FT_BOOLEAN, BASE_NONE, NULL, 0x0,
+            "Fragment overlaps with other fragments", HFILL }},
+        { &hf_s7comm_pbc_fragment_overlap_conflict,
+          { "Conflicting data in fragment overlap", "s7comm.pbc.fragment.overlap.conflict", FT_BOOLEAN, BASE_NONE, NULL, 0x0,
+            "Overlapping fragments contained conflicting data", HFILL }},
+        { &hf_s7comm_pbc_fragment_multiple_tails,
+          { "Multiple tail fragments found", "s7comm.pbc.fragment.multipletails", FT_BOOLEAN, BASE_NONE, NULL, 0x0,
+            "Several tails were found when defragmenting the packet", HFILL }},
+        { &hf_s7comm_pbc_fragment_too_long_fragment,
+          { "Fragment too long", "s7comm.pbc.fragment.toolongfragment", FT_BOOLEAN, BASE_NONE, NULL, 0x0,
+            "Fragment contained data past end of packet", HFILL }},
+        { &hf_s7comm_pbc_fragment_error,
+          { "Defragmentation error", "s7comm.pbc.fragment.error", FT_FRAMENUM, BASE_NONE, NULL, 0x0,
+            "Defragmentation error due to illegal fragments", HFILL }},
+        { &hf_s7comm_pbc_fragment_count,
+          { "Fragment count", "s7comm.pbc.fragment.count", FT_UINT32, BASE_DEC, NULL, 0x0,
+            NULL, HFILL }},
+        { &hf_s7comm_pbc_reassembled_in,
+          { "Reassembled in", "s7comm.pbc.reassembled.in", FT_FRAMENUM, BASE_NONE, NULL, 0x0,
+            "PBC segments are reassembled in the given packet", HFILL }},
+        { &hf_s7comm_pbc_reassembled_length,
+          { "Reassembled PBC length", "s7comm.pbc.reassembled.length", FT_UINT32, BASE_DEC, NULL, 0x0,
+            "The total length of the reassembled data", HFILL }},
+        { &hf_s7comm_pbc_fragment,
+          { "PBC Fragment", "s7comm.pbc.fragment", FT_FRAMENUM, BASE_NONE, NULL, 0x0,
+            NULL, HFILL }},
+        { &hf_s7comm_pbc_fragments,
+          { "PBC Fragments", "s7comm.pbc.fragments", FT_NONE, BASE_NONE, NULL, 0x0,
+            NULL, HFILL }},
+    };
+
+    static gint *ett[] = {
+        &ett_s7comm_pbc_fragments,
+        &ett_s7comm_pbc_fragment
+    };
+
+    static ei_register_info ei[] = {
+        { &ei_s7comm_pbc_len_mismatch,
+          { "s7comm.pbc.bsend.len.mismatch", PI_MALFORMED, PI_WARN,
+            "Length of the whole data doesn't match the data received", EXPFILL }},
+    };
+
+    expert_module_t *expert_s7comm_pbc;
+
+    proto_s7comm_pbc = proto;
+    proto_register_field_array(proto, hf, array_length(hf));
+    proto_register_subtree_array(ett, array_length(ett));
+    expert_s7comm_pbc = expert_register_protocol(proto);
+    expert_register_field_array(expert_s7comm_pbc, ei, array_length(ei));
+
+    s7comm_pbc_r_id_table = register_dissector_table("s7comm.pbc.r_id", "S7 PBC BSEND/BRECV R_ID", FT_UINT32, BASE_HEX);
+    register_heur_dissector_list("s7comm.pbc", &s7comm_pbc_heur_subdissector_list);
+    s7comm_pbc_eo_tap = register_tap("s7comm_pbc_eo");
+    register_init_routine(s7comm_pbc_defragment_init);
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,620 @@
+/* packet-s7comm_shadow.c
+ *
+ * Author:      Thomas Wiens, 2014 (th.wiens@gmx.de)
+ * Description: Wireshark dissector for S7-Communication
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**************************************************************************
+ * Shadow memory of the PLCs
+ *
+ * For every PLC (by its network address) the values which were read or
+ * written are kept in a sparse memory, divided into pages of 256 bytes
+ * per area and DB. Every page holds a valid bit per byte.
+ *
+ * The memory is only updated on the first pass, which runs in frame order.
+ * When an update changes a page, a new version of the page is created with
+ * the number of the frame, unchanged values don't use any memory. So the
+ * values at any frame are found by going back from the newest version of
+ * a page to the first one which is not newer than the frame.
+ *
+ * All versions of a PLC are in a list in the order of their creation.
+ * When the memory of a PLC exceeds the limit from the preferences, the
+ * oldest versions are dropped, then older frames show the values as unknown.
+ **************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <glib.h>
+#include <epan/packet.h>
+#include <epan/prefs.h>
+#include <epan/to_str.h>
+
+#include "packet-s7comm.h"
+#include "packet-s7comm_shadow.h"
+#include "packet-s7comm_tap.h"
+
+static gint hf_s7comm_shadow_value = -1;                    /* Last known value of an item */
+
+#define S7COMM_SHADOW_PAGE_SIZE             256
+#define S7COMM_SHADOW_PAGE_SHIFT            8
+
+/* Areas of the shadow memory, 3 bits in the page key */
+#define S7COMM_SHADOW_AREA_P                0
+#define S7COMM_SHADOW_AREA_I                1
+#define S7COMM_SHADOW_AREA_Q                2
+#define S7COMM_SHADOW_AREA_M                3
+#define S7COMM_SHADOW_AREA_DB               4
+#define S7COMM_SHADOW_AREA_T                5
+#define S7COMM_SHADOW_AREA_C                6
+#define S7COMM_SHADOW_AREA_NONE             7
+
+/* Area (3 bits) | DB number (16 bits) | page number (13 bits, up to 2 MByte) */
+#define S7COMM_SHADOW_MAX_PAGE              0x1fff
+#define S7COMM_SHADOW_KEY(area, db, page) \
+    GUINT_TO_POINTER(((guint32)(area) << 29) | ((guint32)(db) << 13) | (guint32)(page))
+
+typedef struct _s7comm_shadow_version_t {
+    guint32 frame;                                  /* Frame which created this version */
+    struct _s7comm_shadow_version_t *older;         /* Previous version of the same page */
+    struct _s7comm_shadow_version_t *newer;
+    struct _s7comm_shadow_version_t *next_created;  /* Next version of the PLC in order of creation */
+    struct _s7comm_shadow_page_t *page;
+    guint8 data[S7COMM_SHADOW_PAGE_SIZE];
+    guint8 valid[S7COMM_SHADOW_PAGE_SIZE / 8];      /* One bit per byte of data */
+} s7comm_shadow_version_t;
+
+typedef struct _s7comm_shadow_page_t {
+    s7comm_shadow_version_t *newest;
+} s7comm_shadow_page_t;
+
+struct _s7comm_shadow_plc_t {
+    address addr;                           /* Network address of the PLC, with own copy of the data */
+    guint32 frame;                          /* Frame of the current update */
+    GHashTable *pages;                      /* Page key -> s7comm_shadow_page_t */
+    s7comm_shadow_version_t *oldest;        /* List of all versions in order of creation */
+    s7comm_shadow_version_t *newest;
+    gsize size;                             /* Memory of all versions in bytes */
+};
+
+/* Address -> s7comm_shadow_plc_t */
+static GHashTable *s7comm_shadow_plcs = NULL;
+static guint s7comm_shadow_max_kbytes = 1024;
+
+static void
+s7comm_shadow_free_plc(gpointer data)
+{
+    s7comm_shadow_plc_t *plc = (s7comm_shadow_plc_t *)data;
+    s7comm_shadow_version_t *version;
+
+    while (plc->oldest != NULL) {
+        version = plc->oldest;
+        plc->oldest = version->next_created;
+        g_free(version);
+    }
+    g_hash_table_destroy(plc->pages);
+    g_free((gpointer)plc->addr.data);
+    g_free(plc);
+}
+
+/*******************************************************************************************************
+ *
+ * Called at the start of every capture file, drops the memory of all PLCs
+ *
+ *******************************************************************************************************/
+static void
+s7comm_shadow_init(void)
+{
+    if (s7comm_shadow_plcs != NULL) {
+        g_hash_table_destroy(s7comm_shadow_plcs);
+    }
+    s7comm_shadow_plcs = g_hash_table_new_full(s7comm_tap_addr_hash, s7comm_tap_addr_equal,
+        NULL, s7comm_shadow_free_plc);
+}
+
+/*******************************************************************************************************
+ *
+ * Get the shadow memory of the PLC with address addr, for updates from the current packet.
+ * Returns NULL if the packet was already visited, or if the shadow memory is disabled.
+ *
+ *******************************************************************************************************/
+s7comm_shadow_plc_t *
+s7comm_shadow_get_plc(packet_info *pinfo,
+                      const address *addr)
+{
+    s7comm_shadow_plc_t *plc;
+
+    if (pinfo->fd->flags.visited || s7comm_shadow_max_kbytes == 0 || s7comm_shadow_plcs == NULL) {
+        return NULL;
+    }
+    plc = s7comm_shadow_find_plc(addr);
+    if (plc == NULL) {
+        plc = g_new0(s7comm_shadow_plc_t, 1);
+        plc->addr.type = addr->type;
+        plc->addr.len = addr->len;
+        plc->addr.data = g_memdup(addr->data, addr->len);
+        plc->pages = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+        g_hash_table_insert(s7comm_shadow_plcs, &plc->addr, plc);
+    }
+    plc->frame = pinfo->fd->num;
+    return plc;
+}
+
+/*******************************************************************************************************
+ *
+ * Get the shadow memory of a PLC for lookups, NULL if nothing is known of this PLC
+ *
+ *******************************************************************************************************/
+s7comm_shadow_plc_t *
+s7comm_shadow_find_plc(const address *addr)
+{
+    if (s7comm_shadow_plcs == NULL) {
+        return NULL;
+    }
+    return (s7comm_shadow_plc_t *)g_hash_table_lookup(s7comm_shadow_plcs, addr);
+}
+
+typedef struct {
+    const gchar *name;
+    s7comm_shadow_plc_t *plc;
+} s7comm_shadow_name_lookup_t;
+
+static void
+s7comm_shadow_match_name(gpointer key _U_,
+                         gpointer value,
+                         gpointer user_data)
+{
+    s7comm_shadow_plc_t *plc = (s7comm_shadow_plc_t *)value;
+    s7comm_shadow_name_lookup_t *lookup = (s7comm_shadow_name_lookup_t *)user_data;
+
+    if (lookup->plc == NULL && strcmp(ep_address_to_str(&plc->addr), lookup->name) == 0) {
+        lookup->plc = plc;
+    }
+}
+
+/*******************************************************************************************************
+ *
+ * Get the shadow memory of a PLC by its address as text (e.g. "192.168.0.1"), NULL if nothing is known
+ *
+ *******************************************************************************************************/
+s7comm_shadow_plc_t *
+s7comm_shadow_find_plc_by_name(const gchar *name)
+{
+    s7comm_shadow_name_lookup_t lookup;
+
+    if (s7comm_shadow_plcs == NULL) {
+        return NULL;
+    }
+    lookup.name = name;
+    lookup.plc = NULL;
+    g_hash_table_foreach(s7comm_shadow_plcs, s7comm_shadow_match_name, &lookup);
+    return lookup.plc;
+}
+
+/* Area of the shadow memory of an area of a S7ANY address. Instance DBs are DBs. */
+static guint8
+s7comm_shadow_get_area(guint8 area)
+{
+    switch (area) {
+        case S7COMM_AREA_P:
+            return S7COMM_SHADOW_AREA_P;
+        case S7COMM_AREA_INPUTS:
+            return S7COMM_SHADOW_AREA_I;
+        case S7COMM_AREA_OUTPUTS:
+            return S7COMM_SHADOW_AREA_Q;
+        case S7COMM_AREA_FLAGS:
+            return S7COMM_SHADOW_AREA_M;
+        case S7COMM_AREA_DB:
+        case S7COMM_AREA_DI:
+            return S7COMM_SHADOW_AREA_DB;
+        case S7COMM_AREA_TIMER:
+            return S7COMM_SHADOW_AREA_T;
+        case S7COMM_AREA_COUNTER:
+            return S7COMM_SHADOW_AREA_C;
+        default:
+            return S7COMM_SHADOW_AREA_NONE;
+    }
+}
+
+/* Drop the oldest versions of a PLC until it fits into the limit */
+static void
+s7comm_shadow_limit(s7comm_shadow_plc_t *plc)
+{
+    s7comm_shadow_version_t *version;
+
+    while (plc->size > (gsize)s7comm_shadow_max_kbytes * 1024 && plc->oldest != NULL && plc->oldest != plc->newest) {
+        version = plc->oldest;
+        plc->oldest = version->next_created;
+        if (version->newer != NULL) {
+            version->newer->older = NULL;
+        } else {
+            version->page->newest = NULL;
+        }
+        plc->size -= sizeof(s7comm_shadow_version_t);
+        g_free(version);
+    }
+}
+
+/*******************************************************************************************************
+ *
+ * Get a version of a page to write into for the current frame. Returns NULL when the
+ * data to write is already known with the same values, then nothing needs to be changed.
+ *
+ *******************************************************************************************************/
+static s7comm_shadow_version_t *
+s7comm_shadow_get_writable(s7comm_shadow_plc_t *plc,
+                           gpointer key,
+                           const guint8 *data,
+                           guint32 start,
+                           guint32 len)
+{
+    s7comm_shadow_page_t *page;
+    s7comm_shadow_version_t *newest;
+    s7comm_shadow_version_t *version;
+    guint32 i;
+
+    page = (s7comm_shadow_page_t *)g_hash_table_lookup(plc->pages, key);
+    if (page == NULL) {
+        page = g_new0(s7comm_shadow_page_t, 1);
+        g_hash_table_insert(plc->pages, key, page);
+    }
+    newest = page->newest;
+    if (newest != NULL) {
+        if (newest->frame == plc->frame) {
+            return newest;
+        }
+        for (i = start; i < start + len; i++) {
+            if (!(newest->valid[i / 8] & (1 << (i % 8))) || newest->data[i] != data[i - start]) {
+                break;
+            }
+        }
+        if (i == start + len) {
+            return NULL;
+        }
+        version = (s7comm_shadow_version_t *)g_memdup(newest, sizeof(s7comm_shadow_version_t));
+        newest->newer = version;
+    } else {
+        version = g_new0(s7comm_shadow_version_t, 1);
+    }
+    version->frame = plc->frame;
+    version->older = newest;
+    version->newer = NULL;
+    version->next_created = NULL;
+    version->page = page;
+    page->newest = version;
+    if (plc->newest != NULL) {
+        plc->newest->next_created = version;
+    } else {
+        plc->oldest = version;
+    }
+    plc->newest = version;
+    plc->size += sizeof(s7comm_shadow_version_t);
+    return version;
+}
+
+/*******************************************************************************************************
+ *
+ * Write len bytes from the tvb to the shadow memory. area is the area of the S7ANY address,
+ * for timers and counters start is the number of the first timer/counter, which use 2 bytes each.
+ *
+ *******************************************************************************************************/
+void
+s7comm_shadow_write(s7comm_shadow_plc_t *plc,
+                    guint8 area,
+                    guint16 db,
+                    guint32 start,
+                    tvbuff_t *tvb,
+                    guint32 offset,
+                    guint32 len)
+{
+    s7comm_shadow_version_t *version;
+    guint8 data[S7COMM_SHADOW_PAGE_SIZE];
+    guint8 shadow_area;
+    guint32 page_no;
+    guint32 page_start;
+    guint32 n;
+    guint32 i;
+
+    shadow_area = s7comm_shadow_get_area(area);
+    if (plc == NULL || shadow_area == S7COMM_SHADOW_AREA_NONE || len == 0 || !tvb_bytes_exist(tvb, offset, len)) {
+        return;
+    }
+    if (shadow_area != S7COMM_SHADOW_AREA_DB) {
+        db = 0;
+    }
+    if (shadow_area == S7COMM_SHADOW_AREA_T || shadow_area == S7COMM_SHADOW_AREA_C) {
+        start *= 2;
+    }
+    while (len > 0) {
+        page_no = start >> S7COMM_SHADOW_PAGE_SHIFT;
+        if (page_no > S7COMM_SHADOW_MAX_PAGE) {
+            break;
+        }
+        page_start = start % S7COMM_SHADOW_PAGE_SIZE;
+        n = MIN(len, S7COMM_SHADOW_PAGE_SIZE - page_start);
+        tvb_memcpy(tvb, data, offset, n);
+        version = s7comm_shadow_get_writable(plc, S7COMM_SHADOW_KEY(shadow_area, db, page_no), data, page_start, n);
+        if (version != NULL) {
+            memcpy(&version->data[page_start], data, n);
+            for (i = page_start; i < page_start + n; i++) {
+                version->valid[i / 8] |= (1 << (i % 8));
+            }
+        }
+        start += n;
+        offset += n;
+        len -= n;
+    }
+    s7comm_shadow_limit(plc);
+}
+
+/*******************************************************************************************************
+ *
+ * Write a single bit. As validity is kept per byte, the bit is only stored when the value of
+ * the byte is already known.
+ *
+ *******************************************************************************************************/
+void
+s7comm_shadow_write_bit(s7comm_shadow_plc_t *plc,
+                        guint8 area,
+                        guint16 db,
+                        guint32 bitaddr,
+                        gboolean value)
+{
+    s7comm_shadow_page_t *page;
+    s7comm_shadow_version_t *version;
+    guint8 shadow_area;
+    guint32 start;
+    guint32 page_no;
+    guint8 data;
+
+    shadow_area = s7comm_shadow_get_area(area);
+    if (plc == NULL || shadow_area == S7COMM_SHADOW_AREA_NONE ||
+        shadow_area == S7COMM_SHADOW_AREA_T || shadow_area == S7COMM_SHADOW_AREA_C) {
+        return;
+    }
+    if (shadow_area != S7COMM_SHADOW_AREA_DB) {
+        db = 0;
+    }
+    start = bitaddr / 8;
+    page_no = start >> S7COMM_SHADOW_PAGE_SHIFT;
+    if (page_no > S7COMM_SHADOW_MAX_PAGE) {
+        return;
+    }
+    start %= S7COMM_SHADOW_PAGE_SIZE;
+    page = (s7comm_shadow_page_t *)g_hash_table_lookup(plc->pages, S7COMM_SHADOW_KEY(shadow_area, db, page_no));
+    if (page == NULL || page->newest == NULL || !(page->newest->valid[start / 8] & (1 << (start % 8)))) {
+        return;
+    }
+    data = page->newest->data[start];
+    if (value) {
+        data |= (1 << (bitaddr % 8));
+    } else {
+        data &= ~(1 << (bitaddr % 8));
+    }
+    version = s7comm_shadow_get_writable(plc, S7COMM_SHADOW_KEY(shadow_area, db, page_no), &data, start, 1);
+    if (version != NULL) {
+        version->data[start] = data;
+    }
+    s7comm_shadow_limit(plc);
+}
+
+/*******************************************************************************************************
+ *
+ * Read the values of len bytes as they were known at the given frame. Bytes with unknown value
+ * are set to 0. If valid is not NULL, a bit is set there for every known byte (LSB first).
+ * Returns the number of bytes with known value.
+ *
+ *******************************************************************************************************/
+guint32
+s7comm_shadow_read(s7comm_shadow_plc_t *plc,
+                   guint8 area,
+                   guint16 db,
+                   guint32 start,
+                   guint32 len,
+                   guint32 frame,
+                   guint8 *buf,
+                   guint8 *valid)
+{
+    s7comm_shadow_page_t *page;
+    s7comm_shadow_version_t *version;
+    guint8 shadow_area;
+    guint32 page_no;
+    guint32 i;
+    guint32 known = 0;
+
+    memset(buf, 0, len);
+    if (valid != NULL) {
+        memset(valid, 0, (len + 7) / 8);
+    }
+    shadow_area = s7comm_shadow_get_area(area);
+    if (plc == NULL || shadow_area == S7COMM_SHADOW_AREA_NONE) {
+        return 0;
+    }
+    if (shadow_area != S7COMM_SHADOW_AREA_DB) {
+        db = 0;
+    }
+    if (shadow_area == S7COMM_SHADOW_AREA_T || shadow_area == S7COMM_SHADOW_AREA_C) {
+        start *= 2;
+    }
+    version = NULL;
+    page_no = G_MAXUINT32;
+    for (i = 0; i < len; i++, start++) {
+        if ((start >> S7COMM_SHADOW_PAGE_SHIFT) != page_no) {
+            page_no = start >> S7COMM_SHADOW_PAGE_SHIFT;
+            if (page_no > S7COMM_SHADOW_MAX_PAGE) {
+                break;
+            }
+            page = (s7comm_shadow_page_t *)g_hash_table_lookup(plc->pages, S7COMM_SHADOW_KEY(shadow_area, db, page_no));
+            version = (page != NULL) ? page->newest : NULL;
+            while (version != NULL && version->frame > frame) {
+                version = version->older;
+            }
+        }
+        if (version != NULL && (version->valid[(start % S7COMM_SHADOW_PAGE_SIZE) / 8] & (1 << (start % 8)))) {
+            buf[i] = version->data[start % S7COMM_SHADOW_PAGE_SIZE];
+            if (valid != NULL) {
+                valid[i / 8] |= (1 << (i % 8));
+            }
+            known++;
+        }
+    }
+    return known;
+}
+
+typedef struct {
+    guint32 key_from;
+    guint32 key_to;
+    guint32 frame;
+    guint32 size;
+} s7comm_shadow_size_lookup_t;
+
+static void
+s7comm_shadow_match_size(gpointer key,
+                         gpointer value,
+                         gpointer user_data)
+{
+    s7comm_shadow_page_t *page = (s7comm_shadow_page_t *)value;
+    s7comm_shadow_size_lookup_t *lookup = (s7comm_shadow_size_lookup_t *)user_data;
+    s7comm_shadow_version_t *version;
+    guint32 page_key = GPOINTER_TO_UINT(key);
+    guint32 page_end;
+    gint i;
+
+    if (page_key < lookup->key_from || page_key > lookup->key_to) {
+        return;
+    }
+    version = page->newest;
+    while (version != NULL && version->frame > lookup->frame) {
+        version = version->older;
+    }
+    if (version == NULL) {
+        return;
+    }
+    for (i = S7COMM_SHADOW_PAGE_SIZE - 1; i >= 0; i--) {
+        if (version->valid[i / 8] & (1 << (i % 8))) {
+            page_end = (page_key - lookup->key_from) * S7COMM_SHADOW_PAGE_SIZE + (guint32)i + 1;
+            if (page_end > lookup->size) {
+                lookup->size = page_end;
+            }
+            break;
+        }
+    }
+}
+
+/*******************************************************************************************************
+ *
+ * Size in bytes of an area or DB up to the last byte known at the given frame, 0 if nothing is known
+ *
+ *******************************************************************************************************/
+guint32
+s7comm_shadow_get_size(s7comm_shadow_plc_t *plc,
+                       guint8 area,
+                       guint16 db,
+                       guint32 frame)
+{
+    s7comm_shadow_size_lookup_t lookup;
+    guint8 shadow_area;
+
+    shadow_area = s7comm_shadow_get_area(area);
+    if (plc == NULL || shadow_area == S7COMM_SHADOW_AREA_NONE) {
+        return 0;
+    }
+    if (shadow_area != S7COMM_SHADOW_AREA_DB) {
+        db = 0;
+    }
+    lookup.key_from = GPOINTER_TO_UINT(S7COMM_SHADOW_KEY(shadow_area, db, 0));
+    lookup.key_to = GPOINTER_TO_UINT(S7COMM_SHADOW_KEY(shadow_area, db, S7COMM_SHADOW_MAX_PAGE));
+    lookup.frame = frame;
+    lookup.size = 0;
+    g_hash_table_foreach(plc->pages, s7comm_shadow_match_size, &lookup);
+    return lookup.size;
+}
+
+/*******************************************************************************************************
+ *
+ * Add the last known value of an item before the given frame to the tree, if all bytes are known
+ *
+ *******************************************************************************************************/
+void
+s7comm_shadow_add_value_to_tree(tvbuff_t *tvb,
+                                proto_tree *tree,
+                                s7comm_shadow_plc_t *plc,
+                                guint8 area,
+                                guint16 db,
+                                guint32 start,
+                                guint32 len,
+                                guint32 frame,
+                                guint8 item_no)
+{
+    proto_item *item = NULL;
+    tvbuff_t *value_tvb;
+    guint8 *buf;
+
+    if (plc == NULL || len == 0 || frame == 0) {
+        return;
+    }
+    buf = (guint8 *)wmem_alloc(wmem_packet_scope(), len);
+    if (s7comm_shadow_read(plc, area, db, start, len, frame - 1, buf, NULL) == len) {
+        /* The value is not in this packet, give it an own tvb */
+        value_tvb = tvb_new_child_real_data(tvb, buf, len, len);
+        item = proto_tree_add_item(tree, hf_s7comm_shadow_value, value_tvb, 0, len, ENC_NA);
+        proto_item_append_text(item, " (Item [%d])", item_no + 1);
+        PROTO_ITEM_SET_GENERATED(item);
+    }
+}
+
+/*******************************************************************************************************
+ *
+ * Register the fields and the preference of the shadow memory
+ *
+ *******************************************************************************************************/
+void
+s7comm_register_shadow(int proto,
+                       module_t *module)
+{
+    static hf_register_info hf[] = {
+        { &hf_s7comm_shadow_value,
+        { "Last known value", "s7comm.shadow.value", FT_BYTES, BASE_NONE, NULL, 0x0,
+          "Value of the item as last seen in the capture before this frame", HFILL }},
+    };
+
+    proto_register_field_array(proto, hf, array_length(hf));
+    prefs_register_uint_preference(module, "shadow_max_kbytes",
+        "Shadow memory per PLC (kByte)",
+        "Maximum memory for the values seen of a PLC, older values are dropped first. 0 disables the shadow memory",
+        10, &s7comm_shadow_max_kbytes);
+    register_init_routine(s7comm_shadow_init);
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
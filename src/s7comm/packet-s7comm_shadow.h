@@ -0,0 +1,53 @@
+/* packet-s7comm_shadow.h
+ *
+ * Author:      Thomas Wiens, 2014 (th.wiens@gmx.de)
+ * Description: Wireshark dissector for S7-Communication
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __PACKET_S7COMM_SHADOW_H__
+#define __PACKET_S7COMM_SHADOW_H__
+
+typedef struct _s7comm_shadow_plc_t s7comm_shadow_plc_t;
+
+void s7comm_register_shadow(int proto, module_t *module);
+s7comm_shadow_plc_t *s7comm_shadow_get_plc(packet_info *pinfo, const address *addr);
+s7comm_shadow_plc_t *s7comm_shadow_find_plc(const address *addr);
+s7comm_shadow_plc_t *s7comm_shadow_find_plc_by_name(const gchar *name);
+void s7comm_shadow_write(s7comm_shadow_plc_t *plc, guint8 area, guint16 db, guint32 start, tvbuff_t *tvb, guint32 offset, guint32 len);
+void s7comm_shadow_write_bit(s7comm_shadow_plc_t *plc, guint8 area, guint16 db, guint32 bitaddr, gboolean value);
+guint32 s7comm_shadow_read(s7comm_shadow_plc_t *plc, guint8 area, guint16 db, guint32 start, guint32 len, guint32 frame, guint8 *buf, guint8 *valid);
+guint32 s7comm_shadow_get_size(s7comm_shadow_plc_t *plc, guint8 area, guint16 db, guint32 frame);
+void s7comm_shadow_add_value_to_tree(tvbuff_t *tvb, proto_tree *tree, s7comm_shadow_plc_t *plc, guint8 area, guint16 db, guint32 start, guint32 len, guint32 frame, guint8 item_no);
+
+#endif
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,443 @@
+/* packet-s7comm_symbols.c
+ *
+ * Author:      Thomas Wiens, 2014 (th.wiens@gmx.de)
+ * Description: Wireshark dissector for S7-Communication
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**************************************************************************
+ * Symbol table of a STEP 7 (S7-300/400) project
+ *
+ * The symbol editor exports the table in two formats:
+ * ASCII (*.asc), with fixed columns after the record type 126:
+ *   126,Motor_On                I       0.0 BOOL      Motor on
+ * System Data Format (*.sdf), with quoted and comma separated fields:
+ *   "Motor_On","I       0.0","BOOL","Motor on"
+ * The addresses may use the english or german mnemonics (I/E, Q/A, C/Z).
+ *
+ * Every symbol covers an interval of an area, in bits for I/Q/M/P/DB, and in
+ * numbers for timers and counters. The intervals of an area are stored in an
+ * array sorted by the start address. As intervals may overlap (MW10 and M10.0),
+ * every entry also holds the highest end address of all entries up to itself,
+ * so that a lookup only needs a binary search and a short walk backwards.
+ * Symbols of whole data blocks (DB 10) are used for addresses in the DB which
+ * have no own symbol.
+ **************************************************************************/
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+#include <epan/packet.h>
+#include <epan/report_err.h>
+
+#include "packet-s7comm.h"
+#include "packet-s7comm_symbols.h"
+
+typedef struct {
+    guint32 start;                          /* Bit address, or number of timer/counter */
+    guint32 end;                            /* First address behind the symbol */
+    guint32 max_end;                        /* Highest end of this and all previous intervals */
+    gchar *symbol;
+} s7comm_sym_interval_t;
+
+/* Key of an area in the index, DB number in the lower 16 bits */
+#define S7COMM_SYM_KEY(area, db)            GUINT_TO_POINTER(((guint32)(area) << 16) | (db))
+
+/* Area key -> GArray of s7comm_sym_interval_t */
+static GHashTable *s7comm_sym_index = NULL;
+/* DB number -> symbol of the whole DB */
+static GHashTable *s7comm_sym_dbs = NULL;
+static gchar *s7comm_sym_loaded_filename = NULL;
+
+/**************************************************************************
+ * Mnemonics of the addresses. Size is in bits per address, 0 for timers
+ * and counters, where the address is the number.
+ */
+typedef struct {
+    const gchar *mnemonic;
+    guint8 area;
+    guint8 size;
+} s7comm_sym_operand_t;
+
+static const s7comm_sym_operand_t s7comm_sym_operands[] = {
+    { "I",                                  S7COMM_AREA_INPUTS,     1 },
+    { "IB",                                 S7COMM_AREA_INPUTS,     8 },
+    { "IW",                                 S7COMM_AREA_INPUTS,     16 },
+    { "ID",                                 S7COMM_AREA_INPUTS,     32 },
+    { "E",                                  S7COMM_AREA_INPUTS,     1 },
+    { "EB",                                 S7COMM_AREA_INPUTS,     8 },
+    { "EW",                                 S7COMM_AREA_INPUTS,     16 },
+    { "ED",                                 S7COMM_AREA_INPUTS,     32 },
+    { "Q",                                  S7COMM_AREA_OUTPUTS,    1 },
+    { "QB",                                 S7COMM_AREA_OUTPUTS,    8 },
+    { "QW",                                 S7COMM_AREA_OUTPUTS,    16 },
+    { "QD",                                 S7COMM_AREA_OUTPUTS,    32 },
+    { "A",                                  S7COMM_AREA_OUTPUTS,    1 },
+    { "AB",                                 S7COMM_AREA_OUTPUTS,    8 },
+    { "AW",                                 S7COMM_AREA_OUTPUTS,    16 },
+    { "AD",                                 S7COMM_AREA_OUTPUTS,    32 },
+    { "M",                                  S7COMM_AREA_FLAGS,      1 },
+    { "MB",                                 S7COMM_AREA_FLAGS,      8 },
+    { "MW",                                 S7COMM_AREA_FLAGS,      16 },
+    { "MD",                                 S7COMM_AREA_FLAGS,      32 },
+    { "PIB",                                S7COMM_AREA_P,          8 },
+    { "PIW",                                S7COMM_AREA_P,          16 },
+    { "PID",                                S7COMM_AREA_P,          32 },
+    { "PQB",                                S7COMM_AREA_P,          8 },
+    { "PQW",                                S7COMM_AREA_P,          16 },
+    { "PQD",                                S7COMM_AREA_P,          32 },
+    { "PEB",                                S7COMM_AREA_P,          8 },
+    { "PEW",                                S7COMM_AREA_P,          16 },
+    { "PED",                                S7COMM_AREA_P,          32 },
+    { "PAB",                                S7COMM_AREA_P,          8 },
+    { "PAW",                                S7COMM_AREA_P,          16 },
+    { "PAD",                                S7COMM_AREA_P,          32 },
+    { "T",                                  S7COMM_AREA_TIMER,      0 },
+    { "C",                                  S7COMM_AREA_COUNTER,    0 },
+    { "Z",                                  S7COMM_AREA_COUNTER,    0 },
+    { "DBX",                                S7COMM_AREA_DB,         1 },
+    { "DBB",                                S7COMM_AREA_DB,         8 },
+    { "DBW",                                S7COMM_AREA_DB,         16 },
+    { "DBD",                                S7COMM_AREA_DB,         32 },
+    { NULL,                                 0,                      0 }
+};
+
+/*******************************************************************************************************
+ *
+ * Parse an absolute address like "M 10.0", "MW 10", "T 5", "DB10.DBW 2" or "DB 10".
+ * Returns FALSE for addresses which are not accessible with S7ANY (blocks etc.).
+ * For the symbol of a whole DB the area is S7COMM_AREA_DB and size is 0.
+ *
+ *******************************************************************************************************/
+static gboolean
+s7comm_sym_parse_address(const gchar *address,
+                         guint8 *area,
+                         guint16 *db,
+                         guint32 *start,
+                         guint32 *size)
+{
+    const s7comm_sym_operand_t *op;
+    gchar mnemonic[8];
+    const gchar *p = address;
+    gchar *end;
+    guint32 byte;
+    guint i;
+
+    *db = 0;
+    while (*p == ' ') p++;
+    for (i = 0; g_ascii_isalpha(*p) && i < sizeof(mnemonic) - 1; i++, p++) {
+        mnemonic[i] = g_ascii_toupper(*p);
+    }
+    mnemonic[i] = '\0';
+    while (*p == ' ') p++;
+    if (!g_ascii_isdigit(*p)) {
+        return FALSE;
+    }
+    if (strcmp(mnemonic, "DB") == 0) {
+        *db = (guint16)strtoul(p, &end, 10);
+        if (*end != '.') {
+            /* Symbol of the DB itself */
+            *area = S7COMM_AREA_DB;
+            *start = 0;
+            *size = 0;
+            return TRUE;
+        }
+        /* DB10.DBX 4.0 */
+        p = end + 1;
+        for (i = 0; g_ascii_isalpha(*p) && i < sizeof(mnemonic) - 1; i++, p++) {
+            mnemonic[i] = g_ascii_toupper(*p);
+        }
+        mnemonic[i] = '\0';
+        while (*p == ' ') p++;
+        if (!g_ascii_isdigit(*p)) {
+            return FALSE;
+        }
+    }
+    for (op = s7comm_sym_operands; op->mnemonic != NULL; op++) {
+        if (strcmp(mnemonic, op->mnemonic) == 0) {
+            break;
+        }
+    }
+    if (op->mnemonic == NULL || (op->area == S7COMM_AREA_DB && *db == 0)) {
+        return FALSE;
+    }
+    *area = op->area;
+    byte = (guint32)strtoul(p, &end, 10);
+    if (op->size == 0) {
+        *start = byte;
+        *size = 1;
+    } else if (op->size == 1) {
+        *start = byte * 8;
+        if (*end == '.') {
+            *start += (guint32)strtoul(end + 1, NULL, 10) & 0x07;
+        }
+        *size = 1;
+    } else {
+        *start = byte * 8;
+        *size = op->size;
+    }
+    return TRUE;
+}
+
+static void
+s7comm_sym_free_index(gpointer data)
+{
+    GArray *intervals = (GArray *)data;
+    guint i;
+
+    for (i = 0; i < intervals->len; i++) {
+        g_free(g_array_index(intervals, s7comm_sym_interval_t, i).symbol);
+    }
+    g_array_free(intervals, TRUE);
+}
+
+static void
+s7comm_sym_add(const gchar *symbol,
+               const gchar *address)
+{
+    s7comm_sym_interval_t interval;
+    GArray *intervals;
+    guint8 area;
+    guint16 db;
+    guint32 start;
+    guint32 size;
+
+    if (symbol[0] == '\0' || !s7comm_sym_parse_address(address, &area, &db, &start, &size)) {
+        return;
+    }
+    if (area == S7COMM_AREA_DB && size == 0) {
+        g_hash_table_replace(s7comm_sym_dbs, GUINT_TO_POINTER((guint32)db), g_strdup(symbol));
+        return;
+    }
+    intervals = (GArray *)g_hash_table_lookup(s7comm_sym_index, S7COMM_SYM_KEY(area, db));
+    if (intervals == NULL) {
+        intervals = g_array_new(FALSE, FALSE, sizeof(s7comm_sym_interval_t));
+        g_hash_table_insert(s7comm_sym_index, S7COMM_SYM_KEY(area, db), intervals);
+    }
+    interval.start = start;
+    interval.end = start + size;
+    interval.max_end = 0;
+    interval.symbol = g_strdup(symbol);
+    g_array_append_val(intervals, interval);
+}
+
+static gint
+s7comm_sym_compare_intervals(gconstpointer a,
+                             gconstpointer b)
+{
+    const s7comm_sym_interval_t *ia = (const s7comm_sym_interval_t *)a;
+    const s7comm_sym_interval_t *ib = (const s7comm_sym_interval_t *)b;
+
+    if (ia->start != ib->start) {
+        return (ia->start < ib->start) ? -1 : 1;
+    }
+    if (ia->end != ib->end) {
+        return (ia->end < ib->end) ? -1 : 1;
+    }
+    return 0;
+}
+
+/* Sort the intervals of an area and set the running maximum of the end addresses */
+static void
+s7comm_sym_build_index(gpointer key _U_,
+                       gpointer value,
+                       gpointer user_data _U_)
+{
+    GArray *intervals = (GArray *)value;
+    s7comm_sym_interval_t *interval;
+    guint32 max_end = 0;
+    guint i;
+
+    g_array_sort(intervals, s7comm_sym_compare_intervals);
+    for (i = 0; i < intervals->len; i++) {
+        interval = &g_array_index(intervals, s7comm_sym_interval_t, i);
+        if (interval->end > max_end) {
+            max_end = interval->end;
+        }
+        interval->max_end = max_end;
+    }
+}
+
+/* Copy a field of fixed width from an ASCII export line, and remove the padding */
+static gchar *
+s7comm_sym_get_column(const gchar *line,
+                      gsize line_len,
+                      gsize start,
+                      gsize width)
+{
+    if (start >= line_len) {
+        return g_strdup("");
+    }
+    if (start + width > line_len) {
+        width = line_len - start;
+    }
+    return g_strstrip(g_strndup(line + start, width));
+}
+
+/*******************************************************************************************************
+ *
+ * Load a symbol table in ASCII or SDF format. An empty filename removes all symbols.
+ *
+ *******************************************************************************************************/
+void
+s7comm_load_symbols(const gchar *filename)
+{
+    GError *err = NULL;
+    gchar *contents = NULL;
+    gchar **lines;
+    gchar **fields;
+    gchar *line;
+    gchar *symbol;
+    gchar *address;
+    gsize line_len;
+    guint i;
+
+    if (filename == NULL) {
+        filename = "";
+    }
+    if (s7comm_sym_loaded_filename != NULL && strcmp(filename, s7comm_sym_loaded_filename) == 0) {
+        return;
+    }
+    g_free(s7comm_sym_loaded_filename);
+    s7comm_sym_loaded_filename = g_strdup(filename);
+    if (s7comm_sym_index != NULL) {
+        g_hash_table_destroy(s7comm_sym_index);
+        g_hash_table_destroy(s7comm_sym_dbs);
+        s7comm_sym_index = NULL;
+        s7comm_sym_dbs = NULL;
+    }
+    if (filename[0] == '\0') {
+        return;
+    }
+    if (!g_file_get_contents(filename, &contents, NULL, &err)) {
+        report_failure("S7COMM: Can't read symbol table %s: %s", filename, err->message);
+        g_error_free(err);
+        return;
+    }
+    s7comm_sym_index = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, s7comm_sym_free_index);
+    s7comm_sym_dbs = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+
+    lines = g_strsplit(contents, "\n", -1);
+    for (i = 0; lines[i] != NULL; i++) {
+        line = lines[i];
+        line_len = strlen(line);
+        if (line_len > 0 && line[line_len - 1] == '\r') {
+            line[--line_len] = '\0';
+        }
+        if (line[0] == '"') {
+            /* SDF: "symbol","address","datatype","comment" */
+            fields = g_strsplit(line + 1, "\",\"", 3);
+            if (fields[0] != NULL && fields[1] != NULL) {
+                s7comm_sym_add(g_strstrip(fields[0]), fields[1]);
+            }
+            g_strfreev(fields);
+        } else if (strncmp(line, "126,", 4) == 0) {
+            /* ASCII: 24 characters symbol, 12 characters address */
+            symbol = s7comm_sym_get_column(line, line_len, 4, 24);
+            address = s7comm_sym_get_column(line, line_len, 28, 12);
+            s7comm_sym_add(symbol, address);
+            g_free(symbol);
+            g_free(address);
+        }
+    }
+    g_strfreev(lines);
+    g_free(contents);
+    g_hash_table_foreach(s7comm_sym_index, s7comm_sym_build_index, NULL);
+}
+
+/*******************************************************************************************************
+ *
+ * Get the symbol of an address. start and size are in bits, for timers and counters
+ * in numbers. A symbol with exactly the same address and size is preferred, otherwise
+ * the smallest symbol which contains the start address is used.
+ * Returns NULL if there is no symbol.
+ *
+ *******************************************************************************************************/
+const gchar *
+s7comm_get_symbol(guint8 area,
+                  guint16 db,
+                  guint32 start,
+                  guint32 size)
+{
+    GArray *intervals;
+    s7comm_sym_interval_t *iv;
+    s7comm_sym_interval_t *best = NULL;
+    guint lo, hi, mid;
+
+    if (s7comm_sym_index == NULL) {
+        return NULL;
+    }
+    if (area == S7COMM_AREA_DI) {
+        area = S7COMM_AREA_DB;
+    }
+    if (area != S7COMM_AREA_DB) {
+        db = 0;
+    }
+    intervals = (GArray *)g_hash_table_lookup(s7comm_sym_index, S7COMM_SYM_KEY(area, db));
+    if (intervals != NULL && intervals->len > 0) {
+        iv = (s7comm_sym_interval_t *)(void *)intervals->data;
+        /* binary search for the first interval which starts behind the address */
+        lo = 0;
+        hi = intervals->len;
+        while (lo < hi) {
+            mid = lo + (hi - lo) / 2;
+            if (iv[mid].start <= start) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        /* walk backwards as long as an interval may contain the address */
+        while (lo > 0 && iv[lo - 1].max_end > start) {
+            lo--;
+            if (iv[lo].end > start) {
+                if (iv[lo].start == start && iv[lo].end - iv[lo].start == size) {
+                    return iv[lo].symbol;
+                }
+                if (best == NULL || (iv[lo].end - iv[lo].start) < (best->end - best->start)) {
+                    best = &iv[lo];
+                }
+            }
+        }
+    }
+    if (best != NULL) {
+        return best->symbol;
+    }
+    if (area == S7COMM_AREA_DB) {
+        return (const gchar *)g_hash_table_lookup(s7comm_sym_dbs, GUINT_TO_POINTER((guint32)db));
+    }
+    return NULL;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,81 @@
+/* packet-s7comm_szl_decoder.h
+ *
+ * Author:      Thomas Wiens, 2014 (th.wiens@gmx.de)
+ * Description: Wireshark dissector for S7-Communication
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**************************************************************************
+ * Decoders of SZL partial lists, public for other plugins.
+ *
+ * The function s7comm_szl_register_decoder() is exported from the module of
+ * the S7comm plugin. Another plugin looks it up with g_module_symbol() by
+ * S7COMM_SZL_REGISTER_DECODER_SYMBOL in its handoff, as it can't be linked
+ * against the S7comm plugin.
+ */
+#ifndef __PACKET_S7COMM_SZL_DECODER_H__
+#define __PACKET_S7COMM_SZL_DECODER_H__
+
+#include <gmodule.h>
+
+/* Decoder of one record of a SZL partial list, returns the offset after the decoded part */
+typedef guint32 (*s7comm_szl_decode_func)(tvbuff_t *tvb, proto_tree *tree, guint16 id, guint16 idx, guint32 offset);
+
+/* A field of a record of a SZL partial list, a layout is an array of them ended by hf == NULL */
+typedef struct {
+    guint16 offset;                         /* From the start of the record */
+    guint16 len;
+    gint *hf;
+    guint encoding;
+    gint *ett;                              /* Subtree and bits of a bitmask, NULL for an item */
+    const int **fields;
+} s7comm_szl_field_t;
+
+/* A decoder applies to the SZL-IDs and indexes which are equal to id and index in the bits of the masks */
+typedef struct {
+    guint16 id;
+    guint16 id_mask;
+    guint16 index;
+    guint16 index_mask;
+    s7comm_szl_decode_func decode;          /* Decoder of a record, or NULL */
+    const s7comm_szl_field_t *layout;       /* Fields of a record if there is no decode function, or NULL */
+    const value_string *index_names;        /* Descriptions of the indexes, or NULL */
+    guint16 record_len;                     /* Bytes of a record the decoder needs, shorter records are shown raw */
+} s7comm_szl_decoder_t;
+
+#define S7COMM_SZL_REGISTER_DECODER_SYMBOL  "s7comm_szl_register_decoder"
+typedef void (*s7comm_szl_register_decoder_func)(const s7comm_szl_decoder_t *decoder);
+
+G_MODULE_EXPORT void s7comm_szl_register_decoder(const s7comm_szl_decoder_t *decoder);
+
+#endif
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,274 @@
+/* packet-s7comm_szl_export.c
+ *
+ * Author:      Thomas Wiens, 2014 (th.wiens@gmx.de)
+ * Description: Wireshark dissector for S7-Communication
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**************************************************************************
+ * Export of the decoded SZL responses for tshark
+ *
+ * -z "s7comm,szl,<file>"
+ *   Appends a line to <file> for every SZL response, as JSON object (JSON
+ *   Lines). The records of a response in several data units are collected
+ *   up to its last data unit, frame and time are the ones of the first:
+ *     {"frame":12,"time":"2014-05-12T08:04:33.412Z","plc":"192.168.0.10",
+ *      "szl_id":"0x0011","index":"0x0001","count":1,"complete":true,
+ *      "records":[{...}]}
+ *   The records are taken from the decoder of the SZL-ID. The names of
+ *   their members are the field names without "s7comm.szl.<id>.<index>.",
+ *   values with a text have an additional member "<name>_name". Bytes of
+ *   a record without a field, and all records of SZL-IDs without a known
+ *   layout, are in the member "data" as hex. The time is in UTC. Lines are
+ *   written when the last data unit of the response is dissected, responses
+ *   whose last data unit is missing are written at the end with "complete"
+ *   false.
+ **************************************************************************/
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <glib.h>
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/to_str.h>
+#include <epan/stat_cmd_args.h>
+#include <wsutil/file_util.h>
+
+#include "packet-s7comm.h"
+#include "packet-s7comm_tap.h"
+
+/* A response in a conversation */
+typedef struct {
+    guint32 conversation;
+    guint8 data_unit_ref;
+} s7comm_szl_export_key_t;
+
+/* A response of which the last data unit is not seen yet */
+typedef struct {
+    guint32 frame;                          /* First data unit */
+    nstime_t ts;
+    gchar *plc;
+    guint16 id;
+    guint16 index;
+    guint32 count;
+    GString *records;
+} s7comm_szl_export_response_t;
+
+typedef struct {
+    gchar *filename;
+    FILE *fh;
+    GHashTable *responses;                  /* s7comm_szl_export_key_t -> s7comm_szl_export_response_t */
+    guint32 n_responses;
+    guint32 n_records;
+} s7comm_szl_export_t;
+
+static guint
+s7comm_szl_export_key_hash(gconstpointer key)
+{
+    const s7comm_szl_export_key_t *k = (const s7comm_szl_export_key_t *)key;
+
+    return (k->conversation << 8) ^ k->data_unit_ref;
+}
+
+static gboolean
+s7comm_szl_export_key_equal(gconstpointer a,
+                            gconstpointer b)
+{
+    const s7comm_szl_export_key_t *k1 = (const s7comm_szl_export_key_t *)a;
+    const s7comm_szl_export_key_t *k2 = (const s7comm_szl_export_key_t *)b;
+
+    return k1->conversation == k2->conversation && k1->data_unit_ref == k2->data_unit_ref;
+}
+
+static void
+s7comm_szl_export_free_response(gpointer data)
+{
+    s7comm_szl_export_response_t *response = (s7comm_szl_export_response_t *)data;
+
+    g_free(response->plc);
+    g_string_free(response->records, TRUE);
+    g_free(response);
+}
+
+static void
+s7comm_szl_export_write(s7comm_szl_export_t *szl,
+                        const s7comm_szl_export_response_t *response,
+                        gboolean complete)
+{
+    time_t secs;
+    struct tm *tm;
+
+    secs = response->ts.secs;
+    tm = gmtime(&secs);
+    fprintf(szl->fh, "{\"frame\":%u,\"time\":\"", response->frame);
+    if (tm != NULL) {
+        fprintf(szl->fh, "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ", tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday,
+            tm->tm_hour, tm->tm_min, tm->tm_sec, response->ts.nsecs / 1000000);
+    }
+    fprintf(szl->fh, "\",\"plc\":\"%s\",\"szl_id\":\"0x%04x\",\"index\":\"0x%04x\",\"count\":%u,"
+        "\"complete\":%s,\"records\":[%s]}\n", response->plc, response->id, response->index, response->count,
+        complete ? "true" : "false", response->records->str);
+    szl->n_responses++;
+    szl->n_records += response->count;
+}
+
+static int
+s7comm_szl_export_packet(void *tapdata,
+                         packet_info *pinfo,
+                         epan_dissect_t *edt _U_,
+                         const void *data)
+{
+    s7comm_szl_export_t *szl = (s7comm_szl_export_t *)tapdata;
+    const s7comm_szl_tap_t *szl_tap = (const s7comm_szl_tap_t *)data;
+    s7comm_szl_export_response_t *response;
+    s7comm_szl_export_key_t key;
+
+    key.conversation = szl_tap->conversation;
+    key.data_unit_ref = szl_tap->data_unit_ref;
+    if (szl_tap->first_unit) {
+        response = g_new0(s7comm_szl_export_response_t, 1);
+        response->frame = pinfo->fd->num;
+        response->ts = pinfo->fd->abs_ts;
+        /* The responses are sent by the PLC */
+        response->plc = g_strdup(ep_address_to_str(&pinfo->src));
+        response->id = szl_tap->id;
+        response->index = szl_tap->index;
+        response->records = g_string_new("");
+        if (szl_tap->more_units) {
+            /* Replaces a response of the same reference whose last data unit was lost */
+            g_hash_table_insert(szl->responses, g_memdup(&key, sizeof(key)), response);
+        }
+    } else {
+        response = (s7comm_szl_export_response_t *)g_hash_table_lookup(szl->responses, &key);
+        if (response == NULL) {
+            return FALSE;
+        }
+    }
+    if (szl_tap->count > 0) {
+        if (response->count > 0) {
+            g_string_append_c(response->records, ',');
+        }
+        g_string_append(response->records, wmem_strbuf_get_str(szl_tap->records));
+        response->count += szl_tap->count;
+    }
+    if (!szl_tap->more_units) {
+        s7comm_szl_export_write(szl, response, TRUE);
+        if (szl_tap->first_unit) {
+            s7comm_szl_export_free_response(response);
+        } else {
+            g_hash_table_remove(szl->responses, &key);
+        }
+    }
+    return TRUE;
+}
+
+static void
+s7comm_szl_export_reset(void *tapdata)
+{
+    s7comm_szl_export_t *szl = (s7comm_szl_export_t *)tapdata;
+
+    g_hash_table_remove_all(szl->responses);
+    szl->n_responses = 0;
+    szl->n_records = 0;
+}
+
+static void
+s7comm_szl_export_write_incomplete(gpointer key _U_,
+                                   gpointer value,
+                                   gpointer user_data)
+{
+    s7comm_szl_export_write((s7comm_szl_export_t *)user_data, (const s7comm_szl_export_response_t *)value, FALSE);
+}
+
+static void
+s7comm_szl_export_draw(void *tapdata)
+{
+    s7comm_szl_export_t *szl = (s7comm_szl_export_t *)tapdata;
+
+    g_hash_table_foreach(szl->responses, s7comm_szl_export_write_incomplete, szl);
+    g_hash_table_remove_all(szl->responses);
+    fflush(szl->fh);
+    printf("\n===================================================================\n");
+    printf("S7 SZL: %u responses with %u records written to %s\n",
+        szl->n_responses, szl->n_records, szl->filename);
+    printf("===================================================================\n");
+}
+
+/*******************************************************************************************************
+ *
+ * -z "s7comm,szl,<file>"
+ *
+ *******************************************************************************************************/
+static void
+s7comm_szl_export_init(const char *optarg,
+                       void *userdata _U_)
+{
+    s7comm_szl_export_t *szl;
+    GString *error_string;
+
+    szl = g_new0(s7comm_szl_export_t, 1);
+    szl->filename = g_strdup(optarg + strlen("s7comm,szl,"));
+    if (szl->filename[0] == '\0') {
+        fprintf(stderr, "tshark: invalid \"-z s7comm,szl,<file>\" argument\n");
+        exit(1);
+    }
+    szl->fh = ws_fopen(szl->filename, "a");
+    if (szl->fh == NULL) {
+        fprintf(stderr, "tshark: Can't open \"%s\": %s\n", szl->filename, g_strerror(errno));
+        exit(1);
+    }
+    setvbuf(szl->fh, NULL, _IOLBF, BUFSIZ);
+    szl->responses = g_hash_table_new_full(s7comm_szl_export_key_hash, s7comm_szl_export_key_equal,
+        g_free, s7comm_szl_export_free_response);
+
+    error_string = register_tap_listener("s7comm_szl", szl, NULL, TL_REQUIRES_NOTHING,
+        s7comm_szl_export_reset, s7comm_szl_export_packet, s7comm_szl_export_draw);
+    if (error_string) {
+        fprintf(stderr, "tshark: Couldn't register s7comm,szl tap: %s\n", error_string->str);
+        g_string_free(error_string, TRUE);
+        exit(1);
+    }
+}
+
+void
+s7comm_register_szl_export_tap(void)
+{
+    register_stat_cmd_arg("s7comm,szl,", s7comm_szl_export_init, NULL);
+}
+
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -24,11 +24,40 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <epan/packet.h>
+#include <epan/conversation.h>
+#include <epan/tap.h>
 
 #include "packet-s7comm.h"
 #include "packet-s7comm_szl_ids.h"
 
+/* Tap of the facts about a PLC from SZL responses */
+static int s7comm_inventory_tap = -1;
+/* Tap of the events of diagnostic buffer responses */
+static int s7comm_diag_tap = -1;
+/* Tap of the decoded SZL responses as JSON */
+static int s7comm_szl_tap = -1;
+
+static int proto_s7comm_szl = -1;
+
+/* An SZL response in several data units. Only the first data unit has the SZL-ID, the index and the
+ * length of the records, and a record may be cut at the end of a data unit. Kept by connection and
+ * data unit reference on the first pass, the following data units get a copy as it was before them.
+ */
+typedef struct {
+    guint16 id;
+    guint16 index;
+    guint16 list_len;
+    guint16 list_count;                     /* Records not yet decoded */
+    guint16 next_no;                        /* Number of the next record in the response */
+    guint16 partial_len;                    /* Bytes of the record cut at the end of the data unit before */
+    guint8 *partial;
+} s7comm_szl_response_t;
+
+static wmem_tree_t *s7comm_szl_responses = NULL;
+
 static gint ett_s7comm_szl = -1;
 
 static gint hf_s7comm_userdata_szl_partial_list = -1;           /* Partial list in szl response */
@@ -1315,61 +1344,42 @@ static const value_string szl_xy74_0000_led_blink_names[] = {
     { 0,                                    NULL }
 };
 
-/*******************************************************************************************************
- *
- * Get the textual description of the szl index. Returns NULL if not description available
- *
- *******************************************************************************************************/
-static const gchar*
-s7comm_get_szl_id_index_description_text(guint16 id, guint16 idx)
-{
-    const gchar* str = NULL;
-    switch (id) {
-        case 0x0111:
-            str = val_to_str(idx, szl_0111_index_names, "No description available");
-            break;
-        case 0x0112:
-            str = val_to_str(idx, szl_0112_index_names, "No description available");
-            break;
-        case 0x0113:
-            str = val_to_str(idx, szl_0113_index_names, "No description available");
-            break;
-        case 0x0114:
-            str = val_to_str(idx, szl_0114_index_names, "No description available");
-            break;
-        case 0x0115:
-            str = val_to_str(idx, szl_0115_index_names, "No description available");
-            break;
-        case 0x0116:
-            str = val_to_str(idx, szl_0116_index_names, "No description available");
-            break;
-        case 0x0118:
-            str = val_to_str(idx, szl_0118_index_names, "No description available");
-            break;
-        case 0x0119:
-            str = val_to_str(idx, szl_0119_index_names, "No description available");
-            break;
-        case 0x0121:
-            str = val_to_str(idx, szl_0121_index_names, "No description available");
-            break;
-        case 0x0222:
-            str = val_to_str(idx, szl_0222_index_names, "No description available");
-            break;
-        case 0x0524:
-            str = val_to_str(idx, szl_0524_index_names, "No description available");
-            break;
-        case 0x0131:
-            str = val_to_str(idx, szl_0131_index_names, "No description available");
-            break;
-        case 0x0132:
-            str = val_to_str(idx, szl_0132_index_names, "No description available");
-            break;
-        case 0x0174:
-            str = val_to_str(idx, szl_0174_index_names, "No description available");
-            break;
-    }
-    return str;
-}
+static gint hf_s7comm_szl_xya0_0000_evid = -1;
+static gint hf_s7comm_szl_xya0_0000_evid_class = -1;
+static const value_string szl_xya0_0000_evid_class_names[] = {
+    { 0x1,                                  "Standard OB events" },
+    { 0x2,                                  "Synchronous errors" },
+    { 0x3,                                  "Asynchronous errors" },
+    { 0x4,                                  "Mode transitions" },
+    { 0x5,                                  "Run-time events" },
+    { 0x6,                                  "Communication events" },
+    { 0x7,                                  "Events for fault-tolerant and fail-safe systems" },
+    { 0x8,                                  "Standardized diagnostic data on modules" },
+    { 0x9,                                  "Predefined user events" },
+    { 0xa,                                  "Freely definable events" },
+    { 0xb,                                  "Freely definable events" },
+    { 0,                                    NULL }
+};
+static gint hf_s7comm_szl_xya0_0000_evid_coming = -1;
+static gint hf_s7comm_szl_xya0_0000_evid_entry = -1;
+static gint hf_s7comm_szl_xya0_0000_evid_int_err = -1;
+static gint hf_s7comm_szl_xya0_0000_evid_ext_err = -1;
+static gint hf_s7comm_szl_xya0_0000_evid_nr = -1;
+static gint ett_s7comm_szl_xya0_0000_evid = -1;
+static const int *s7comm_szl_xya0_0000_evid_fields[] = {
+    &hf_s7comm_szl_xya0_0000_evid_class,
+    &hf_s7comm_szl_xya0_0000_evid_coming,
+    &hf_s7comm_szl_xya0_0000_evid_entry,
+    &hf_s7comm_szl_xya0_0000_evid_int_err,
+    &hf_s7comm_szl_xya0_0000_evid_ext_err,
+    &hf_s7comm_szl_xya0_0000_evid_nr,
+    NULL
+};
+static gint hf_s7comm_szl_xya0_0000_prio = -1;
+static gint hf_s7comm_szl_xya0_0000_ob = -1;
+static gint hf_s7comm_szl_xya0_0000_dat_id = -1;
+static gint hf_s7comm_szl_xya0_0000_info1 = -1;
+static gint hf_s7comm_szl_xya0_0000_info2 = -1;
 
 /*******************************************************************************************************
  *******************************************************************************************************
@@ -1535,41 +1545,25 @@ s7comm_szl_0013_0000_register(int proto)
     proto_register_field_array(proto, hf, array_length(hf));
 }
 /*----------------------------------------------------------------------------------------------------*/
-static guint32
-s7comm_decode_szl_id_0013_idx_0000(tvbuff_t *tvb,
-                                    proto_tree *tree,
-                                    guint32 offset)
-{
-    proto_tree_add_item(tree, hf_s7comm_szl_0013_0000_index, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0013_0000_code, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0013_0000_size, tvb, offset, 4, ENC_BIG_ENDIAN);
-    offset += 4;
-    proto_tree_add_item(tree, hf_s7comm_szl_0013_0000_mode, tvb, offset, 2, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0013_0000_mode_0, tvb, offset, 2, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0013_0000_mode_1, tvb, offset, 2, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0013_0000_mode_2, tvb, offset, 2, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0013_0000_mode_3, tvb, offset, 2, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0013_0000_mode_4, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0013_0000_granu, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0013_0000_ber1, tvb, offset, 4, ENC_BIG_ENDIAN);
-    offset += 4;
-    proto_tree_add_item(tree, hf_s7comm_szl_0013_0000_belegt1, tvb, offset, 4, ENC_BIG_ENDIAN);
-    offset += 4;
-    proto_tree_add_item(tree, hf_s7comm_szl_0013_0000_block1, tvb, offset, 4, ENC_BIG_ENDIAN);
-    offset += 4;
-    proto_tree_add_item(tree, hf_s7comm_szl_0013_0000_ber2, tvb, offset, 4, ENC_BIG_ENDIAN);
-    offset += 4;
-    proto_tree_add_item(tree, hf_s7comm_szl_0013_0000_belegt2, tvb, offset, 4, ENC_BIG_ENDIAN);
-    offset += 4;
-    proto_tree_add_item(tree, hf_s7comm_szl_0013_0000_block2, tvb, offset, 4, ENC_BIG_ENDIAN);
-    offset += 4;
-
-    return offset;
-}
+static const s7comm_szl_field_t s7comm_szl_0013_0000_layout[] = {
+    { 0,  2,  &hf_s7comm_szl_0013_0000_index,   ENC_BIG_ENDIAN, NULL, NULL },
+    { 2,  2,  &hf_s7comm_szl_0013_0000_code,    ENC_BIG_ENDIAN, NULL, NULL },
+    { 4,  4,  &hf_s7comm_szl_0013_0000_size,    ENC_BIG_ENDIAN, NULL, NULL },
+    { 8,  2,  &hf_s7comm_szl_0013_0000_mode,    ENC_BIG_ENDIAN, NULL, NULL },
+    { 8,  2,  &hf_s7comm_szl_0013_0000_mode_0,  ENC_BIG_ENDIAN, NULL, NULL },
+    { 8,  2,  &hf_s7comm_szl_0013_0000_mode_1,  ENC_BIG_ENDIAN, NULL, NULL },
+    { 8,  2,  &hf_s7comm_szl_0013_0000_mode_2,  ENC_BIG_ENDIAN, NULL, NULL },
+    { 8,  2,  &hf_s7comm_szl_0013_0000_mode_3,  ENC_BIG_ENDIAN, NULL, NULL },
+    { 8,  2,  &hf_s7comm_szl_0013_0000_mode_4,  ENC_BIG_ENDIAN, NULL, NULL },
+    { 10, 2,  &hf_s7comm_szl_0013_0000_granu,   ENC_BIG_ENDIAN, NULL, NULL },
+    { 12, 4,  &hf_s7comm_szl_0013_0000_ber1,    ENC_BIG_ENDIAN, NULL, NULL },
+    { 16, 4,  &hf_s7comm_szl_0013_0000_belegt1, ENC_BIG_ENDIAN, NULL, NULL },
+    { 20, 4,  &hf_s7comm_szl_0013_0000_block1,  ENC_BIG_ENDIAN, NULL, NULL },
+    { 24, 4,  &hf_s7comm_szl_0013_0000_ber2,    ENC_BIG_ENDIAN, NULL, NULL },
+    { 28, 4,  &hf_s7comm_szl_0013_0000_belegt2, ENC_BIG_ENDIAN, NULL, NULL },
+    { 32, 4,  &hf_s7comm_szl_0013_0000_block2,  ENC_BIG_ENDIAN, NULL, NULL },
+    { 0, 0, NULL, 0, NULL, NULL }
+};
 
 
  /*******************************************************************************************************
@@ -1609,24 +1603,14 @@ s7comm_szl_xy11_0001_register(int proto)
     proto_register_field_array(proto, hf, array_length(hf));
 }
  /*----------------------------------------------------------------------------------------------------*/
-static guint32
-s7comm_decode_szl_id_0111_idx_0001(tvbuff_t *tvb,
-                                    proto_tree *tree,
-                                    guint32 offset)
-{
-    proto_tree_add_item(tree, hf_s7comm_szl_xy11_0001_index, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_xy11_0001_mlfb, tvb, offset, 20, ENC_ASCII|ENC_NA);
-    offset += 20;
-    proto_tree_add_item(tree, hf_s7comm_szl_xy11_0001_bgtyp, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_xy11_0001_ausbg, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_xy11_0001_ausbe, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-
-    return offset;
-}
+static const s7comm_szl_field_t s7comm_szl_0111_0001_layout[] = {
+    { 0,  2,  &hf_s7comm_szl_xy11_0001_index, ENC_BIG_ENDIAN,   NULL, NULL },
+    { 2,  20, &hf_s7comm_szl_xy11_0001_mlfb,  ENC_ASCII|ENC_NA, NULL, NULL },
+    { 22, 2,  &hf_s7comm_szl_xy11_0001_bgtyp, ENC_BIG_ENDIAN,   NULL, NULL },
+    { 24, 2,  &hf_s7comm_szl_xy11_0001_ausbg, ENC_BIG_ENDIAN,   NULL, NULL },
+    { 26, 2,  &hf_s7comm_szl_xy11_0001_ausbe, ENC_BIG_ENDIAN,   NULL, NULL },
+    { 0, 0, NULL, 0, NULL, NULL }
+};
  /*******************************************************************************************************
  *
  * SZL-ID:  0x0131
@@ -1664,25 +1648,15 @@ s7comm_szl_0131_0001_register(int proto)
     proto_register_field_array(proto, hf, array_length(hf));
 }
 /*----------------------------------------------------------------------------------------------------*/
-static guint32
-s7comm_decode_szl_id_0131_idx_0001(tvbuff_t *tvb,
-                                    proto_tree *tree,
-                                    guint32 offset)
-{
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0001_index, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0001_pdu, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0001_anz, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0001_mpi_bps, tvb, offset, 4, ENC_BIG_ENDIAN);
-    offset += 4;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0001_kbus_bps, tvb, offset, 4, ENC_BIG_ENDIAN);
-    offset += 4;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0001_res, tvb, offset, 26, ENC_NA);
-    offset += 26;
-    return offset;
-}
+static const s7comm_szl_field_t s7comm_szl_0131_0001_layout[] = {
+    { 0,  2,  &hf_s7comm_szl_0131_0001_index,    ENC_BIG_ENDIAN, NULL, NULL },
+    { 2,  2,  &hf_s7comm_szl_0131_0001_pdu,      ENC_BIG_ENDIAN, NULL, NULL },
+    { 4,  2,  &hf_s7comm_szl_0131_0001_anz,      ENC_BIG_ENDIAN, NULL, NULL },
+    { 6,  4,  &hf_s7comm_szl_0131_0001_mpi_bps,  ENC_BIG_ENDIAN, NULL, NULL },
+    { 10, 4,  &hf_s7comm_szl_0131_0001_kbus_bps, ENC_BIG_ENDIAN, NULL, NULL },
+    { 14, 26, &hf_s7comm_szl_0131_0001_res,      ENC_NA,         NULL, NULL },
+    { 0, 0, NULL, 0, NULL, NULL }
+};
  /*******************************************************************************************************
  *
  * SZL-ID:  0x0131
@@ -1946,63 +1920,31 @@ s7comm_szl_0131_0002_register(int proto)
     proto_register_field_array(proto, hf, array_length(hf));
 }
 /*----------------------------------------------------------------------------------------------------*/
-static guint32
-s7comm_decode_szl_id_0131_idx_0002(tvbuff_t *tvb,
-                                    proto_tree *tree,
-                                    guint32 offset)
-{
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0002_index, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0002_funkt_0,
-        ett_s7comm_szl_0131_0002_funkt_0, s7comm_szl_0131_0002_funkt_0_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0002_funkt_1,
-        ett_s7comm_szl_0131_0002_funkt_1, s7comm_szl_0131_0002_funkt_1_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0002_funkt_2,
-        ett_s7comm_szl_0131_0002_funkt_2, s7comm_szl_0131_0002_funkt_2_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0002_funkt_3, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0002_funkt_4, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0002_funkt_5, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0002_aseg, tvb, offset, 6, ENC_NA);
-    offset += 6;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0002_eseg, tvb, offset, 6, ENC_NA);
-    offset += 6;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0002_trgereig_0,
-        ett_s7comm_szl_0131_0002_trgereig_0, s7comm_szl_0131_0002_trgereig_0_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0002_trgereig_1,
-        ett_s7comm_szl_0131_0002_trgereig_1, s7comm_szl_0131_0002_trgereig_1_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0002_trgereig_2, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0002_trgbed, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0002_pfad, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0002_tiefe, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0002_systrig, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0002_erg_par, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0002_erg_pat_1, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0002_erg_pat_2, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0002_force, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0002_time, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0002_res, tvb, offset, 4, ENC_BIG_ENDIAN);
-    offset += 4;
-
-    return offset;
-}
+static const s7comm_szl_field_t s7comm_szl_0131_0002_layout[] = {
+    { 0,  2,  &hf_s7comm_szl_0131_0002_index,      ENC_BIG_ENDIAN, NULL, NULL },
+    { 2,  1,  &hf_s7comm_szl_0131_0002_funkt_0,    ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0002_funkt_0, s7comm_szl_0131_0002_funkt_0_fields },
+    { 3,  1,  &hf_s7comm_szl_0131_0002_funkt_1,    ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0002_funkt_1, s7comm_szl_0131_0002_funkt_1_fields },
+    { 4,  1,  &hf_s7comm_szl_0131_0002_funkt_2,    ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0002_funkt_2, s7comm_szl_0131_0002_funkt_2_fields },
+    { 5,  1,  &hf_s7comm_szl_0131_0002_funkt_3,    ENC_BIG_ENDIAN, NULL, NULL },
+    { 6,  1,  &hf_s7comm_szl_0131_0002_funkt_4,    ENC_BIG_ENDIAN, NULL, NULL },
+    { 7,  1,  &hf_s7comm_szl_0131_0002_funkt_5,    ENC_BIG_ENDIAN, NULL, NULL },
+    { 8,  6,  &hf_s7comm_szl_0131_0002_aseg,       ENC_NA,         NULL, NULL },
+    { 14, 6,  &hf_s7comm_szl_0131_0002_eseg,       ENC_NA,         NULL, NULL },
+    { 20, 1,  &hf_s7comm_szl_0131_0002_trgereig_0, ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0002_trgereig_0, s7comm_szl_0131_0002_trgereig_0_fields },
+    { 21, 1,  &hf_s7comm_szl_0131_0002_trgereig_1, ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0002_trgereig_1, s7comm_szl_0131_0002_trgereig_1_fields },
+    { 22, 1,  &hf_s7comm_szl_0131_0002_trgereig_2, ENC_BIG_ENDIAN, NULL, NULL },
+    { 23, 1,  &hf_s7comm_szl_0131_0002_trgbed,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 24, 1,  &hf_s7comm_szl_0131_0002_pfad,       ENC_BIG_ENDIAN, NULL, NULL },
+    { 25, 1,  &hf_s7comm_szl_0131_0002_tiefe,      ENC_BIG_ENDIAN, NULL, NULL },
+    { 26, 1,  &hf_s7comm_szl_0131_0002_systrig,    ENC_BIG_ENDIAN, NULL, NULL },
+    { 27, 1,  &hf_s7comm_szl_0131_0002_erg_par,    ENC_BIG_ENDIAN, NULL, NULL },
+    { 28, 2,  &hf_s7comm_szl_0131_0002_erg_pat_1,  ENC_BIG_ENDIAN, NULL, NULL },
+    { 30, 2,  &hf_s7comm_szl_0131_0002_erg_pat_2,  ENC_BIG_ENDIAN, NULL, NULL },
+    { 32, 2,  &hf_s7comm_szl_0131_0002_force,      ENC_BIG_ENDIAN, NULL, NULL },
+    { 34, 2,  &hf_s7comm_szl_0131_0002_time,       ENC_BIG_ENDIAN, NULL, NULL },
+    { 36, 4,  &hf_s7comm_szl_0131_0002_res,        ENC_BIG_ENDIAN, NULL, NULL },
+    { 0, 0, NULL, 0, NULL, NULL }
+};
  /*******************************************************************************************************
  *
  * SZL-ID:  0x0131
@@ -2191,38 +2133,19 @@ s7comm_szl_0131_0003_register(int proto)
     proto_register_field_array(proto, hf, array_length(hf));
 }
 /*----------------------------------------------------------------------------------------------------*/
-static guint32
-s7comm_decode_szl_id_0131_idx_0003(tvbuff_t *tvb,
-                                    proto_tree *tree,
-                                    guint32 offset)
-{
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0003_index, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0003_funkt_0,
-        ett_s7comm_szl_0131_0003_funkt_0, s7comm_szl_0131_0003_funkt_0_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0003_funkt_1,
-        ett_s7comm_szl_0131_0003_funkt_1, s7comm_szl_0131_0003_funkt_1_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0003_funkt_2,
-        ett_s7comm_szl_0131_0003_funkt_2, s7comm_szl_0131_0003_funkt_2_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0003_funkt_3,
-        ett_s7comm_szl_0131_0003_funkt_3, s7comm_szl_0131_0003_funkt_3_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0003_data, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0003_anz, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0003_per_min, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0003_per_max, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0003_res, tvb, offset, 26, ENC_NA);
-    offset += 26;
-
-    return offset;
-}
+static const s7comm_szl_field_t s7comm_szl_0131_0003_layout[] = {
+    { 0,  2,  &hf_s7comm_szl_0131_0003_index,   ENC_BIG_ENDIAN, NULL, NULL },
+    { 2,  1,  &hf_s7comm_szl_0131_0003_funkt_0, ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0003_funkt_0, s7comm_szl_0131_0003_funkt_0_fields },
+    { 3,  1,  &hf_s7comm_szl_0131_0003_funkt_1, ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0003_funkt_1, s7comm_szl_0131_0003_funkt_1_fields },
+    { 4,  1,  &hf_s7comm_szl_0131_0003_funkt_2, ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0003_funkt_2, s7comm_szl_0131_0003_funkt_2_fields },
+    { 5,  1,  &hf_s7comm_szl_0131_0003_funkt_3, ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0003_funkt_3, s7comm_szl_0131_0003_funkt_3_fields },
+    { 6,  2,  &hf_s7comm_szl_0131_0003_data,    ENC_BIG_ENDIAN, NULL, NULL },
+    { 8,  2,  &hf_s7comm_szl_0131_0003_anz,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 10, 2,  &hf_s7comm_szl_0131_0003_per_min, ENC_BIG_ENDIAN, NULL, NULL },
+    { 12, 2,  &hf_s7comm_szl_0131_0003_per_max, ENC_BIG_ENDIAN, NULL, NULL },
+    { 14, 26, &hf_s7comm_szl_0131_0003_res,     ENC_NA,         NULL, NULL },
+    { 0, 0, NULL, 0, NULL, NULL }
+};
 
 /*******************************************************************************************************
  *
@@ -2470,49 +2393,24 @@ s7comm_szl_0131_0004_register(int proto)
 }
 
 /*----------------------------------------------------------------------------------------------------*/
-static guint32
-s7comm_decode_szl_id_0131_idx_0004(tvbuff_t *tvb,
-                                    proto_tree *tree,
-                                    guint32 offset)
-{
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0004_index, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0004_funkt_0,
-        ett_s7comm_szl_0131_0004_funkt_0, s7comm_szl_0131_0004_funkt_0_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0004_funkt_1,
-        ett_s7comm_szl_0131_0004_funkt_1, s7comm_szl_0131_0004_funkt_1_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0004_funkt_2,
-        ett_s7comm_szl_0131_0004_funkt_2, s7comm_szl_0131_0004_funkt_2_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0004_funkt_3,
-        ett_s7comm_szl_0131_0004_funkt_3, s7comm_szl_0131_0004_funkt_3_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0004_funkt_4,
-        ett_s7comm_szl_0131_0004_funkt_4, s7comm_szl_0131_0004_funkt_4_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0004_funkt_5, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0004_funkt_6, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0004_funkt_7, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0004_kop, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0004_del, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0004_kett, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0004_hoch, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0004_ver, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0004_res, tvb, offset, 25, ENC_NA);
-    offset += 25;
-
-    return offset;
-}
+static const s7comm_szl_field_t s7comm_szl_0131_0004_layout[] = {
+    { 0,  2,  &hf_s7comm_szl_0131_0004_index,   ENC_BIG_ENDIAN, NULL, NULL },
+    { 2,  1,  &hf_s7comm_szl_0131_0004_funkt_0, ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0004_funkt_0, s7comm_szl_0131_0004_funkt_0_fields },
+    { 3,  1,  &hf_s7comm_szl_0131_0004_funkt_1, ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0004_funkt_1, s7comm_szl_0131_0004_funkt_1_fields },
+    { 4,  1,  &hf_s7comm_szl_0131_0004_funkt_2, ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0004_funkt_2, s7comm_szl_0131_0004_funkt_2_fields },
+    { 5,  1,  &hf_s7comm_szl_0131_0004_funkt_3, ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0004_funkt_3, s7comm_szl_0131_0004_funkt_3_fields },
+    { 6,  1,  &hf_s7comm_szl_0131_0004_funkt_4, ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0004_funkt_4, s7comm_szl_0131_0004_funkt_4_fields },
+    { 7,  1,  &hf_s7comm_szl_0131_0004_funkt_5, ENC_BIG_ENDIAN, NULL, NULL },
+    { 8,  1,  &hf_s7comm_szl_0131_0004_funkt_6, ENC_BIG_ENDIAN, NULL, NULL },
+    { 9,  1,  &hf_s7comm_szl_0131_0004_funkt_7, ENC_BIG_ENDIAN, NULL, NULL },
+    { 10, 1,  &hf_s7comm_szl_0131_0004_kop,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 11, 1,  &hf_s7comm_szl_0131_0004_del,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 12, 1,  &hf_s7comm_szl_0131_0004_kett,    ENC_BIG_ENDIAN, NULL, NULL },
+    { 13, 1,  &hf_s7comm_szl_0131_0004_hoch,    ENC_BIG_ENDIAN, NULL, NULL },
+    { 14, 1,  &hf_s7comm_szl_0131_0004_ver,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 15, 25, &hf_s7comm_szl_0131_0004_res,     ENC_NA,         NULL, NULL },
+    { 0, 0, NULL, 0, NULL, NULL }
+};
 
 /*******************************************************************************************************
  *
@@ -2935,81 +2833,35 @@ s7comm_szl_0131_0006_register(int proto)
 }
 
 /*----------------------------------------------------------------------------------------------------*/
-static guint32
-s7comm_decode_szl_id_0131_idx_0006(tvbuff_t *tvb,
-                                    proto_tree *tree,
-                                    guint32 offset)
-{
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_index, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0006_funkt_0,
-        ett_s7comm_szl_0131_0006_funkt_0, s7comm_szl_0131_0006_funkt_0_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0006_funkt_1,
-        ett_s7comm_szl_0131_0006_funkt_1, s7comm_szl_0131_0006_funkt_1_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0006_funkt_2,
-        ett_s7comm_szl_0131_0006_funkt_2, s7comm_szl_0131_0006_funkt_2_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0006_funkt_3,
-        ett_s7comm_szl_0131_0006_funkt_3, s7comm_szl_0131_0006_funkt_3_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_4, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_5, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0006_funkt_6,
-        ett_s7comm_szl_0131_0006_funkt_6, s7comm_szl_0131_0006_funkt_6_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0006_funkt_7,
-        ett_s7comm_szl_0131_0006_funkt_7, s7comm_szl_0131_0006_funkt_7_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_schnell, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    /*  ---  */
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0006_zugtyp_0,
-        ett_s7comm_szl_0131_0006_zugtyp_0, s7comm_szl_0131_0006_zugtyp_0_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0006_zugtyp_1,
-        ett_s7comm_szl_0131_0006_zugtyp_1, s7comm_szl_0131_0006_zugtyp_1_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0006_zugtyp_2,
-        ett_s7comm_szl_0131_0006_zugtyp_2, s7comm_szl_0131_0006_zugtyp_2_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0006_zugtyp_3,
-        ett_s7comm_szl_0131_0006_zugtyp_3, s7comm_szl_0131_0006_zugtyp_3_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_zugtyp_4, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_zugtyp_5, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0006_zugtyp_6,
-        ett_s7comm_szl_0131_0006_zugtyp_6, s7comm_szl_0131_0006_zugtyp_6_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0006_zugtyp_7,
-        ett_s7comm_szl_0131_0006_zugtyp_7, s7comm_szl_0131_0006_zugtyp_7_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_res1, tvb, offset, 1, ENC_NA);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_max_sd_empf, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_max_sd_al8p, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_max_inst, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_res2, tvb, offset, 2, ENC_NA);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_verb_proj, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_verb_prog, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_res3, tvb, offset, 10, ENC_NA);
-    offset += 10;
-
-    return offset;
-}
+static const s7comm_szl_field_t s7comm_szl_0131_0006_layout[] = {
+    { 0,  2,  &hf_s7comm_szl_0131_0006_index,       ENC_BIG_ENDIAN, NULL, NULL },
+    { 2,  1,  &hf_s7comm_szl_0131_0006_funkt_0,     ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0006_funkt_0, s7comm_szl_0131_0006_funkt_0_fields },
+    { 3,  1,  &hf_s7comm_szl_0131_0006_funkt_1,     ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0006_funkt_1, s7comm_szl_0131_0006_funkt_1_fields },
+    { 4,  1,  &hf_s7comm_szl_0131_0006_funkt_2,     ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0006_funkt_2, s7comm_szl_0131_0006_funkt_2_fields },
+    { 5,  1,  &hf_s7comm_szl_0131_0006_funkt_3,     ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0006_funkt_3, s7comm_szl_0131_0006_funkt_3_fields },
+    { 6,  1,  &hf_s7comm_szl_0131_0006_funkt_4,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 7,  1,  &hf_s7comm_szl_0131_0006_funkt_5,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 8,  1,  &hf_s7comm_szl_0131_0006_funkt_6,     ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0006_funkt_6, s7comm_szl_0131_0006_funkt_6_fields },
+    { 9,  1,  &hf_s7comm_szl_0131_0006_funkt_7,     ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0006_funkt_7, s7comm_szl_0131_0006_funkt_7_fields },
+    { 10, 1,  &hf_s7comm_szl_0131_0006_schnell,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 11, 1,  &hf_s7comm_szl_0131_0006_zugtyp_0,    ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0006_zugtyp_0, s7comm_szl_0131_0006_zugtyp_0_fields },
+    { 12, 1,  &hf_s7comm_szl_0131_0006_zugtyp_1,    ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0006_zugtyp_1, s7comm_szl_0131_0006_zugtyp_1_fields },
+    { 13, 1,  &hf_s7comm_szl_0131_0006_zugtyp_2,    ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0006_zugtyp_2, s7comm_szl_0131_0006_zugtyp_2_fields },
+    { 14, 1,  &hf_s7comm_szl_0131_0006_zugtyp_3,    ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0006_zugtyp_3, s7comm_szl_0131_0006_zugtyp_3_fields },
+    { 15, 1,  &hf_s7comm_szl_0131_0006_zugtyp_4,    ENC_BIG_ENDIAN, NULL, NULL },
+    { 16, 1,  &hf_s7comm_szl_0131_0006_zugtyp_5,    ENC_BIG_ENDIAN, NULL, NULL },
+    { 17, 1,  &hf_s7comm_szl_0131_0006_zugtyp_6,    ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0006_zugtyp_6, s7comm_szl_0131_0006_zugtyp_6_fields },
+    { 18, 1,  &hf_s7comm_szl_0131_0006_zugtyp_7,    ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0006_zugtyp_7, s7comm_szl_0131_0006_zugtyp_7_fields },
+    { 19, 1,  &hf_s7comm_szl_0131_0006_res1,        ENC_NA,         NULL, NULL },
+    { 20, 2,  &hf_s7comm_szl_0131_0006_max_sd_empf, ENC_BIG_ENDIAN, NULL, NULL },
+    { 22, 2,  &hf_s7comm_szl_0131_0006_max_sd_al8p, ENC_BIG_ENDIAN, NULL, NULL },
+    { 24, 2,  &hf_s7comm_szl_0131_0006_max_inst,    ENC_BIG_ENDIAN, NULL, NULL },
+    { 26, 2,  &hf_s7comm_szl_0131_0006_res2,        ENC_NA,         NULL, NULL },
+    { 28, 1,  &hf_s7comm_szl_0131_0006_verb_proj,   ENC_BIG_ENDIAN, NULL, NULL },
+    { 29, 1,  &hf_s7comm_szl_0131_0006_verb_prog,   ENC_BIG_ENDIAN, NULL, NULL },
+    { 30, 10, &hf_s7comm_szl_0131_0006_res3,        ENC_NA,         NULL, NULL },
+    { 0, 0, NULL, 0, NULL, NULL }
+};
 
 /*******************************************************************************************************
  *
@@ -3211,40 +3063,20 @@ s7comm_szl_0131_0010_register(int proto)
 }
 
 /*----------------------------------------------------------------------------------------------------*/
-static guint32
-s7comm_decode_szl_id_0131_idx_0010(tvbuff_t *tvb,
-                                    proto_tree *tree,
-                                    guint32 offset)
-{
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0010_index, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0010_funk_1,
-        ett_s7comm_szl_0131_0010_funk_1, s7comm_szl_0131_0010_funk_1_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0010_funk_2, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0010_ber_meld_1,
-        ett_s7comm_szl_0131_0010_ber_meld_1, s7comm_szl_0131_0010_ber_meld_1_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0010_ber_meld_2, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0010_ber_zus_1,
-        ett_s7comm_szl_0131_0010_ber_zus_1, s7comm_szl_0131_0010_ber_zus_1_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0010_ber_zus_2, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0131_0010_typ_zus_1,
-        ett_s7comm_szl_0131_0010_typ_zus_1, s7comm_szl_0131_0010_typ_zus_1_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0010_typ_zus_2, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0010_maxanz_arch, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0010_res, tvb, offset, 28, ENC_NA);
-    offset += 28;
-
-    return offset;
-}
+static const s7comm_szl_field_t s7comm_szl_0131_0010_layout[] = {
+    { 0,  2,  &hf_s7comm_szl_0131_0010_index,       ENC_BIG_ENDIAN, NULL, NULL },
+    { 2,  1,  &hf_s7comm_szl_0131_0010_funk_1,      ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0010_funk_1, s7comm_szl_0131_0010_funk_1_fields },
+    { 3,  1,  &hf_s7comm_szl_0131_0010_funk_2,      ENC_BIG_ENDIAN, NULL, NULL },
+    { 4,  1,  &hf_s7comm_szl_0131_0010_ber_meld_1,  ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0010_ber_meld_1, s7comm_szl_0131_0010_ber_meld_1_fields },
+    { 5,  1,  &hf_s7comm_szl_0131_0010_ber_meld_2,  ENC_BIG_ENDIAN, NULL, NULL },
+    { 6,  1,  &hf_s7comm_szl_0131_0010_ber_zus_1,   ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0010_ber_zus_1, s7comm_szl_0131_0010_ber_zus_1_fields },
+    { 7,  1,  &hf_s7comm_szl_0131_0010_ber_zus_2,   ENC_BIG_ENDIAN, NULL, NULL },
+    { 8,  1,  &hf_s7comm_szl_0131_0010_typ_zus_1,   ENC_BIG_ENDIAN, &ett_s7comm_szl_0131_0010_typ_zus_1, s7comm_szl_0131_0010_typ_zus_1_fields },
+    { 9,  1,  &hf_s7comm_szl_0131_0010_typ_zus_2,   ENC_BIG_ENDIAN, NULL, NULL },
+    { 10, 2,  &hf_s7comm_szl_0131_0010_maxanz_arch, ENC_BIG_ENDIAN, NULL, NULL },
+    { 12, 28, &hf_s7comm_szl_0131_0010_res,         ENC_NA,         NULL, NULL },
+    { 0, 0, NULL, 0, NULL, NULL }
+};
 
 /*******************************************************************************************************
  *
@@ -3307,36 +3139,20 @@ s7comm_szl_0132_0001_register(int proto)
     proto_register_field_array(proto, hf, array_length(hf));
 }
 /*----------------------------------------------------------------------------------------------------*/
-static guint32
-s7comm_decode_szl_id_0132_idx_0001(tvbuff_t *tvb,
-                                    proto_tree *tree,
-                                    guint32 offset)
-{
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0001_index, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0001_res_pg, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0001_res_os, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0001_u_pg, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0001_u_os, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0001_proj, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0001_auf, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0001_free, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0001_used, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0001_last, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0001_res, tvb, offset, 10, ENC_NA);
-    offset += 10;
-
-    return offset;
-}
+static const s7comm_szl_field_t s7comm_szl_0132_0001_layout[] = {
+    { 0,  2,  &hf_s7comm_szl_0132_0001_index,  ENC_BIG_ENDIAN, NULL, NULL },
+    { 2,  2,  &hf_s7comm_szl_0132_0001_res_pg, ENC_BIG_ENDIAN, NULL, NULL },
+    { 4,  2,  &hf_s7comm_szl_0132_0001_res_os, ENC_BIG_ENDIAN, NULL, NULL },
+    { 6,  2,  &hf_s7comm_szl_0132_0001_u_pg,   ENC_BIG_ENDIAN, NULL, NULL },
+    { 8,  2,  &hf_s7comm_szl_0132_0001_u_os,   ENC_BIG_ENDIAN, NULL, NULL },
+    { 10, 2,  &hf_s7comm_szl_0132_0001_proj,   ENC_BIG_ENDIAN, NULL, NULL },
+    { 12, 2,  &hf_s7comm_szl_0132_0001_auf,    ENC_BIG_ENDIAN, NULL, NULL },
+    { 14, 2,  &hf_s7comm_szl_0132_0001_free,   ENC_BIG_ENDIAN, NULL, NULL },
+    { 16, 2,  &hf_s7comm_szl_0132_0001_used,   ENC_BIG_ENDIAN, NULL, NULL },
+    { 18, 2,  &hf_s7comm_szl_0132_0001_last,   ENC_BIG_ENDIAN, NULL, NULL },
+    { 20, 10, &hf_s7comm_szl_0132_0001_res,    ENC_NA,         NULL, NULL },
+    { 0, 0, NULL, 0, NULL, NULL }
+};
 /*******************************************************************************************************
  *
  * SZL-ID:  0x0132
@@ -3366,20 +3182,12 @@ s7comm_szl_0132_0002_register(int proto)
     proto_register_field_array(proto, hf, array_length(hf));
 }
 /*----------------------------------------------------------------------------------------------------*/
-static guint32
-s7comm_decode_szl_id_0132_idx_0002(tvbuff_t *tvb,
-                                    proto_tree *tree,
-                                    guint32 offset)
-{
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0002_index, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0002_anz, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0002_res, tvb, offset, 36, ENC_NA);
-    offset += 36;
-
-    return offset;
-}
+static const s7comm_szl_field_t s7comm_szl_0132_0002_layout[] = {
+    { 0,  2,  &hf_s7comm_szl_0132_0002_index, ENC_BIG_ENDIAN, NULL, NULL },
+    { 2,  2,  &hf_s7comm_szl_0132_0002_anz,   ENC_BIG_ENDIAN, NULL, NULL },
+    { 4,  36, &hf_s7comm_szl_0132_0002_res,   ENC_NA,         NULL, NULL },
+    { 0, 0, NULL, 0, NULL, NULL }
+};
 /*******************************************************************************************************
  *
  * SZL-ID:  0x0132
@@ -3426,28 +3234,16 @@ s7comm_szl_0132_0004_register(int proto)
     proto_register_field_array(proto, hf, array_length(hf));
 }
 /*----------------------------------------------------------------------------------------------------*/
-static guint32
-s7comm_decode_szl_id_0132_idx_0004(tvbuff_t *tvb,
-                                    proto_tree *tree,
-                                    guint32 offset)
-{
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0004_index, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0004_key, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0004_param, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0004_real, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0004_bart_sch, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0004_crst_wrst, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0004_res, tvb, offset, 28, ENC_NA);
-    offset += 28;
-
-    return offset;
-}
+static const s7comm_szl_field_t s7comm_szl_0132_0004_layout[] = {
+    { 0,  2,  &hf_s7comm_szl_0132_0004_index,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 2,  2,  &hf_s7comm_szl_0132_0004_key,       ENC_BIG_ENDIAN, NULL, NULL },
+    { 4,  2,  &hf_s7comm_szl_0132_0004_param,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 6,  2,  &hf_s7comm_szl_0132_0004_real,      ENC_BIG_ENDIAN, NULL, NULL },
+    { 8,  2,  &hf_s7comm_szl_0132_0004_bart_sch,  ENC_BIG_ENDIAN, NULL, NULL },
+    { 10, 2,  &hf_s7comm_szl_0132_0004_crst_wrst, ENC_BIG_ENDIAN, NULL, NULL },
+    { 12, 28, &hf_s7comm_szl_0132_0004_res,       ENC_NA,         NULL, NULL },
+    { 0, 0, NULL, 0, NULL, NULL }
+};
 /*******************************************************************************************************
  *
  * SZL-ID:  0x0132
@@ -3489,26 +3285,15 @@ s7comm_szl_0132_0005_register(int proto)
     proto_register_field_array(proto, hf, array_length(hf));
 }
 /*----------------------------------------------------------------------------------------------------*/
-static guint32
-s7comm_decode_szl_id_0132_idx_0005(tvbuff_t *tvb,
-                                    proto_tree *tree,
-                                    guint32 offset)
-{
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0005_index, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0005_erw, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0005_send, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0005_moeg, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0005_ltmerz, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0005_res, tvb, offset, 30, ENC_NA);
-    offset += 30;
-
-    return offset;
-}
+static const s7comm_szl_field_t s7comm_szl_0132_0005_layout[] = {
+    { 0,  2,  &hf_s7comm_szl_0132_0005_index,  ENC_BIG_ENDIAN, NULL, NULL },
+    { 2,  2,  &hf_s7comm_szl_0132_0005_erw,    ENC_BIG_ENDIAN, NULL, NULL },
+    { 4,  2,  &hf_s7comm_szl_0132_0005_send,   ENC_BIG_ENDIAN, NULL, NULL },
+    { 6,  2,  &hf_s7comm_szl_0132_0005_moeg,   ENC_BIG_ENDIAN, NULL, NULL },
+    { 8,  2,  &hf_s7comm_szl_0132_0005_ltmerz, ENC_BIG_ENDIAN, NULL, NULL },
+    { 10, 30, &hf_s7comm_szl_0132_0005_res,    ENC_NA,         NULL, NULL },
+    { 0, 0, NULL, 0, NULL, NULL }
+};
 /*******************************************************************************************************
  *
  * SZL-ID:  0x0132
@@ -3572,90 +3357,71 @@ s7comm_szl_0132_0006_register(int proto)
     proto_register_field_array(proto, hf, array_length(hf));
 }
 /*----------------------------------------------------------------------------------------------------*/
-static guint32
-s7comm_decode_szl_id_0132_idx_0006(tvbuff_t *tvb,
-                                    proto_tree *tree,
-                                    guint32 offset)
-{
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0006_index, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
+static const s7comm_szl_field_t s7comm_szl_0132_0006_layout[] = {
+    { 0,  2,  &hf_s7comm_szl_0132_0006_index,         ENC_BIG_ENDIAN, NULL, NULL },
     /* Funct from 0x131 Index 6 */
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0006_used_0, tvb, offset, 1, ENC_NA);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_0_0, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_0_1, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_0_2, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_0_3, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_0_4, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_0_5, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_0_6, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_0_7, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0006_used_1, tvb, offset, 1, ENC_NA);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_1_0, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_1_1, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_1_2, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_1_3, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_1_4, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_1_5, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_1_6, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_1_7, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0006_used_2, tvb, offset, 1, ENC_NA);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_2_0, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_2_1, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_2_2, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_2_3, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_2_4, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_2_5, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_2_6, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_2_7, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0006_used_3, tvb, offset, 1, ENC_NA);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_3_0, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_3_1, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_3_2, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_3_3, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_3_4, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_3_5, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_3_6, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_3_7, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0006_used_4, tvb, offset, 1, ENC_NA);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0006_used_5, tvb, offset, 1, ENC_NA);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0006_used_6, tvb, offset, 1, ENC_NA);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_6_0, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_6_1, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_6_2, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_6_3, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_6_4, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_6_5, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_6_6, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_6_7, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0006_used_7, tvb, offset, 1, ENC_NA);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_7_0, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_7_1, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_7_2, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_7_3, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_7_4, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_7_5, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_7_6, tvb, offset, 1, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_0131_0006_funkt_7_7, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0006_anz_schnell, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0006_anz_inst, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0006_anz_multicast, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0132_0006_res, tvb, offset, 25, ENC_NA);
-    offset += 25;
-
-    return offset;
-}
+    { 2,  1,  &hf_s7comm_szl_0132_0006_used_0,        ENC_NA,         NULL, NULL },
+    { 2,  1,  &hf_s7comm_szl_0131_0006_funkt_0_0,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 2,  1,  &hf_s7comm_szl_0131_0006_funkt_0_1,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 2,  1,  &hf_s7comm_szl_0131_0006_funkt_0_2,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 2,  1,  &hf_s7comm_szl_0131_0006_funkt_0_3,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 2,  1,  &hf_s7comm_szl_0131_0006_funkt_0_4,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 2,  1,  &hf_s7comm_szl_0131_0006_funkt_0_5,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 2,  1,  &hf_s7comm_szl_0131_0006_funkt_0_6,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 2,  1,  &hf_s7comm_szl_0131_0006_funkt_0_7,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 3,  1,  &hf_s7comm_szl_0132_0006_used_1,        ENC_NA,         NULL, NULL },
+    { 3,  1,  &hf_s7comm_szl_0131_0006_funkt_1_0,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 3,  1,  &hf_s7comm_szl_0131_0006_funkt_1_1,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 3,  1,  &hf_s7comm_szl_0131_0006_funkt_1_2,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 3,  1,  &hf_s7comm_szl_0131_0006_funkt_1_3,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 3,  1,  &hf_s7comm_szl_0131_0006_funkt_1_4,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 3,  1,  &hf_s7comm_szl_0131_0006_funkt_1_5,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 3,  1,  &hf_s7comm_szl_0131_0006_funkt_1_6,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 3,  1,  &hf_s7comm_szl_0131_0006_funkt_1_7,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 4,  1,  &hf_s7comm_szl_0132_0006_used_2,        ENC_NA,         NULL, NULL },
+    { 4,  1,  &hf_s7comm_szl_0131_0006_funkt_2_0,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 4,  1,  &hf_s7comm_szl_0131_0006_funkt_2_1,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 4,  1,  &hf_s7comm_szl_0131_0006_funkt_2_2,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 4,  1,  &hf_s7comm_szl_0131_0006_funkt_2_3,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 4,  1,  &hf_s7comm_szl_0131_0006_funkt_2_4,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 4,  1,  &hf_s7comm_szl_0131_0006_funkt_2_5,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 4,  1,  &hf_s7comm_szl_0131_0006_funkt_2_6,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 4,  1,  &hf_s7comm_szl_0131_0006_funkt_2_7,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 5,  1,  &hf_s7comm_szl_0132_0006_used_3,        ENC_NA,         NULL, NULL },
+    { 5,  1,  &hf_s7comm_szl_0131_0006_funkt_3_0,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 5,  1,  &hf_s7comm_szl_0131_0006_funkt_3_1,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 5,  1,  &hf_s7comm_szl_0131_0006_funkt_3_2,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 5,  1,  &hf_s7comm_szl_0131_0006_funkt_3_3,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 5,  1,  &hf_s7comm_szl_0131_0006_funkt_3_4,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 5,  1,  &hf_s7comm_szl_0131_0006_funkt_3_5,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 5,  1,  &hf_s7comm_szl_0131_0006_funkt_3_6,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 5,  1,  &hf_s7comm_szl_0131_0006_funkt_3_7,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 6,  1,  &hf_s7comm_szl_0132_0006_used_4,        ENC_NA,         NULL, NULL },
+    { 7,  1,  &hf_s7comm_szl_0132_0006_used_5,        ENC_NA,         NULL, NULL },
+    { 8,  1,  &hf_s7comm_szl_0132_0006_used_6,        ENC_NA,         NULL, NULL },
+    { 8,  1,  &hf_s7comm_szl_0131_0006_funkt_6_0,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 8,  1,  &hf_s7comm_szl_0131_0006_funkt_6_1,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 8,  1,  &hf_s7comm_szl_0131_0006_funkt_6_2,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 8,  1,  &hf_s7comm_szl_0131_0006_funkt_6_3,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 8,  1,  &hf_s7comm_szl_0131_0006_funkt_6_4,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 8,  1,  &hf_s7comm_szl_0131_0006_funkt_6_5,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 8,  1,  &hf_s7comm_szl_0131_0006_funkt_6_6,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 8,  1,  &hf_s7comm_szl_0131_0006_funkt_6_7,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 9,  1,  &hf_s7comm_szl_0132_0006_used_7,        ENC_NA,         NULL, NULL },
+    { 9,  1,  &hf_s7comm_szl_0131_0006_funkt_7_0,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 9,  1,  &hf_s7comm_szl_0131_0006_funkt_7_1,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 9,  1,  &hf_s7comm_szl_0131_0006_funkt_7_2,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 9,  1,  &hf_s7comm_szl_0131_0006_funkt_7_3,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 9,  1,  &hf_s7comm_szl_0131_0006_funkt_7_4,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 9,  1,  &hf_s7comm_szl_0131_0006_funkt_7_5,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 9,  1,  &hf_s7comm_szl_0131_0006_funkt_7_6,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 9,  1,  &hf_s7comm_szl_0131_0006_funkt_7_7,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 10, 1,  &hf_s7comm_szl_0132_0006_anz_schnell,   ENC_BIG_ENDIAN, NULL, NULL },
+    { 11, 2,  &hf_s7comm_szl_0132_0006_anz_inst,      ENC_BIG_ENDIAN, NULL, NULL },
+    { 13, 2,  &hf_s7comm_szl_0132_0006_anz_multicast, ENC_BIG_ENDIAN, NULL, NULL },
+    { 15, 25, &hf_s7comm_szl_0132_0006_res,           ENC_NA,         NULL, NULL },
+    { 0, 0, NULL, 0, NULL, NULL }
+};
 /*******************************************************************************************************
  *
  * SZL-ID:  0xxy74
@@ -3695,23 +3461,15 @@ s7comm_szl_xy74_0000_register(int proto)
     proto_register_field_array(proto, hf, array_length(hf));
 }
 /*----------------------------------------------------------------------------------------------------*/
-static guint32
-s7comm_decode_szl_id_xy74_idx_0000(tvbuff_t *tvb,
-                                    proto_tree *tree,
-                                    guint32 offset)
-{
-    proto_tree_add_item(tree, hf_s7comm_szl_xy74_0000_cpu_led_id, tvb, offset, 2, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_xy74_0000_cpu_led_id_rackno, tvb, offset, 2, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_xy74_0000_cpu_led_id_cputype, tvb, offset, 2, ENC_BIG_ENDIAN);
-    proto_tree_add_item(tree, hf_s7comm_szl_xy74_0000_cpu_led_id_id, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_xy74_0000_led_on, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_xy74_0000_led_blink, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-
-    return offset;
-}
+static const s7comm_szl_field_t s7comm_szl_xy74_0000_layout[] = {
+    { 0,  2,  &hf_s7comm_szl_xy74_0000_cpu_led_id,         ENC_BIG_ENDIAN, NULL, NULL },
+    { 0,  2,  &hf_s7comm_szl_xy74_0000_cpu_led_id_rackno,  ENC_BIG_ENDIAN, NULL, NULL },
+    { 0,  2,  &hf_s7comm_szl_xy74_0000_cpu_led_id_cputype, ENC_BIG_ENDIAN, NULL, NULL },
+    { 0,  2,  &hf_s7comm_szl_xy74_0000_cpu_led_id_id,      ENC_BIG_ENDIAN, NULL, NULL },
+    { 2,  1,  &hf_s7comm_szl_xy74_0000_led_on,             ENC_BIG_ENDIAN, NULL, NULL },
+    { 3,  1,  &hf_s7comm_szl_xy74_0000_led_blink,          ENC_BIG_ENDIAN, NULL, NULL },
+    { 0, 0, NULL, 0, NULL, NULL }
+};
 
 /*******************************************************************************************************
  *
@@ -3773,34 +3531,519 @@ s7comm_szl_0424_0000_register(int proto)
     proto_register_field_array(proto, hf, array_length(hf));
 }
 /*----------------------------------------------------------------------------------------------------*/
+static const s7comm_szl_field_t s7comm_szl_0424_0000_layout[] = {
+    { 0,  2,  &hf_s7comm_szl_0424_0000_ereig,    ENC_BIG_ENDIAN, NULL, NULL },
+    { 2,  1,  &hf_s7comm_szl_0424_0000_ae,       ENC_BIG_ENDIAN, NULL, NULL },
+    { 3,  1,  &hf_s7comm_szl_0424_0000_bzu_id,   ENC_BIG_ENDIAN, &ett_s7comm_szl_0424_0000_bzu_id, s7comm_szl_0424_0000_bzu_id_fields },
+    { 4,  4,  &hf_s7comm_szl_0424_0000_res,      ENC_NA,         NULL, NULL },
+    { 8,  1,  &hf_s7comm_szl_0424_0000_anlinfo1, ENC_BIG_ENDIAN, NULL, NULL },
+    { 9,  1,  &hf_s7comm_szl_0424_0000_anlinfo2, ENC_BIG_ENDIAN, NULL, NULL },
+    { 10, 1,  &hf_s7comm_szl_0424_0000_anlinfo3, ENC_BIG_ENDIAN, NULL, NULL },
+    { 11, 1,  &hf_s7comm_szl_0424_0000_anlinfo4, ENC_BIG_ENDIAN, NULL, NULL },
+    { 12, 8,  &hf_s7comm_szl_0424_0000_time,     ENC_NA,         NULL, NULL },
+    { 0, 0, NULL, 0, NULL, NULL }
+};
+
+/*******************************************************************************************************
+ *
+ * Decode a record at offset with the fields of a layout. Returns the offset after the last field.
+ *
+ *******************************************************************************************************/
+static guint32
+s7comm_szl_decode_layout(tvbuff_t *tvb,
+                         proto_tree *tree,
+                         const s7comm_szl_field_t *layout,
+                         guint32 offset)
+{
+    const s7comm_szl_field_t *field;
+    guint32 end = offset;
+
+    for (field = layout; field->hf != NULL; field++) {
+        if (field->ett != NULL) {
+            proto_tree_add_bitmask(tree, tvb, offset + field->offset, *field->hf, *field->ett, field->fields, field->encoding);
+        } else {
+            proto_tree_add_item(tree, *field->hf, tvb, offset + field->offset, field->len, field->encoding);
+        }
+        if (offset + field->offset + field->len > end) {
+            end = offset + field->offset + field->len;
+        }
+    }
+    return end;
+}
+
+/*******************************************************************************************************
+ *
+ * SZL-ID:  0xxyA0
+ * Index:   0x0000 or number of entries
+ * Content:
+ *  The diagnostic buffer of the CPU. W#16#00A0 gives all entries, W#16#01A0 the most recent
+ *  entries, their number is the index. Each entry is the start information of the event with
+ *  the time stamp, the most recent entry first.
+ *
+ *******************************************************************************************************/
+static void
+s7comm_szl_xya0_0000_register(int proto)
+{
+    static hf_register_info hf[] = {
+        /*** SZL functions ***/
+        { &hf_s7comm_szl_xya0_0000_evid,
+        { "Event ID", "s7comm.szl.xya0.0000.evid", FT_UINT16, BASE_HEX, NULL, 0x0,
+          NULL, HFILL }},
+        { &hf_s7comm_szl_xya0_0000_evid_class,
+        { "Event class", "s7comm.szl.xya0.0000.evid.class", FT_UINT16, BASE_HEX, VALS(szl_xya0_0000_evid_class_names), 0xf000,
+          NULL, HFILL }},
+        { &hf_s7comm_szl_xya0_0000_evid_coming,
+        { "Coming event", "s7comm.szl.xya0.0000.evid.coming", FT_BOOLEAN, 16, NULL, 0x0100,
+          "Bit 8: Event coming (1) or going (0)", HFILL }},
+        { &hf_s7comm_szl_xya0_0000_evid_entry,
+        { "Entry in diagnostic buffer", "s7comm.szl.xya0.0000.evid.entry", FT_BOOLEAN, 16, NULL, 0x0200,
+          "Bit 9: Entry in diagnostic buffer", HFILL }},
+        { &hf_s7comm_szl_xya0_0000_evid_int_err,
+        { "Internal error", "s7comm.szl.xya0.0000.evid.int_err", FT_BOOLEAN, 16, NULL, 0x0400,
+          "Bit 10: Internal error", HFILL }},
+        { &hf_s7comm_szl_xya0_0000_evid_ext_err,
+        { "External error", "s7comm.szl.xya0.0000.evid.ext_err", FT_BOOLEAN, 16, NULL, 0x0800,
+          "Bit 11: External error", HFILL }},
+        { &hf_s7comm_szl_xya0_0000_evid_nr,
+        { "Event number", "s7comm.szl.xya0.0000.evid.nr", FT_UINT16, BASE_HEX, NULL, 0x00ff,
+          NULL, HFILL }},
+        { &hf_s7comm_szl_xya0_0000_prio,
+        { "Priority class", "s7comm.szl.xya0.0000.prio", FT_UINT8, BASE_DEC, NULL, 0x0,
+          "Priority class of the OB", HFILL }},
+        { &hf_s7comm_szl_xya0_0000_ob,
+        { "OB number", "s7comm.szl.xya0.0000.ob", FT_UINT8, BASE_DEC, NULL, 0x0,
+          NULL, HFILL }},
+        { &hf_s7comm_szl_xya0_0000_dat_id,
+        { "dat_id (Data identifier)", "s7comm.szl.xya0.0000.dat_id", FT_UINT16, BASE_HEX, NULL, 0x0,
+          "Identifier of the additional information", HFILL }},
+        { &hf_s7comm_szl_xya0_0000_info1,
+        { "info1 (Additional information 1)", "s7comm.szl.xya0.0000.info1", FT_UINT16, BASE_HEX, NULL, 0x0,
+          NULL, HFILL }},
+        { &hf_s7comm_szl_xya0_0000_info2,
+        { "info2 (Additional information 2)", "s7comm.szl.xya0.0000.info2", FT_UINT32, BASE_HEX, NULL, 0x0,
+          NULL, HFILL }},
+    };
+    proto_register_field_array(proto, hf, array_length(hf));
+}
+/*----------------------------------------------------------------------------------------------------*/
+static const s7comm_szl_field_t s7comm_szl_xya0_0000_layout[] = {
+    { 0,  2,  &hf_s7comm_szl_xya0_0000_evid,   ENC_BIG_ENDIAN, &ett_s7comm_szl_xya0_0000_evid, s7comm_szl_xya0_0000_evid_fields },
+    { 2,  1,  &hf_s7comm_szl_xya0_0000_prio,   ENC_BIG_ENDIAN, NULL, NULL },
+    { 3,  1,  &hf_s7comm_szl_xya0_0000_ob,     ENC_BIG_ENDIAN, NULL, NULL },
+    { 4,  2,  &hf_s7comm_szl_xya0_0000_dat_id, ENC_BIG_ENDIAN, NULL, NULL },
+    { 6,  2,  &hf_s7comm_szl_xya0_0000_info1,  ENC_BIG_ENDIAN, NULL, NULL },
+    { 8,  4,  &hf_s7comm_szl_xya0_0000_info2,  ENC_BIG_ENDIAN, NULL, NULL },
+    { 0, 0, NULL, 0, NULL, NULL }
+};
+
+/* The layout and the time stamp, which has no field of its own */
 static guint32
-s7comm_decode_szl_id_0424_idx_0000(tvbuff_t *tvb,
+s7comm_decode_szl_id_xya0_idx_0000(tvbuff_t *tvb,
                                     proto_tree *tree,
+                                    guint16 id _U_,
+                                    guint16 idx _U_,
                                     guint32 offset)
 {
-    proto_tree_add_item(tree, hf_s7comm_szl_0424_0000_ereig, tvb, offset, 2, ENC_BIG_ENDIAN);
-    offset += 2;
-    proto_tree_add_item(tree, hf_s7comm_szl_0424_0000_ae, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_bitmask(tree, tvb, offset, hf_s7comm_szl_0424_0000_bzu_id,
-        ett_s7comm_szl_0424_0000_bzu_id, s7comm_szl_0424_0000_bzu_id_fields, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0424_0000_res, tvb, offset, 4, ENC_NA);
-    offset += 4;
-    proto_tree_add_item(tree, hf_s7comm_szl_0424_0000_anlinfo1, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0424_0000_anlinfo2, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0424_0000_anlinfo3, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0424_0000_anlinfo4, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
-    proto_tree_add_item(tree, hf_s7comm_szl_0424_0000_time, tvb, offset, 8, ENC_NA);
-    offset += 8;
+    guint16 evid;
+
+    evid = tvb_get_ntohs(tvb, offset);
+    proto_item_append_text(tree, ": Event ID 0x%04x (%s)", evid,
+        val_to_str_const(evid >> 12, szl_xya0_0000_evid_class_names, "Unknown class"));
+    offset = s7comm_szl_decode_layout(tvb, tree, s7comm_szl_xya0_0000_layout, offset);
+    offset = s7comm_add_timestamp_to_tree(tvb, tree, offset, FALSE, FALSE, NULL);
 
     return offset;
 }
 
+/*******************************************************************************************************
+ *
+ * Take an event of a diagnostic buffer response for the tap, the record is at offset
+ *
+ *******************************************************************************************************/
+static void
+s7comm_szl_diag_add_record(tvbuff_t *tvb,
+                           s7comm_diag_tap_t *diag,
+                           guint32 offset)
+{
+    s7comm_diag_event_t *event;
+
+    event = &diag->events[diag->count++];
+    event->event_id = tvb_get_ntohs(tvb, offset);
+    event->event_class = val_to_str_const(event->event_id >> 12, szl_xya0_0000_evid_class_names, "Unknown class");
+    event->priority = tvb_get_guint8(tvb, offset + 2);
+    event->ob = tvb_get_guint8(tvb, offset + 3);
+    event->dat_id = tvb_get_ntohs(tvb, offset + 4);
+    event->info1 = tvb_get_ntohs(tvb, offset + 6);
+    event->info2 = tvb_get_ntohl(tvb, offset + 8);
+    /* Only the time, without a tree */
+    s7comm_add_timestamp_to_tree(tvb, NULL, offset + 12, FALSE, FALSE, &event->ts);
+    tvb_memcpy(tvb, event->record, offset, S7COMM_DIAG_RECORD_LEN);
+}
+
+/*******************************************************************************************************
+ *
+ * Take the facts for the inventory from a record of a SZL response, at offset.
+ * Uses the same offsets as the decode functions of the SZL-IDs above.
+ *
+ *******************************************************************************************************/
+static void
+s7comm_szl_inventory_add_record(tvbuff_t *tvb,
+                                s7comm_inventory_tap_t *inventory,
+                                guint16 id,
+                                guint16 idx,
+                                guint16 list_len,
+                                guint32 offset)
+{
+    guint16 rec_index;
+    guint16 ausbg;
+    guint16 ausbe;
+    guint8 led_on;
+    guint8 led_blink;
+
+    switch (id) {
+        case 0x0011:
+        case 0x0111:
+            if (list_len < 28) {
+                break;
+            }
+            /* With index 0x0000 all records, each with its own index */
+            rec_index = tvb_get_ntohs(tvb, offset);
+            ausbg = tvb_get_ntohs(tvb, offset + 24);
+            ausbe = tvb_get_ntohs(tvb, offset + 26);
+            if (rec_index == 0x0001) {
+                inventory->order_number = g_strstrip((gchar *)tvb_get_string_enc(wmem_packet_scope(), tvb, offset + 2, 20, ENC_ASCII));
+                inventory->hardware = wmem_strdup_printf(wmem_packet_scope(), "%u", ausbg);
+            } else if (rec_index == 0x0007) {
+                /* Basic firmware, Ausbg is 'V' and the major version */
+                if ((ausbg >> 8) == 'V') {
+                    inventory->firmware = wmem_strdup_printf(wmem_packet_scope(), "V%u.%u.%u",
+                        ausbg & 0xff, ausbe >> 8, ausbe & 0xff);
+                } else {
+                    inventory->firmware = wmem_strdup_printf(wmem_packet_scope(), "%u.%u", ausbg, ausbe);
+                }
+            }
+            break;
+        case 0x0131:
+            if (idx == 0x0001 && list_len >= 6) {
+                inventory->max_pdu = tvb_get_ntohs(tvb, offset + 2);
+                inventory->max_connections = tvb_get_ntohs(tvb, offset + 4);
+            }
+            break;
+        case 0x0132:
+            if (idx == 0x0001 && list_len >= 18) {
+                /* Established configured connections and used free connections */
+                inventory->has_conn_status = TRUE;
+                inventory->used_connections = tvb_get_ntohs(tvb, offset + 12) + tvb_get_ntohs(tvb, offset + 16);
+            } else if (idx == 0x0004 && list_len >= 10) {
+                inventory->protection_level = tvb_get_ntohs(tvb, offset + 6);
+                inventory->mode_switch = val_to_str(tvb_get_ntohs(tvb, offset + 8), szl_bart_sch_names, "Unknown (%u)");
+            }
+            break;
+        case 0x0019:
+        case 0x0119:
+        case 0x0074:
+        case 0x0174:
+            if (list_len < 4) {
+                break;
+            }
+            led_on = tvb_get_guint8(tvb, offset + 2);
+            led_blink = tvb_get_guint8(tvb, offset + 3);
+            if (inventory->leds == NULL) {
+                inventory->leds = wmem_strbuf_new(wmem_packet_scope(), "");
+            }
+            /* Only the LEDs which are lit, the others are off */
+            if (led_on || led_blink) {
+                if (wmem_strbuf_get_len(inventory->leds) > 0) {
+                    wmem_strbuf_append(inventory->leds, " ");
+                }
+                wmem_strbuf_append_printf(inventory->leds, "%s%s",
+                    val_to_str(tvb_get_guint8(tvb, offset + 1), szl_0174_index_names, "LED %u"),
+                    led_blink ? " (flashing)" : "");
+            }
+            break;
+        case 0x0124:
+        case 0x0424:
+            if (idx == 0x0000 && list_len >= 4) {
+                /* Requested mode of the last mode transition */
+                inventory->mode = val_to_str(tvb_get_guint8(tvb, offset + 3) & 0x0f, szl_0424_0000_bzu_id_names, "Unknown (0x%x)");
+            }
+            break;
+    }
+}
+
+/*******************************************************************************************************
+ *
+ * Registry of the SZL decoders
+ *
+ * The known SZL-IDs and indexes as patterns: a decoder applies to a response when the SZL-ID and
+ * index are equal to the pattern in the bits of the masks. The decoder of a response and the
+ * description of its index are looked up once per SZL-ID and index, and kept in a hash table.
+ * Most records have a fixed layout, these are decoded from the layout arrays above by
+ * s7comm_szl_decode_layout(), only records depending on the SZL-ID have an own function.
+ * The layout of a record with an own function is used for the JSON export, if it has one.
+ *
+ *******************************************************************************************************/
+static const s7comm_szl_decoder_t s7comm_szl_builtin_decoders[] = {
+    /* SZL-ID   ID mask Index   Index mask  Decoder                     Layout                          Index names             Record length */
+    { 0x0000,  0x00ff, 0x0000, 0x0000,     s7comm_decode_szl_id_xy00,  NULL,                           NULL,                   2 },
+    { 0x0013,  0xffff, 0x0000, 0xffff,     NULL,                       s7comm_szl_0013_0000_layout,    NULL,                   36 },
+    { 0x0011,  0xfeff, 0x0000, 0xfffe,     NULL,                       s7comm_szl_0111_0001_layout,    NULL,                   28 },
+    { 0x0131,  0xffff, 0x0001, 0xffff,     NULL,                       s7comm_szl_0131_0001_layout,    NULL,                   40 },
+    { 0x0131,  0xffff, 0x0002, 0xffff,     NULL,                       s7comm_szl_0131_0002_layout,    NULL,                   40 },
+    { 0x0131,  0xffff, 0x0003, 0xffff,     NULL,                       s7comm_szl_0131_0003_layout,    NULL,                   40 },
+    { 0x0131,  0xffff, 0x0004, 0xffff,     NULL,                       s7comm_szl_0131_0004_layout,    NULL,                   40 },
+    { 0x0131,  0xffff, 0x0006, 0xffff,     NULL,                       s7comm_szl_0131_0006_layout,    NULL,                   40 },
+    { 0x0131,  0xffff, 0x0010, 0xffff,     NULL,                       s7comm_szl_0131_0010_layout,    NULL,                   40 },
+    { 0x0132,  0xffff, 0x0001, 0xffff,     NULL,                       s7comm_szl_0132_0001_layout,    NULL,                   30 },
+    { 0x0132,  0xffff, 0x0002, 0xffff,     NULL,                       s7comm_szl_0132_0002_layout,    NULL,                   40 },
+    { 0x0132,  0xffff, 0x0004, 0xffff,     NULL,                       s7comm_szl_0132_0004_layout,    NULL,                   40 },
+    { 0x0132,  0xffff, 0x0005, 0xffff,     NULL,                       s7comm_szl_0132_0005_layout,    NULL,                   40 },
+    { 0x0132,  0xffff, 0x0006, 0xffff,     NULL,                       s7comm_szl_0132_0006_layout,    NULL,                   40 },
+    { 0x0019,  0xfeff, 0x0000, 0x0000,     NULL,                       s7comm_szl_xy74_0000_layout,    NULL,                   4 },
+    { 0x0074,  0xfeff, 0x0000, 0x0000,     NULL,                       s7comm_szl_xy74_0000_layout,    NULL,                   4 },
+    { 0x0124,  0xffff, 0x0000, 0xffff,     NULL,                       s7comm_szl_0424_0000_layout,    NULL,                   20 },
+    { 0x0424,  0xffff, 0x0000, 0xffff,     NULL,                       s7comm_szl_0424_0000_layout,    NULL,                   20 },
+    { 0x00a0,  0xfeff, 0x0000, 0x0000,     s7comm_decode_szl_id_xya0_idx_0000, s7comm_szl_xya0_0000_layout, NULL,              20 },
+    /* Only the descriptions of the indexes */
+    { 0x0111,  0xffff, 0x0000, 0x0000,     NULL,                       NULL,                           szl_0111_index_names,   0 },
+    { 0x0112,  0xffff, 0x0000, 0x0000,     NULL,                       NULL,                           szl_0112_index_names,   0 },
+    { 0x0113,  0xffff, 0x0000, 0x0000,     NULL,                       NULL,                           szl_0113_index_names,   0 },
+    { 0x0114,  0xffff, 0x0000, 0x0000,     NULL,                       NULL,                           szl_0114_index_names,   0 },
+    { 0x0115,  0xffff, 0x0000, 0x0000,     NULL,                       NULL,                           szl_0115_index_names,   0 },
+    { 0x0116,  0xffff, 0x0000, 0x0000,     NULL,                       NULL,                           szl_0116_index_names,   0 },
+    { 0x0118,  0xffff, 0x0000, 0x0000,     NULL,                       NULL,                           szl_0118_index_names,   0 },
+    { 0x0119,  0xffff, 0x0000, 0x0000,     NULL,                       NULL,                           szl_0119_index_names,   0 },
+    { 0x0121,  0xffff, 0x0000, 0x0000,     NULL,                       NULL,                           szl_0121_index_names,   0 },
+    { 0x0222,  0xffff, 0x0000, 0x0000,     NULL,                       NULL,                           szl_0222_index_names,   0 },
+    { 0x0524,  0xffff, 0x0000, 0x0000,     NULL,                       NULL,                           szl_0524_index_names,   0 },
+    { 0x0131,  0xffff, 0x0000, 0x0000,     NULL,                       NULL,                           szl_0131_index_names,   0 },
+    { 0x0132,  0xffff, 0x0000, 0x0000,     NULL,                       NULL,                           szl_0132_index_names,   0 },
+    { 0x0174,  0xffff, 0x0000, 0x0000,     NULL,                       NULL,                           szl_0174_index_names,   0 },
+};
+
+/*******************************************************************************************************
+ *
+ * JSON export of the records, for the tap "s7comm_szl". The names are the abbreviations of the
+ * fields without "s7comm.szl.<id>.<index>.", the values are read as the fields define them.
+ *
+ *******************************************************************************************************/
+static void
+s7comm_szl_json_string(wmem_strbuf_t *buf,
+                       const gchar *str)
+{
+    wmem_strbuf_append_c(buf, '"');
+    for (; *str != '\0'; str++) {
+        if (*str == '"' || *str == '\\') {
+            wmem_strbuf_append_c(buf, '\\');
+            wmem_strbuf_append_c(buf, *str);
+        } else if ((guchar)*str < 0x20 || (guchar)*str > 0x7e) {
+            /* Texts from the PLC are ASCII, anything else is escaped as a Latin-1 character */
+            wmem_strbuf_append_printf(buf, "\\u%04x", (guchar)*str);
+        } else {
+            wmem_strbuf_append_c(buf, *str);
+        }
+    }
+    wmem_strbuf_append_c(buf, '"');
+}
+
+static void
+s7comm_szl_json_field(tvbuff_t *tvb,
+                      wmem_strbuf_t *buf,
+                      int hf,
+                      guint32 offset,
+                      guint16 len)
+{
+    header_field_info *hfinfo;
+    const gchar *name;
+    const gchar *text = NULL;
+    guint32 value = 0;
+    guint32 bitmask;
+    guint i;
+
+    hfinfo = proto_registrar_get_nth(hf);
+    name = hfinfo->abbrev;
+    /* Skip "s7comm.szl.<id>.<index>." */
+    for (i = 0; i < 4 && strchr(name, '.') != NULL; i++) {
+        name = strchr(name, '.') + 1;
+    }
+    if (wmem_strbuf_get_len(buf) > 0 && wmem_strbuf_get_str(buf)[wmem_strbuf_get_len(buf) - 1] != '{') {
+        wmem_strbuf_append_c(buf, ',');
+    }
+    s7comm_szl_json_string(buf, name);
+    wmem_strbuf_append_c(buf, ':');
+    switch (hfinfo->type) {
+        case FT_BOOLEAN:
+        case FT_UINT8:
+        case FT_UINT16:
+        case FT_UINT24:
+        case FT_UINT32:
+            switch (len) {
+                case 1:
+                    value = tvb_get_guint8(tvb, offset);
+                    break;
+                case 2:
+                    value = tvb_get_ntohs(tvb, offset);
+                    break;
+                case 3:
+                    value = tvb_get_ntoh24(tvb, offset);
+                    break;
+                default:
+                    value = tvb_get_ntohl(tvb, offset);
+                    break;
+            }
+            bitmask = (guint32)hfinfo->bitmask;
+            if (bitmask != 0) {
+                value &= bitmask;
+                while ((bitmask & 1) == 0) {
+                    bitmask >>= 1;
+                    value >>= 1;
+                }
+            }
+            if (hfinfo->type == FT_BOOLEAN) {
+                wmem_strbuf_append(buf, value ? "true" : "false");
+                break;
+            }
+            wmem_strbuf_append_printf(buf, "%u", value);
+            if (hfinfo->strings != NULL && (hfinfo->display & BASE_RANGE_STRING) == 0) {
+                if (hfinfo->display & BASE_EXT_STRING) {
+                    text = try_val_to_str_ext(value, (value_string_ext *)hfinfo->strings);
+                } else {
+                    text = try_val_to_str(value, (const value_string *)hfinfo->strings);
+                }
+            }
+            if (text != NULL) {
+                wmem_strbuf_append_c(buf, ',');
+                s7comm_szl_json_string(buf, wmem_strdup_printf(wmem_packet_scope(), "%s_name", name));
+                wmem_strbuf_append_c(buf, ':');
+                s7comm_szl_json_string(buf, text);
+            }
+            break;
+        case FT_STRING:
+            s7comm_szl_json_string(buf, (const gchar *)tvb_get_string_enc(wmem_packet_scope(), tvb, offset, len, ENC_ASCII));
+            break;
+        default:
+            s7comm_szl_json_string(buf, tvb_bytes_to_ep_str(tvb, offset, len));
+            break;
+    }
+}
+
+/* A record as JSON object, the bytes without a field of the layout are in "data" */
+static void
+s7comm_szl_json_record(tvbuff_t *tvb,
+                       wmem_strbuf_t *buf,
+                       const s7comm_szl_decoder_t *decoder,
+                       guint16 list_len,
+                       guint32 offset)
+{
+    const s7comm_szl_field_t *field;
+    guint16 end = 0;
+    guint i;
+
+    wmem_strbuf_append_c(buf, '{');
+    if (decoder != NULL && decoder->layout != NULL) {
+        for (field = decoder->layout; field->hf != NULL; field++) {
+            s7comm_szl_json_field(tvb, buf, *field->hf, offset + field->offset, field->len);
+            for (i = 0; field->fields != NULL && field->fields[i] != NULL; i++) {
+                s7comm_szl_json_field(tvb, buf, *field->fields[i], offset + field->offset, field->len);
+            }
+            if (field->offset + field->len > end) {
+                end = field->offset + field->len;
+            }
+        }
+    }
+    if (end < list_len) {
+        if (end > 0) {
+            wmem_strbuf_append_c(buf, ',');
+        }
+        wmem_strbuf_append(buf, "\"data\":");
+        s7comm_szl_json_string(buf, tvb_bytes_to_ep_str(tvb, offset + end, list_len - end));
+    }
+    wmem_strbuf_append_c(buf, '}');
+}
+
+/* What is known of a SZL-ID and index */
+typedef struct {
+    const s7comm_szl_decoder_t *decoder;    /* NULL if the records are shown as raw bytes */
+    const gchar *description;               /* Description of the index, NULL if not available */
+} s7comm_szl_resolved_t;
+
+/* Registered decoders, the last registered first */
+static GSList *s7comm_szl_decoders = NULL;
+/* (SZL-ID << 16 | index) -> s7comm_szl_resolved_t */
+static GHashTable *s7comm_szl_resolved = NULL;
+/* Limit of the lookup table, the SZL-ID and index come from the network */
+#define S7COMM_SZL_RESOLVED_MAX     1024
+
+/*******************************************************************************************************
+ *
+ * Register a decoder for a SZL-ID and index pattern. A decoder registered later takes precedence
+ * over the ones before, also over the built in ones, so a plugin can add or replace the decoding
+ * of site specific partial lists from its handoff, see packet-s7comm_szl_decoder.h.
+ * The decoder must exist as long as the program.
+ *
+ *******************************************************************************************************/
+G_MODULE_EXPORT void
+s7comm_szl_register_decoder(const s7comm_szl_decoder_t *decoder)
+{
+    s7comm_szl_decoders = g_slist_prepend(s7comm_szl_decoders, (gpointer)decoder);
+    if (s7comm_szl_resolved != NULL) {
+        g_hash_table_remove_all(s7comm_szl_resolved);
+    }
+}
+
+static gboolean
+s7comm_szl_decoder_matches(const s7comm_szl_decoder_t *decoder,
+                           guint16 id,
+                           guint16 idx)
+{
+    return ((id & decoder->id_mask) == decoder->id) && ((idx & decoder->index_mask) == decoder->index);
+}
+
+static const s7comm_szl_resolved_t *
+s7comm_szl_resolve(guint16 id,
+                   guint16 idx)
+{
+    s7comm_szl_resolved_t *resolved;
+    const s7comm_szl_decoder_t *decoder;
+    GSList *entry;
+    guint key = ((guint)id << 16) | idx;
+
+    if (s7comm_szl_resolved == NULL) {
+        s7comm_szl_resolved = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+    }
+    resolved = (s7comm_szl_resolved_t *)g_hash_table_lookup(s7comm_szl_resolved, GUINT_TO_POINTER(key));
+    if (resolved != NULL) {
+        return resolved;
+    }
+    resolved = g_new0(s7comm_szl_resolved_t, 1);
+    for (entry = s7comm_szl_decoders; entry != NULL; entry = g_slist_next(entry)) {
+        decoder = (const s7comm_szl_decoder_t *)entry->data;
+        if (!s7comm_szl_decoder_matches(decoder, id, idx)) {
+            continue;
+        }
+        if (resolved->decoder == NULL && (decoder->decode != NULL || decoder->layout != NULL)) {
+            resolved->decoder = decoder;
+        }
+        if (resolved->description == NULL && decoder->index_names != NULL) {
+            resolved->description = try_val_to_str(idx, decoder->index_names);
+            if (resolved->description == NULL) {
+                resolved->description = "No description available";
+            }
+        }
+    }
+    if (g_hash_table_size(s7comm_szl_resolved) >= S7COMM_SZL_RESOLVED_MAX) {
+        g_hash_table_remove_all(s7comm_szl_resolved);
+    }
+    g_hash_table_insert(s7comm_szl_resolved, GUINT_TO_POINTER(key), resolved);
+    return resolved;
+}
+
+static void
+s7comm_szl_init(void)
+{
+    s7comm_szl_responses = wmem_tree_new(wmem_file_scope());
+}
+
 /*******************************************************************************************************
  *
  * Register SZL header fields
@@ -3809,6 +4052,8 @@ s7comm_decode_szl_id_0424_idx_0000(tvbuff_t *tvb,
 void
 s7comm_register_szl_types(int proto)
 {
+    guint i;
+
     static hf_register_info hf[] = {
         /*** SZL functions ***/
         { &hf_s7comm_userdata_szl_partial_list,
@@ -3890,6 +4135,8 @@ s7comm_register_szl_types(int proto)
 
         &ett_s7comm_szl_0424_0000_bzu_id,
 
+        &ett_s7comm_szl_xya0_0000_evid,
+
     };
     proto_register_subtree_array(ett, array_length (ett));
 
@@ -3918,6 +4165,230 @@ s7comm_register_szl_types(int proto)
     s7comm_szl_xy74_0000_register(proto);
 
     s7comm_szl_0424_0000_register(proto);
+
+    s7comm_szl_xya0_0000_register(proto);
+
+    s7comm_inventory_tap = register_tap("s7comm_inventory");
+    s7comm_diag_tap = register_tap("s7comm_diag");
+    s7comm_szl_tap = register_tap("s7comm_szl");
+
+    proto_s7comm_szl = proto;
+    register_init_routine(s7comm_szl_init);
+
+    for (i = 0; i < array_length(s7comm_szl_builtin_decoders); i++) {
+        s7comm_szl_register_decoder(&s7comm_szl_builtin_decoders[i]);
+    }
+}
+
+/*******************************************************************************************************
+ *
+ * The SZL response of a connection and data unit reference which is not complete yet
+ *
+ *******************************************************************************************************/
+static s7comm_szl_response_t *
+s7comm_szl_get_response(packet_info *pinfo,
+                        guint8 data_unit_ref)
+{
+    wmem_tree_key_t key[2];
+    guint32 response_key[2];
+
+    response_key[0] = find_or_create_conversation(pinfo)->index;
+    response_key[1] = data_unit_ref;
+    key[0].length = 2;
+    key[0].key = response_key;
+    key[1].length = 0;
+    key[1].key = NULL;
+    return (s7comm_szl_response_t *)wmem_tree_lookup32_array(s7comm_szl_responses, key);
+}
+
+static void
+s7comm_szl_set_response(packet_info *pinfo,
+                        guint8 data_unit_ref,
+                        s7comm_szl_response_t *response)
+{
+    wmem_tree_key_t key[2];
+    guint32 response_key[2];
+
+    response_key[0] = find_or_create_conversation(pinfo)->index;
+    response_key[1] = data_unit_ref;
+    key[0].length = 2;
+    key[0].key = response_key;
+    key[1].length = 0;
+    key[1].key = NULL;
+    wmem_tree_insert32_array(s7comm_szl_responses, key, response);
+}
+
+/*******************************************************************************************************
+ *
+ * Records of an SZL response, list_count records of list_len bytes at offset. first_no is the number
+ * of the first one in the response, more_units is set if data units of the response follow.
+ * The records are also passed to the taps.
+ *
+ *******************************************************************************************************/
+static guint32
+s7comm_szl_decode_records(tvbuff_t *tvb,
+                          packet_info *pinfo,
+                          proto_tree *data_tree,
+                          guint16 id,
+                          guint16 idx,
+                          guint16 list_len,
+                          guint16 list_count,
+                          guint16 first_no,
+                          guint8 data_unit_ref,
+                          gboolean more_units,
+                          guint32 offset)
+{
+    guint16 i;
+    proto_item *szl_item = NULL;
+    proto_tree *szl_item_tree = NULL;
+    const s7comm_szl_decoder_t *decoder;
+    guint32 record_offset;
+    s7comm_inventory_tap_t *inventory = NULL;
+    s7comm_diag_tap_t *diag = NULL;
+    s7comm_szl_tap_t *szl_tap = NULL;
+
+    /* Records shorter than the decoder expects are shown as raw bytes */
+    decoder = s7comm_szl_resolve(id, idx)->decoder;
+    if (decoder != NULL && list_len < decoder->record_len) {
+        decoder = NULL;
+    }
+    if (have_tap_listener(s7comm_inventory_tap)) {
+        inventory = wmem_new0(wmem_packet_scope(), s7comm_inventory_tap_t);
+        inventory->id = id;
+        inventory->index = idx;
+    }
+    if ((id & 0xfeff) == 0x00a0 && list_len >= S7COMM_DIAG_RECORD_LEN && list_count > 0
+            && have_tap_listener(s7comm_diag_tap)) {
+        diag = wmem_new0(wmem_packet_scope(), s7comm_diag_tap_t);
+        diag->events = wmem_alloc0_array(wmem_packet_scope(), s7comm_diag_event_t, list_count);
+    }
+    if (have_tap_listener(s7comm_szl_tap)) {
+        szl_tap = wmem_new0(wmem_packet_scope(), s7comm_szl_tap_t);
+        szl_tap->id = id;
+        szl_tap->index = idx;
+        szl_tap->records = wmem_strbuf_new(wmem_packet_scope(), "");
+        szl_tap->conversation = find_or_create_conversation(pinfo)->index;
+        szl_tap->data_unit_ref = data_unit_ref;
+        szl_tap->first_unit = (first_no == 1);
+        szl_tap->more_units = more_units;
+    }
+    /* Add a Data element for each partlist */
+    for (i = 0; i < list_count; i++) {
+        if (inventory) {
+            s7comm_szl_inventory_add_record(tvb, inventory, id, idx, list_len, offset);
+        }
+        if (diag) {
+            s7comm_szl_diag_add_record(tvb, diag, offset);
+        }
+        if (szl_tap) {
+            if (szl_tap->count++ > 0) {
+                wmem_strbuf_append_c(szl_tap->records, ',');
+            }
+            s7comm_szl_json_record(tvb, szl_tap->records, decoder, list_len, offset);
+        }
+        /* Add a separate tree for the SZL data */
+        szl_item = proto_tree_add_item(data_tree, hf_s7comm_userdata_szl_tree, tvb, offset, list_len, ENC_NA);
+        szl_item_tree = proto_item_add_subtree(szl_item, ett_s7comm_szl);
+        proto_item_append_text(szl_item, " (list count no. %d)", first_no + i);
+
+        record_offset = offset;
+        if (decoder != NULL) {
+            if (decoder->decode != NULL) {
+                offset = decoder->decode(tvb, szl_item_tree, id, idx, offset);
+            } else {
+                offset = s7comm_szl_decode_layout(tvb, szl_item_tree, decoder->layout, offset);
+            }
+            /* The rest of a record which is longer than the decoder knows */
+            if (offset - record_offset < list_len) {
+                proto_tree_add_item(szl_item_tree, hf_s7comm_userdata_szl_partial_list, tvb, offset,
+                    list_len - (offset - record_offset), ENC_NA);
+                offset = record_offset + list_len;
+            }
+        } else {
+            proto_tree_add_item(szl_item_tree, hf_s7comm_userdata_szl_partial_list, tvb, offset, list_len, ENC_NA);
+            offset += list_len;
+        }
+    } /* ...for */
+    if (inventory) {
+        tap_queue_packet(s7comm_inventory_tap, pinfo, inventory);
+    }
+    if (diag) {
+        tap_queue_packet(s7comm_diag_tap, pinfo, diag);
+    }
+    if (szl_tap) {
+        tap_queue_packet(s7comm_szl_tap, pinfo, szl_tap);
+    }
+    return offset;
+}
+
+/*******************************************************************************************************
+ *
+ * A following data unit of an SZL response, len bytes of records at offset. They are decoded with the
+ * header of the first data unit, a record cut at the end of the data unit before is put together with
+ * its rest in a new data source.
+ *
+ *******************************************************************************************************/
+static guint32
+s7comm_szl_decode_next_data_unit(tvbuff_t *tvb,
+                                 packet_info *pinfo,
+                                 proto_tree *data_tree,
+                                 s7comm_szl_response_t *response,
+                                 guint8 data_unit_ref,
+                                 guint8 last_data_unit,
+                                 guint16 len,
+                                 guint32 offset)
+{
+    tvbuff_t *rec_tvb = tvb;
+    guint32 rec_offset = offset;
+    guint32 rec_len = len;
+    guint16 list_count;
+    gboolean more_units;
+    guint32 tbytes;
+    guint8 *buf;
+    proto_item *szl_item = NULL;
+    proto_tree *szl_item_tree = NULL;
+
+    proto_item_append_text(data_tree, " (SZL-ID: 0x%04x, Index: 0x%04x, continued)", response->id, response->index);
+    col_append_fstr(pinfo->cinfo, COL_INFO, " ID=0x%04x Index=0x%04x (continued)", response->id, response->index);
+
+    if (response->partial_len > 0) {
+        tvb_ensure_bytes_exist(tvb, offset, len);
+        rec_len = response->partial_len + len;
+        buf = (guint8 *)g_malloc(rec_len);
+        memcpy(buf, response->partial, response->partial_len);
+        tvb_memcpy(tvb, buf + response->partial_len, offset, len);
+        rec_tvb = tvb_new_child_real_data(tvb, buf, rec_len, rec_len);
+        tvb_set_free_cb(rec_tvb, g_free);
+        add_new_data_source(pinfo, rec_tvb, "SZL records");
+        rec_offset = 0;
+    }
+    list_count = (guint16)MIN(response->list_count, rec_len / response->list_len);
+    more_units = last_data_unit != 0 && response->list_count > list_count;
+    rec_offset = s7comm_szl_decode_records(rec_tvb, pinfo, data_tree, response->id, response->index,
+        response->list_len, list_count, response->next_no, data_unit_ref, more_units, rec_offset);
+
+    /* A record cut at the end of this data unit, or bytes behind the last record */
+    tbytes = rec_len - list_count * response->list_len;
+    if (tbytes > 0) {
+        szl_item = proto_tree_add_item(data_tree, hf_s7comm_userdata_szl_tree, rec_tvb, rec_offset, tbytes, ENC_NA);
+        szl_item_tree = proto_item_add_subtree(szl_item, ett_s7comm_szl);
+        proto_item_append_text(szl_item, " [Fragment, complete response doesn't fit one PDU]");
+        proto_tree_add_item(szl_item_tree, hf_s7comm_userdata_szl_data, rec_tvb, rec_offset, tbytes, ENC_NA);
+    }
+
+    if (!pinfo->fd->flags.visited) {
+        response->list_count -= list_count;
+        response->next_no += list_count;
+        response->partial = NULL;
+        response->partial_len = 0;
+        if (!more_units) {
+            s7comm_szl_set_response(pinfo, data_unit_ref, NULL);
+        } else if (tbytes > 0) {
+            response->partial = (guint8 *)tvb_memdup(wmem_file_scope(), rec_tvb, rec_offset, tbytes);
+            response->partial_len = (guint16)tbytes;
+        }
+    }
+    return offset + len;
 }
 
 /*******************************************************************************************************
@@ -3941,15 +4412,17 @@ s7comm_decode_ud_cpu_szl_subfunc(tvbuff_t *tvb,
     guint16 idx;
     guint16 list_len;
     guint16 list_count;
-    guint16 i;
+    guint16 total_count;
     guint16 tbytes = 0;
     proto_item *szl_item = NULL;
     proto_tree *szl_item_tree = NULL;
     proto_item *szl_item_entry = NULL;
-    const gchar* szl_index_description;
+    const s7comm_szl_resolved_t *resolved;
+    s7comm_szl_response_t *response = NULL;
+    s7comm_szl_response_t *saved;
+    gboolean more_units;
 
     gboolean know_data = FALSE;
-    gboolean szl_decoded = FALSE;
 
     if (type == S7COMM_UD_TYPE_REQ) {                   /*** Request ***/
         id = tvb_get_ntohs(tvb, offset);
@@ -3959,9 +4432,9 @@ s7comm_decode_ud_cpu_szl_subfunc(tvbuff_t *tvb,
         idx = tvb_get_ntohs(tvb, offset);
         szl_item_entry = proto_tree_add_item(data_tree, hf_s7comm_userdata_szl_index, tvb, offset, 2, ENC_BIG_ENDIAN);
         offset += 2;
-        szl_index_description = s7comm_get_szl_id_index_description_text(id, idx);
-        if (szl_index_description != NULL) {
-            proto_item_append_text(szl_item_entry, " [%s]", szl_index_description);
+        resolved = s7comm_szl_resolve(id, idx);
+        if (resolved->description != NULL) {
+            proto_item_append_text(szl_item_entry, " [%s]", resolved->description);
         }
         proto_item_append_text(data_tree, " (SZL-ID: 0x%04x, Index: 0x%04x)", id, idx);
         col_append_fstr(pinfo->cinfo, COL_INFO, " ID=0x%04x Index=0x%04x" , id, idx);
@@ -3970,12 +4443,28 @@ s7comm_decode_ud_cpu_szl_subfunc(tvbuff_t *tvb,
         /* When response OK, data follows */
         if (ret_val == S7COMM_ITEM_RETVAL_DATA_OK) {
             /* A fragmented response has a data-unit-ref <> 0 with Last-data-unit == 1
-             * It's only possible to decode the first response of a fragment, because
-             * only the first PDU contains the ID/Index header. Will result in an display-error when a PDU goes over more than 2 PDUs, but ... eeeek ... no better way to realize this.
+             * Only the first PDU contains the ID/Index header, the following ones are decoded with
+             * the header and the cut record remembered from the PDUs before. Without the first PDU
+             * in the capture the data is shown as raw bytes.
              * last_data_unit == 0 when it's the last unit
              * last_data_unit == 1 when it's not the last unit
              */
-            if (data_unit_ref != 0 && last_data_unit == 0) {
+            if (data_unit_ref != 0) {
+                if (!pinfo->fd->flags.visited) {
+                    response = s7comm_szl_get_response(pinfo, data_unit_ref);
+                    if (response != NULL) {
+                        /* As it was before this PDU, for the next passes */
+                        saved = wmem_new(wmem_file_scope(), s7comm_szl_response_t);
+                        *saved = *response;
+                        s7comm_add_pdu_data(pinfo, proto_s7comm_szl, S7COMM_PROTO_DATA_SZL, data_unit_ref, saved);
+                    }
+                } else {
+                    response = (s7comm_szl_response_t *)s7comm_get_pdu_data(pinfo, proto_s7comm_szl, S7COMM_PROTO_DATA_SZL, data_unit_ref);
+                }
+            }
+            if (response != NULL) {
+                offset = s7comm_szl_decode_next_data_unit(tvb, pinfo, data_tree, response, data_unit_ref, last_data_unit, len, offset);
+            } else if (data_unit_ref != 0 && last_data_unit == 0) {
                 szl_item = proto_tree_add_item(data_tree, hf_s7comm_userdata_szl_tree, tvb, offset, len, ENC_NA);
                 szl_item_tree = proto_item_add_subtree(szl_item, ett_s7comm_szl);
                 proto_item_append_text(szl_item, " [Fragment, continuation of previous data]");
@@ -3991,9 +4480,9 @@ s7comm_decode_ud_cpu_szl_subfunc(tvbuff_t *tvb,
                 idx = tvb_get_ntohs(tvb, offset);
                 szl_item_entry = proto_tree_add_item(data_tree, hf_s7comm_userdata_szl_index, tvb, offset, 2, ENC_BIG_ENDIAN);
                 offset += 2;
-                szl_index_description = s7comm_get_szl_id_index_description_text(id, idx);
-                if (szl_index_description != NULL) {
-                    proto_item_append_text(szl_item_entry, " [%s]", szl_index_description);
+                resolved = s7comm_szl_resolve(id, idx);
+                if (resolved->description != NULL) {
+                    proto_item_append_text(szl_item_entry, " [%s]", resolved->description);
                 }
                 proto_item_append_text(data_tree, " (SZL-ID: 0x%04x, Index: 0x%04x)", id, idx);
                 col_append_fstr(pinfo->cinfo, COL_INFO, " ID=0x%04x Index=0x%04x" , id, idx);
@@ -4006,108 +4495,34 @@ s7comm_decode_ud_cpu_szl_subfunc(tvbuff_t *tvb,
                 proto_tree_add_uint(data_tree, hf_s7comm_userdata_szl_id_partlist_cnt, tvb, offset, 2, list_count);
                 /* Some SZL responses got more lists than fit one PDU (e.g. Diagnosepuffer) and must be read
                  * out in several telegrams, so we have to check here if the list_count is above limits
-                 * of the length of data part. The remainding bytes will be print as raw bytes, because
-                 * it's not possible to decode this and following telegrams without knowing the previous requests.
+                 * of the length of data part. The remainding bytes will be print as raw bytes, and
+                 * are remembered with the header for the following telegrams.
                  */
+                total_count = list_count;
                 tbytes = 0;
-                if ((list_count * list_len) > (len - 8)) {
+                if (len >= 8 && (list_count * list_len) > (len - 8)) {
                     list_count = (len - 8) / list_len;
                     /* remind the number of trailing bytes */
-                    if (list_count > 0) {
-                        tbytes = (len - 8) % list_count;
-                    }
+                    tbytes = (len - 8) - list_count * list_len;
                 }
                 offset += 2;
-                /* Add a Data element for each partlist */
-                if (len > 8) {      /* minimum length of a correct szl data part is 8 bytes */
-                    for (i = 1; i <= list_count; i++) {
-                        /* Add a separate tree for the SZL data */
-                        szl_item = proto_tree_add_item(data_tree, hf_s7comm_userdata_szl_tree, tvb, offset, list_len, ENC_NA);
-                        szl_item_tree = proto_item_add_subtree(szl_item, ett_s7comm_szl);
-                        proto_item_append_text(szl_item, " (list count no. %d)", i);
-
-                        szl_decoded = FALSE;
-                        /* lets try to decode some known szl-id and indexes */
-                        switch (id) {
-                            case 0x0000:
-                                offset = s7comm_decode_szl_id_xy00(tvb, szl_item_tree, id, idx, offset);
-                                szl_decoded = TRUE;
-                                break;
-                            case 0x0013:
-                                if (idx == 0x0000) {
-                                    offset = s7comm_decode_szl_id_0013_idx_0000(tvb, szl_item_tree, offset);
-                                    szl_decoded = TRUE;
-                                }
-                                break;
-                            case 0x0011:
-                            case 0x0111:
-                                if ((idx == 0x0001) || (idx == 0x0000)) {
-                                    offset = s7comm_decode_szl_id_0111_idx_0001(tvb, szl_item_tree, offset);
-                                    szl_decoded = TRUE;
-                                }
-                                break;
-                            case 0x0131:
-                                if (idx == 0x0001) {
-                                    offset = s7comm_decode_szl_id_0131_idx_0001(tvb, szl_item_tree, offset);
-                                    szl_decoded = TRUE;
-                                } else if (idx == 0x0002) {
-                                    offset = s7comm_decode_szl_id_0131_idx_0002(tvb, szl_item_tree, offset);
-                                    szl_decoded = TRUE;
-                                } else if (idx == 0x0003) {
-                                    offset = s7comm_decode_szl_id_0131_idx_0003(tvb, szl_item_tree, offset);
-                                    szl_decoded = TRUE;
-                                } else if (idx == 0x0004) {
-                                    offset = s7comm_decode_szl_id_0131_idx_0004(tvb, szl_item_tree, offset);
-                                    szl_decoded = TRUE;
-                                } else if (idx == 0x0006) {
-                                    offset = s7comm_decode_szl_id_0131_idx_0006(tvb, szl_item_tree, offset);
-                                    szl_decoded = TRUE;
-                                } else if (idx == 0x0010) {
-                                    offset = s7comm_decode_szl_id_0131_idx_0010(tvb, szl_item_tree, offset);
-                                    szl_decoded = TRUE;
-                                }
-                                break;
-                            case 0x0132:
-                                if (idx == 0x0001) {
-                                    offset = s7comm_decode_szl_id_0132_idx_0001(tvb, szl_item_tree, offset);
-                                    szl_decoded = TRUE;
-                                } else if (idx == 0x0002) {
-                                    offset = s7comm_decode_szl_id_0132_idx_0002(tvb, szl_item_tree, offset);
-                                    szl_decoded = TRUE;
-                                } else if (idx == 0x0004) {
-                                    offset = s7comm_decode_szl_id_0132_idx_0004(tvb, szl_item_tree, offset);
-                                    szl_decoded = TRUE;
-                                } else if (idx == 0x0005) {
-                                    offset = s7comm_decode_szl_id_0132_idx_0005(tvb, szl_item_tree, offset);
-                                    szl_decoded = TRUE;
-                                } else if (idx == 0x0006) {
-                                    offset = s7comm_decode_szl_id_0132_idx_0006(tvb, szl_item_tree, offset);
-                                    szl_decoded = TRUE;
-                                }
-                                break;
-                            case 0x0019:
-                            case 0x0119:
-                            case 0x0074:
-                            case 0x0174:
-                                    offset = s7comm_decode_szl_id_xy74_idx_0000(tvb, szl_item_tree, offset);
-                                    szl_decoded = TRUE;
-                                break;
-                            case 0x0124:
-                            case 0x0424:
-                                if (idx == 0x0000) {
-                                    offset = s7comm_decode_szl_id_0424_idx_0000(tvb, szl_item_tree, offset);
-                                    szl_decoded = TRUE;
-                                }
-                                break;
-                            default:
-                                szl_decoded = FALSE;
-                                break;
-                        }
-                        if (szl_decoded == FALSE) {
-                            proto_tree_add_item(szl_item_tree, hf_s7comm_userdata_szl_partial_list, tvb, offset, list_len, ENC_NA);
-                            offset += list_len;
-                        }
-                    } /* ...for */
+                more_units = data_unit_ref != 0 && last_data_unit != 0 && list_len > 0 && list_count < total_count;
+                /* minimum length of a correct szl data part is 8 bytes */
+                offset = s7comm_szl_decode_records(tvb, pinfo, data_tree, id, idx, list_len,
+                    (len > 8) ? list_count : 0, 1, data_unit_ref, more_units, offset);
+                /* More data units follow, remember the header and the cut record for them */
+                if (more_units && !pinfo->fd->flags.visited) {
+                    response = wmem_new0(wmem_file_scope(), s7comm_szl_response_t);
+                    response->id = id;
+                    response->index = idx;
+                    response->list_len = list_len;
+                    response->list_count = total_count - list_count;
+                    response->next_no = list_count + 1;
+                    if (tbytes > 0) {
+                        response->partial = (guint8 *)tvb_memdup(wmem_file_scope(), tvb, offset, tbytes);
+                        response->partial_len = tbytes;
+                    }
+                    s7comm_szl_set_response(pinfo, data_unit_ref, response);
                 }
             }
         } else {
@@ -25,6 +25,8 @@
 #ifndef __PACKET_S7COMM_SZL_IDS_H__
 #define __PACKET_S7COMM_SZL_IDS_H__
 
+#include "packet-s7comm_szl_decoder.h"
+
 guint32 s7comm_decode_ud_cpu_szl_subfunc (tvbuff_t *tvb, packet_info *pinfo, proto_tree *data_tree, guint8 type, guint8 ret_val, guint16 len, guint16 dlength, guint8 data_unit_ref, guint8 last_data_unit, guint32 offset);
 void s7comm_register_szl_types(int proto);
 
@@ -0,0 +1,448 @@
+/* packet-s7comm_tap.c
+ *
+ * Author:      Thomas Wiens, 2014 (th.wiens@gmx.de)
+ * Description: Wireshark dissector for S7-Communication
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**************************************************************************
+ * Command line taps of the S7 plugin for tshark (-z option)
+ *
+ * -z "s7comm,dump,<plc>,<area>,<at>,<file>"
+ *   Writes the values of an area of a PLC as they were known from the
+ *   read and write traffic at a point of the capture:
+ *     plc   address of the PLC, e.g. 192.168.0.1
+ *     area  I, Q, M, P, T, C or DB<number>, e.g. DB10
+ *     at    frame number, or local time as "YYYY-MM-DD HH:MM:SS[.frac]"
+ *           or "HH:MM:SS[.frac]" on the day of the first frame
+ *     file  <file> gets the memory image from byte 0 up to the last known
+ *           byte, unknown bytes are 0. <file>.valid gets a bitmap with one
+ *           bit per byte of the image (LSB first), set if the byte is known.
+ *   The image is taken when the capture has passed the frame or time, so
+ *   that it does not depend on the memory limit of the shadow memory.
+ *
+ * -z "s7comm,pbc,<dir>"
+ *   Writes every reassembled PBC (BSEND/BRCV) message to a file in <dir>,
+ *   named <sender>_r_id_<R_ID>_frame_<frame>.bin.
+ *
+ * The other taps are in their own files, see packet-s7comm_tap.h.
+ **************************************************************************/
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <glib.h>
+#include <gmodule.h>
+#include <epan/packet.h>
+#include <epan/prefs.h>
+#include <epan/tap.h>
+#include <epan/stat_cmd_args.h>
+#include <wsutil/file_util.h>
+
+#include "packet-s7comm.h"
+#include "packet-s7comm_shadow.h"
+#include "packet-s7comm_tap.h"
+
+G_MODULE_EXPORT void plugin_register_tap_listener(void);
+
+/*******************************************************************************************************
+ *
+ * Helpers shared by the taps
+ *
+ *******************************************************************************************************/
+/* Write a text as quoted CSV field, the texts come from the PLC and may contain commas or quotes */
+void
+s7comm_tap_write_csv_text(FILE *fh,
+                          const gchar *text)
+{
+    fputc('"', fh);
+    for (; text != NULL && *text != '\0'; text++) {
+        if (*text == '"') {
+            fputc('"', fh);
+        }
+        fputc(*text, fh);
+    }
+    fputc('"', fh);
+}
+
+/* g_hash_table_foreach() callback, adds the values to a GPtrArray */
+void
+s7comm_tap_collect(gpointer key _U_,
+                   gpointer value,
+                   gpointer user_data)
+{
+    g_ptr_array_add((GPtrArray *)user_data, value);
+}
+
+/* Hash table with addresses as keys, e.g. of the PLCs */
+guint
+s7comm_tap_addr_hash(gconstpointer key)
+{
+    const address *addr = (const address *)key;
+    const guint8 *data = (const guint8 *)addr->data;
+    guint hash = (guint)addr->type;
+    gint i;
+
+    for (i = 0; i < addr->len; i++) {
+        hash = hash * 31 + data[i];
+    }
+    return hash;
+}
+
+gboolean
+s7comm_tap_addr_equal(gconstpointer a,
+                      gconstpointer b)
+{
+    const address *addr1 = (const address *)a;
+    const address *addr2 = (const address *)b;
+
+    return addr1->type == addr2->type && addr1->len == addr2->len &&
+        memcmp(addr1->data, addr2->data, addr1->len) == 0;
+}
+
+typedef struct {
+    gchar *plc;                             /* Address of the PLC as text */
+    gchar *area_name;
+    guint8 area;                            /* Area of S7ANY address */
+    guint16 db;
+    guint32 at_frame;                       /* Frame of the image, 0 if at_time is used */
+    gboolean time_of_day;                   /* at_time is only a time of the day of the first frame */
+    gdouble at_time;                        /* Seconds since epoch, or of the day */
+    gchar *filename;
+    guint32 last_frame;
+    gboolean done;
+} s7comm_dump_t;
+
+/*******************************************************************************************************
+ *
+ * Parse the area of the dump, returns FALSE if unknown
+ *
+ *******************************************************************************************************/
+static gboolean
+s7comm_dump_parse_area(s7comm_dump_t *dump,
+                       const gchar *str)
+{
+    gchar *end;
+    gulong db;
+
+    if (g_ascii_strncasecmp(str, "DB", 2) == 0) {
+        db = strtoul(str + 2, &end, 10);
+        if (end == str + 2 || *end != '\0' || db > G_MAXUINT16) {
+            return FALSE;
+        }
+        dump->area = S7COMM_AREA_DB;
+        dump->db = (guint16)db;
+        return TRUE;
+    }
+    if (str[0] == '\0' || str[1] != '\0') {
+        return FALSE;
+    }
+    switch (g_ascii_toupper(str[0])) {
+        case 'I':
+            dump->area = S7COMM_AREA_INPUTS;
+            break;
+        case 'Q':
+            dump->area = S7COMM_AREA_OUTPUTS;
+            break;
+        case 'M':
+            dump->area = S7COMM_AREA_FLAGS;
+            break;
+        case 'P':
+            dump->area = S7COMM_AREA_P;
+            break;
+        case 'T':
+            dump->area = S7COMM_AREA_TIMER;
+            break;
+        case 'C':
+            dump->area = S7COMM_AREA_COUNTER;
+            break;
+        default:
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/*******************************************************************************************************
+ *
+ * Parse the frame number or the time of the dump, returns FALSE if invalid
+ *
+ *******************************************************************************************************/
+static gboolean
+s7comm_dump_parse_at(s7comm_dump_t *dump,
+                     const gchar *str)
+{
+    struct tm tm;
+    gdouble sec;
+    gchar *end;
+    time_t t;
+
+    memset(&tm, 0, sizeof(tm));
+    if (sscanf(str, "%d-%d-%d %d:%d:%lf", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min, &sec) == 6) {
+        tm.tm_year -= 1900;
+        tm.tm_mon -= 1;
+        tm.tm_sec = (int)sec;
+        tm.tm_isdst = -1;
+        t = mktime(&tm);
+        if (t == (time_t)-1) {
+            return FALSE;
+        }
+        dump->at_time = (gdouble)t + (sec - (int)sec);
+        return TRUE;
+    }
+    if (sscanf(str, "%d:%d:%lf", &tm.tm_hour, &tm.tm_min, &sec) == 3) {
+        dump->time_of_day = TRUE;
+        dump->at_time = tm.tm_hour * 3600.0 + tm.tm_min * 60.0 + sec;
+        return TRUE;
+    }
+    dump->at_frame = (guint32)strtoul(str, &end, 10);
+    return end != str && *end == '\0' && dump->at_frame > 0;
+}
+
+/*******************************************************************************************************
+ *
+ * Write the image and the bitmap of the known bytes as of the given frame
+ *
+ *******************************************************************************************************/
+static void
+s7comm_dump_write(s7comm_dump_t *dump,
+                  guint32 frame)
+{
+    s7comm_shadow_plc_t *plc;
+    guint8 *buf;
+    guint8 *valid;
+    guint32 size;
+    guint32 known;
+    gchar *valid_filename;
+    FILE *fh;
+
+    dump->done = TRUE;
+    plc = s7comm_shadow_find_plc_by_name(dump->plc);
+    size = s7comm_shadow_get_size(plc, dump->area, dump->db, frame);
+    buf = (guint8 *)g_malloc(size + 1);
+    valid = (guint8 *)g_malloc((size + 7) / 8 + 1);
+    known = s7comm_shadow_read(plc, dump->area, dump->db, 0, size, frame, buf, valid);
+
+    fh = ws_fopen(dump->filename, "wb");
+    if (fh == NULL || fwrite(buf, 1, size, fh) != size) {
+        fprintf(stderr, "tshark: Can't write \"%s\": %s\n", dump->filename, g_strerror(errno));
+    }
+    if (fh != NULL) {
+        fclose(fh);
+    }
+    valid_filename = g_strdup_printf("%s.valid", dump->filename);
+    fh = ws_fopen(valid_filename, "wb");
+    if (fh == NULL || fwrite(valid, 1, (size + 7) / 8, fh) != (size + 7) / 8) {
+        fprintf(stderr, "tshark: Can't write \"%s\": %s\n", valid_filename, g_strerror(errno));
+    }
+    if (fh != NULL) {
+        fclose(fh);
+    }
+    printf("S7 memory %s of %s at frame %u: %u bytes, %u known\n",
+        dump->area_name, dump->plc, frame, size, known);
+
+    g_free(valid_filename);
+    g_free(valid);
+    g_free(buf);
+}
+
+static int
+s7comm_dump_packet(void *tapdata,
+                   packet_info *pinfo,
+                   epan_dissect_t *edt _U_,
+                   const void *data _U_)
+{
+    s7comm_dump_t *dump = (s7comm_dump_t *)tapdata;
+    gdouble t;
+    time_t secs;
+    struct tm *tm;
+
+    if (dump->done) {
+        return FALSE;
+    }
+    if (dump->at_frame != 0) {
+        if (pinfo->fd->num >= dump->at_frame) {
+            s7comm_dump_write(dump, dump->at_frame);
+        }
+    } else {
+        if (dump->time_of_day) {
+            /* Now the day is known */
+            secs = pinfo->fd->abs_ts.secs;
+            tm = localtime(&secs);
+            if (tm != NULL) {
+                tm->tm_hour = 0;
+                tm->tm_min = 0;
+                tm->tm_sec = 0;
+                tm->tm_isdst = -1;
+                dump->at_time += (gdouble)mktime(tm);
+            }
+            dump->time_of_day = FALSE;
+        }
+        t = pinfo->fd->abs_ts.secs + pinfo->fd->abs_ts.nsecs / 1000000000.0;
+        if (t > dump->at_time) {
+            s7comm_dump_write(dump, dump->last_frame);
+        }
+    }
+    dump->last_frame = pinfo->fd->num;
+    return FALSE;
+}
+
+static void
+s7comm_dump_draw(void *tapdata)
+{
+    s7comm_dump_t *dump = (s7comm_dump_t *)tapdata;
+
+    /* The capture ended before the frame or time */
+    if (!dump->done) {
+        s7comm_dump_write(dump, dump->last_frame);
+    }
+}
+
+/*******************************************************************************************************
+ *
+ * -z "s7comm,dump,<plc>,<area>,<at>,<file>"
+ *
+ *******************************************************************************************************/
+static void
+s7comm_dump_init(const char *optarg,
+                 void *userdata _U_)
+{
+    s7comm_dump_t *dump;
+    gchar **fields;
+    GString *error_string;
+
+    fields = g_strsplit(optarg, ",", 6);
+    if (g_strv_length(fields) != 6 || fields[2][0] == '\0' || fields[5][0] == '\0') {
+        fprintf(stderr, "tshark: invalid \"-z s7comm,dump,<plc>,<area>,<at>,<file>\" argument\n");
+        exit(1);
+    }
+    dump = g_new0(s7comm_dump_t, 1);
+    dump->plc = g_strdup(fields[2]);
+    dump->area_name = g_ascii_strup(fields[3], -1);
+    dump->filename = g_strdup(fields[5]);
+    if (!s7comm_dump_parse_area(dump, fields[3])) {
+        fprintf(stderr, "tshark: s7comm,dump: unknown area \"%s\", use I, Q, M, P, T, C or DB<number>\n", fields[3]);
+        exit(1);
+    }
+    if (!s7comm_dump_parse_at(dump, fields[4])) {
+        fprintf(stderr, "tshark: s7comm,dump: \"%s\" is no frame number or time\n", fields[4]);
+        exit(1);
+    }
+    g_strfreev(fields);
+
+    /* Every frame is needed to know when the frame or time is passed */
+    error_string = register_tap_listener("frame", dump, NULL, TL_REQUIRES_NOTHING, NULL,
+        s7comm_dump_packet, s7comm_dump_draw);
+    if (error_string) {
+        fprintf(stderr, "tshark: Couldn't register s7comm,dump tap: %s\n", error_string->str);
+        g_string_free(error_string, TRUE);
+        exit(1);
+    }
+}
+
+static int
+s7comm_pbc_export_packet(void *tapdata,
+                         packet_info *pinfo _U_,
+                         epan_dissect_t *edt _U_,
+                         const void *data)
+{
+    const gchar *dir = (const gchar *)tapdata;
+    const s7comm_pbc_eo_t *eo = (const s7comm_pbc_eo_t *)data;
+    gchar *filename;
+    gchar *name;
+    FILE *fh;
+
+    /* IPv6 addresses have colons, which are not allowed in all file systems */
+    name = g_strdup_printf("%s_%s", eo->hostname, eo->filename);
+    g_strdelimit(name, ":/\\", '-');
+    filename = g_build_filename(dir, name, NULL);
+    fh = ws_fopen(filename, "wb");
+    if (fh == NULL || fwrite(eo->payload_data, 1, eo->payload_len, fh) != eo->payload_len) {
+        fprintf(stderr, "tshark: Can't write \"%s\": %s\n", filename, g_strerror(errno));
+    }
+    if (fh != NULL) {
+        fclose(fh);
+    }
+    g_free(filename);
+    g_free(name);
+    return FALSE;
+}
+
+/*******************************************************************************************************
+ *
+ * -z "s7comm,pbc,<dir>"
+ *
+ *******************************************************************************************************/
+static void
+s7comm_pbc_export_init(const char *optarg,
+                       void *userdata _U_)
+{
+    GString *error_string;
+    const gchar *dir;
+
+    dir = optarg + strlen("s7comm,pbc,");
+    if (!g_file_test(dir, G_FILE_TEST_IS_DIR)) {
+        fprintf(stderr, "tshark: s7comm,pbc: \"%s\" is no directory\n", dir);
+        exit(1);
+    }
+    error_string = register_tap_listener("s7comm_pbc_eo", g_strdup(dir), NULL, TL_REQUIRES_NOTHING, NULL,
+        s7comm_pbc_export_packet, NULL);
+    if (error_string) {
+        fprintf(stderr, "tshark: Couldn't register s7comm,pbc tap: %s\n", error_string->str);
+        g_string_free(error_string, TRUE);
+        exit(1);
+    }
+}
+
+/*******************************************************************************************************
+ *
+ * Called by Wireshark when the plugin is loaded, registers the command line taps
+ *
+ *******************************************************************************************************/
+G_MODULE_EXPORT void
+plugin_register_tap_listener(void)
+{
+    register_stat_cmd_arg("s7comm,dump,", s7comm_dump_init, NULL);
+    register_stat_cmd_arg("s7comm,pbc,", s7comm_pbc_export_init, NULL);
+    s7comm_register_alarms_tap();
+    s7comm_register_blocks_tap();
+    s7comm_register_audit_tap();
+    s7comm_register_transfers_tap();
+    s7comm_register_inventory_tap();
+    s7comm_register_diag_tap();
+    s7comm_register_szl_export_tap();
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
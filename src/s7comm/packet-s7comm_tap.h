@@ -0,0 +1,56 @@
+/* packet-s7comm_tap.h
+ *
+ * Author:      Thomas Wiens, 2014 (th.wiens@gmx.de)
+ * Description: Wireshark dissector for S7-Communication
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __PACKET_S7COMM_TAP_H__
+#define __PACKET_S7COMM_TAP_H__
+
+/* Command line taps, registered in plugin_register_tap_listener() */
+void s7comm_register_alarms_tap(void);
+void s7comm_register_blocks_tap(void);
+void s7comm_register_audit_tap(void);
+void s7comm_register_transfers_tap(void);
+void s7comm_register_inventory_tap(void);
+void s7comm_register_diag_tap(void);
+void s7comm_register_szl_export_tap(void);
+
+/* Helpers shared by the taps */
+void s7comm_tap_write_csv_text(FILE *fh, const gchar *text);
+void s7comm_tap_collect(gpointer key, gpointer value, gpointer user_data);
+guint s7comm_tap_addr_hash(gconstpointer key);
+gboolean s7comm_tap_addr_equal(gconstpointer a, gconstpointer b);
+
+#endif
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,355 @@
+/* packet-s7comm_transfers.c
+ *
+ * Author:      Thomas Wiens, 2014 (th.wiens@gmx.de)
+ * Description: Wireshark dissector for S7-Communication
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**************************************************************************
+ * Block transfer statistics for tshark
+ *
+ * -z "s7comm,transfers"
+ *   Follows the block downloads and uploads of every connection and prints
+ *   one line per transfer at the end:
+ *     - duration from the start job to the end job, the number of data
+ *       PDUs and the transferred bytes of the block data
+ *     - average bytes per data PDU and how much of the negotiated PDU size
+ *       is used for block data. The parameter and the data header of an
+ *       ack take 18 bytes of every PDU, only the rest can carry the block
+ *     - throughput in bytes/s and the average time between the job asking
+ *       for the next data and the ack with the data
+ *     - for downloads the lengths of load memory and MC7 code announced in
+ *       the request download, with the difference of the transferred bytes
+ *       to the announced load memory length
+ *   Transfers without an end job in the capture are marked as incomplete.
+ **************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+#include <epan/packet.h>
+#include <epan/conversation.h>
+#include <epan/tap.h>
+#include <epan/to_str.h>
+#include <epan/stat_cmd_args.h>
+
+#include "packet-s7comm.h"
+#include "packet-s7comm_tap.h"
+
+/* Parameter (2 bytes) and data header (4 bytes) of an ack data with the block, besides the 12 bytes header */
+#define S7COMM_TRANSFERS_PDU_OVERHEAD       18
+
+typedef struct {
+    const gchar *conn;                      /* Connection of the transfer, owned by the connection */
+    gboolean download;
+    gchar *block;
+    guint16 pdu_size;                       /* Negotiated PDU size when the transfer started, 0 if unknown */
+    guint32 start_frame;
+    guint32 end_frame;                      /* 0 if no end job was seen */
+    gdouble start_time;
+    gdouble last_time;                      /* Time of the last PDU of the transfer */
+    guint32 loadmem_len;                    /* Announced lengths of a download */
+    guint32 mc7_len;
+    guint32 bytes;
+    guint32 data_pdus;
+    gboolean req_pending;                   /* A job for the next data is waiting for its ack */
+    gdouble req_time;
+    guint32 n_responses;
+    gdouble response_time_sum;
+} s7comm_transfers_transfer_t;
+
+typedef struct {
+    gchar *name;                            /* Both ends of the connection as text */
+    guint16 pdu_size;
+    s7comm_transfers_transfer_t *download;  /* Transfers in progress */
+    s7comm_transfers_transfer_t *upload;
+} s7comm_transfers_conn_t;
+
+typedef struct {
+    GHashTable *conns;                      /* Index of the conversation -> s7comm_transfers_conn_t */
+    GPtrArray *transfers;                   /* All transfers in order of their start */
+} s7comm_transfers_t;
+
+static void
+s7comm_transfers_free_conn(gpointer data)
+{
+    s7comm_transfers_conn_t *conn = (s7comm_transfers_conn_t *)data;
+
+    g_free(conn->name);
+    g_free(conn);
+}
+
+static void
+s7comm_transfers_free_transfer(gpointer data)
+{
+    s7comm_transfers_transfer_t *transfer = (s7comm_transfers_transfer_t *)data;
+
+    g_free(transfer->block);
+    g_free(transfer);
+}
+
+static void
+s7comm_transfers_reset(void *tapdata)
+{
+    s7comm_transfers_t *transfers = (s7comm_transfers_t *)tapdata;
+
+    g_hash_table_remove_all(transfers->conns);
+    g_ptr_array_set_size(transfers->transfers, 0);
+}
+
+/* Connection of the packet, named by both ends with the lower end first */
+static s7comm_transfers_conn_t *
+s7comm_transfers_get_conn(s7comm_transfers_t *transfers,
+                          packet_info *pinfo)
+{
+    s7comm_transfers_conn_t *conn;
+    guint32 conv_index;
+    gchar *src;
+    gchar *dst;
+
+    conv_index = find_or_create_conversation(pinfo)->index;
+    conn = (s7comm_transfers_conn_t *)g_hash_table_lookup(transfers->conns, GUINT_TO_POINTER(conv_index));
+    if (conn == NULL) {
+        conn = g_new0(s7comm_transfers_conn_t, 1);
+        src = g_strdup_printf("%s:%u", ep_address_to_str(&pinfo->src), pinfo->srcport);
+        dst = g_strdup_printf("%s:%u", ep_address_to_str(&pinfo->dst), pinfo->destport);
+        if (strcmp(src, dst) <= 0) {
+            conn->name = g_strdup_printf("%s - %s", src, dst);
+        } else {
+            conn->name = g_strdup_printf("%s - %s", dst, src);
+        }
+        g_free(src);
+        g_free(dst);
+        g_hash_table_insert(transfers->conns, GUINT_TO_POINTER(conv_index), conn);
+    }
+    return conn;
+}
+
+static s7comm_transfers_transfer_t *
+s7comm_transfers_start(s7comm_transfers_t *transfers,
+                       s7comm_transfers_conn_t *conn,
+                       packet_info *pinfo,
+                       const s7comm_transfer_tap_t *pdu,
+                       gboolean download)
+{
+    s7comm_transfers_transfer_t *transfer;
+
+    /* An earlier transfer on the connection without end job stays incomplete */
+    transfer = g_new0(s7comm_transfers_transfer_t, 1);
+    transfer->conn = conn->name;
+    transfer->download = download;
+    transfer->block = g_strdup(pdu->block != NULL ? pdu->block : "?");
+    transfer->pdu_size = conn->pdu_size;
+    transfer->start_frame = pinfo->fd->num;
+    transfer->loadmem_len = pdu->loadmem_len;
+    transfer->mc7_len = pdu->mc7_len;
+    g_ptr_array_add(transfers->transfers, transfer);
+    return transfer;
+}
+
+static int
+s7comm_transfers_packet(void *tapdata,
+                        packet_info *pinfo,
+                        epan_dissect_t *edt _U_,
+                        const void *data)
+{
+    s7comm_transfers_t *transfers = (s7comm_transfers_t *)tapdata;
+    const s7comm_transfer_tap_t *pdu = (const s7comm_transfer_tap_t *)data;
+    s7comm_transfers_conn_t *conn;
+    s7comm_transfers_transfer_t *transfer = NULL;
+    gdouble now;
+
+    now = (gdouble)pinfo->fd->abs_ts.secs + pinfo->fd->abs_ts.nsecs / 1000000000.0;
+    conn = s7comm_transfers_get_conn(transfers, pinfo);
+    switch (pdu->kind) {
+        case S7COMM_TRANSFER_SETUP:
+            conn->pdu_size = pdu->pdu_size;
+            return FALSE;
+        case S7COMM_TRANSFER_DOWNLOAD_START:
+            transfer = conn->download = s7comm_transfers_start(transfers, conn, pinfo, pdu, TRUE);
+            transfer->start_time = now;
+            break;
+        case S7COMM_TRANSFER_UPLOAD_START:
+            transfer = conn->upload = s7comm_transfers_start(transfers, conn, pinfo, pdu, FALSE);
+            transfer->start_time = now;
+            break;
+        case S7COMM_TRANSFER_DOWNLOAD_REQ:
+        case S7COMM_TRANSFER_UPLOAD_REQ:
+            transfer = (pdu->kind == S7COMM_TRANSFER_DOWNLOAD_REQ) ? conn->download : conn->upload;
+            if (transfer != NULL) {
+                transfer->req_pending = TRUE;
+                transfer->req_time = now;
+            }
+            break;
+        case S7COMM_TRANSFER_DOWNLOAD_DATA:
+        case S7COMM_TRANSFER_UPLOAD_DATA:
+            transfer = (pdu->kind == S7COMM_TRANSFER_DOWNLOAD_DATA) ? conn->download : conn->upload;
+            if (transfer != NULL) {
+                transfer->bytes += pdu->data_len;
+                transfer->data_pdus++;
+                if (transfer->req_pending) {
+                    transfer->n_responses++;
+                    transfer->response_time_sum += now - transfer->req_time;
+                    transfer->req_pending = FALSE;
+                }
+            }
+            break;
+        case S7COMM_TRANSFER_DOWNLOAD_END:
+            transfer = conn->download;
+            conn->download = NULL;
+            break;
+        case S7COMM_TRANSFER_UPLOAD_END:
+            transfer = conn->upload;
+            conn->upload = NULL;
+            break;
+    }
+    if (transfer == NULL) {
+        /* Started before the capture */
+        return FALSE;
+    }
+    transfer->last_time = now;
+    if (pdu->kind == S7COMM_TRANSFER_DOWNLOAD_END || pdu->kind == S7COMM_TRANSFER_UPLOAD_END) {
+        transfer->end_frame = pinfo->fd->num;
+    }
+    return TRUE;
+}
+
+static void
+s7comm_transfers_print_transfer(const s7comm_transfers_transfer_t *transfer)
+{
+    gdouble duration;
+    guint32 payload;
+
+    duration = transfer->last_time - transfer->start_time;
+    printf("%-8s  %-10s  %7u  %7u  %10.3f  %7u  %5u  ", transfer->download ? "Download" : "Upload",
+        transfer->block, transfer->start_frame, transfer->end_frame, duration, transfer->bytes, transfer->data_pdus);
+    if (transfer->data_pdus > 0) {
+        printf("%9.1f  ", (gdouble)transfer->bytes / transfer->data_pdus);
+    } else {
+        printf("%9s  ", "-");
+    }
+    if (transfer->data_pdus > 0 && transfer->pdu_size > S7COMM_TRANSFERS_PDU_OVERHEAD) {
+        payload = transfer->pdu_size - S7COMM_TRANSFERS_PDU_OVERHEAD;
+        printf("%5u  %5.1f%%  ", transfer->pdu_size, 100.0 * transfer->bytes / ((gdouble)payload * transfer->data_pdus));
+    } else {
+        printf("%5s  %6s  ", "-", "-");
+    }
+    if (duration > 0.0) {
+        printf("%11.0f  ", transfer->bytes / duration);
+    } else {
+        printf("%11s  ", "-");
+    }
+    if (transfer->n_responses > 0) {
+        printf("%9.3f", 1000.0 * transfer->response_time_sum / transfer->n_responses);
+    } else {
+        printf("%9s", "-");
+    }
+    if (transfer->download && transfer->loadmem_len > 0) {
+        printf("  announced load %u, MC7 %u, diff %+d", transfer->loadmem_len, transfer->mc7_len,
+            (gint)transfer->bytes - (gint)transfer->loadmem_len);
+    }
+    if (transfer->end_frame == 0) {
+        printf("  (incomplete)");
+    }
+    printf("\n");
+}
+
+static void
+s7comm_transfers_draw(void *tapdata)
+{
+    s7comm_transfers_t *transfers = (s7comm_transfers_t *)tapdata;
+    const s7comm_transfers_transfer_t *transfer;
+    GHashTable *printed;
+    guint i;
+    guint j;
+
+    printed = g_hash_table_new(g_direct_hash, g_direct_equal);
+    printf("\n===================================================================\n");
+    printf("S7 block transfers\n");
+    for (i = 0; i < transfers->transfers->len; i++) {
+        transfer = (const s7comm_transfers_transfer_t *)g_ptr_array_index(transfers->transfers, i);
+        if (g_hash_table_lookup(printed, transfer->conn) != NULL) {
+            continue;
+        }
+        /* All transfers of a connection together, in order of their start */
+        g_hash_table_insert(printed, (gpointer)transfer->conn, (gpointer)transfer->conn);
+        printf("\nConnection %s\n", transfer->conn);
+        printf("%-8s  %-10s  %7s  %7s  %10s  %7s  %5s  %9s  %5s  %6s  %11s  %9s\n", "Type", "Block", "Start", "End",
+            "Duration s", "Bytes", "PDUs", "Bytes/PDU", "PDU", "Fill", "Bytes/s", "Resp. ms");
+        for (j = i; j < transfers->transfers->len; j++) {
+            const s7comm_transfers_transfer_t *other = (const s7comm_transfers_transfer_t *)g_ptr_array_index(transfers->transfers, j);
+
+            if (other->conn == transfer->conn) {
+                s7comm_transfers_print_transfer(other);
+            }
+        }
+    }
+    printf("===================================================================\n");
+    g_hash_table_destroy(printed);
+}
+
+/*******************************************************************************************************
+ *
+ * -z "s7comm,transfers"
+ *
+ *******************************************************************************************************/
+static void
+s7comm_transfers_init(const char *optarg _U_,
+                      void *userdata _U_)
+{
+    s7comm_transfers_t *transfers;
+    GString *error_string;
+
+    transfers = g_new0(s7comm_transfers_t, 1);
+    transfers->conns = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, s7comm_transfers_free_conn);
+    transfers->transfers = g_ptr_array_new_with_free_func(s7comm_transfers_free_transfer);
+
+    error_string = register_tap_listener("s7comm_transfer", transfers, NULL, TL_REQUIRES_NOTHING,
+        s7comm_transfers_reset, s7comm_transfers_packet, s7comm_transfers_draw);
+    if (error_string) {
+        fprintf(stderr, "tshark: Couldn't register s7comm,transfers tap: %s\n", error_string->str);
+        g_string_free(error_string, TRUE);
+        exit(1);
+    }
+}
+
+void
+s7comm_register_transfers_tap(void)
+{
+    register_stat_cmd_arg("s7comm,transfers", s7comm_transfers_init, NULL);
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
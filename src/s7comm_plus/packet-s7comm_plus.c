@@ -27,10 +27,17 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <glib.h>
+#include <gmodule.h>
 #include <epan/packet.h>
+#include <epan/prefs.h>
+#include <epan/expert.h>
 #include <epan/reassemble.h>
 #include <epan/conversation.h>
+#include <epan/dissectors/packet-tcp.h>
+#include <epan/tap.h>
+#include <epan/stat_cmd_args.h>
 #include <string.h>
 #include <time.h>
 
@@ -48,6 +55,8 @@
 //#define DONT_ADD_AS_HEURISTIC_DISSECTOR
 
 #include "packet-s7comm_plus.h"
+/* Data of the tap "s7commp_audit", shared with the S7comm plugin */
+#include "plugins/s7comm/packet-s7comm_audit.h"
 
 #define PROTO_TAG_S7COMM_PLUS                   "S7COMM-PLUS"
 
@@ -63,6 +72,17 @@
 /* Wireshark ID of the S7COMM_PLUS protocol */
 static int proto_s7commp = -1;
 
+/* Tap of the state changing operations */
+static int s7commp_audit_tap = -1;
+/* Tap of the counters of the reassembly */
+static int s7commp_reassembly_tap = -1;
+
+static expert_field ei_s7commp_reassembly_evicted = EI_INIT;
+
+/* Limits of the pending reassemblies, from the preferences */
+static guint s7commp_reassembly_max_kbytes = 65536;
+static guint s7commp_reassembly_max_age = 300;
+
 /* Forward declaration */
 static gboolean dissect_s7commp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void *data _U_);
 
@@ -855,33 +875,346 @@ static const fragment_items s7commp_frag_items = {
     "S7COMM-PLUS fragments"
 };
 
+/* Counters of the reassembly, for the tap "s7commp_reassembly" */
+typedef struct {
+    guint32 pending;                        /* Series waiting for their last fragment */
+    guint32 pending_bytes;
+    guint32 completed;
+    guint32 dropped;                        /* Series which didn't line up */
+    guint32 evicted;                        /* Series dropped for the limits of the preferences */
+} s7commp_reassembly_stats_t;
+
+/* Flags of the frame state */
+#define S7COMMP_FRAG_FIRST              0x01
+#define S7COMMP_FRAG_INNER              0x02
+#define S7COMMP_FRAG_LAST               0x04
+#define S7COMMP_FRAG_OUT_OF_SYNC        0x08    /* Fragment of a series without its start in the capture */
+#define S7COMMP_FRAG_RETRANSMISSION     0x10    /* Fragment sent again by TCP, not added again */
+#define S7COMMP_FRAG_NONE               0x20    /* Not fragmented, in a frame with states of other PDUs */
+
+/* State of a PDU in a frame from the first pass. Only frames with a fragment or dropped series have
+ * them, then every PDU of the frame up to the last one with a fragment has one. A PDU without is not
+ * fragmented.
+ */
 typedef struct {
-    gboolean first_fragment;
-    gboolean inner_fragment;
-    gboolean last_fragment;
     guint32 start_frame;
+    guint32 frag_number;                    /* Position of the fragment in its series, in the order of arrival */
+    guint16 evicted;                        /* Pending series dropped in this frame for the limits */
+    guint8 flags;                           /* S7COMMP_FRAG_* */
+    const s7commp_reassembly_stats_t *stats;    /* Counters after the PDU for the tap on every pass, or NULL */
 } frame_state_t;
 
+/* Key of the data of a frame: S7COMM-PLUS PDUs dissected in the frame so far, in packet scope */
+#define S7COMMP_PROTO_DATA_PDU_COUNT    0
+
 #define CONV_STATE_NEW         -1
 #define CONV_STATE_NOFRAG      0
 #define CONV_STATE_FIRST       1
 #define CONV_STATE_INNER       2
 #define CONV_STATE_LAST        3
 typedef struct {
-    int state;
+    GList *pending_link;                    /* Entry in s7commp_pending while the series is incomplete */
+    time_t pending_secs;                    /* Capture time of the last fragment */
+    guint32 pending_bytes;                  /* Bytes of the fragments added to the series */
     guint32 start_frame;
+    guint32 next_fragment;                  /* Position of the next fragment in the series */
+    gint8 state;
+    guint8 pdutype;                         /* PDU type of the first fragment */
 } conv_state_t;
 
+/* Reassembly state of a TCP connection, one per direction */
+typedef struct {
+    conv_state_t dir[2];
+} conv_states_t;
+
 /*
  * reassembly of S7COMMP
  */
 static reassembly_table s7commp_reassembly_table;
 
+/* The states of the incomplete series, least recently used first */
+static GQueue *s7commp_pending = NULL;
+/* Frame number, index of the PDU in the frame -> frame_state_t */
+static wmem_tree_t *s7commp_frame_states = NULL;
+/* For the stream index and sequence analysis of TCP */
+static int s7commp_proto_tcp = -1;
+/* TCP stream index -> conv_states_t */
+static wmem_tree_t *s7commp_conv_states = NULL;
+/* The conversation states are taken from blocks, instead of one allocation per connection */
+#define S7COMMP_CONV_STATES_BLOCK       64
+static conv_states_t *s7commp_conv_states_block = NULL;
+static guint s7commp_conv_states_used = 0;
+static s7commp_reassembly_stats_t s7commp_reassembly_stats;
+
+/* A series is identified by the frame of its first fragment, which is unique in the capture.
+ * Without addresses in the key, a series can be dropped in the frame of any connection.
+ */
+static gpointer
+s7commp_fragment_key(const packet_info *pinfo _U_,
+                     const guint32 id,
+                     const void *data _U_)
+{
+    return GUINT_TO_POINTER(id);
+}
+
+static void
+s7commp_fragment_free_key(gpointer ptr _U_)
+{
+}
+
+static const reassembly_table_functions s7commp_reassembly_table_functions = {
+    g_direct_hash,
+    g_direct_equal,
+    s7commp_fragment_key,
+    s7commp_fragment_key,
+    s7commp_fragment_free_key,
+    s7commp_fragment_free_key
+};
+
 static void
 s7commp_defragment_init(void)
 {
     reassembly_table_init(&s7commp_reassembly_table,
-                          &addresses_reassembly_table_functions);
+                          &s7commp_reassembly_table_functions);
+    if (s7commp_pending != NULL) {
+        g_queue_free(s7commp_pending);
+    }
+    s7commp_pending = g_queue_new();
+    memset(&s7commp_reassembly_stats, 0, sizeof(s7commp_reassembly_stats));
+    s7commp_frame_states = wmem_tree_new(wmem_file_scope());
+    s7commp_conv_states = wmem_tree_new(wmem_file_scope());
+    s7commp_conv_states_block = NULL;
+    s7commp_conv_states_used = 0;
+}
+
+/*******************************************************************************************************
+ *
+ * Account a fragment added to the series of state, the series is used most recently
+ *
+ *******************************************************************************************************/
+static void
+s7commp_pending_add(packet_info *pinfo,
+                    conv_state_t *state,
+                    guint32 len)
+{
+    if (state->pending_link == NULL) {
+        g_queue_push_tail(s7commp_pending, state);
+        state->pending_link = g_queue_peek_tail_link(s7commp_pending);
+        state->pending_bytes = 0;
+        s7commp_reassembly_stats.pending++;
+    } else {
+        g_queue_unlink(s7commp_pending, state->pending_link);
+        g_queue_push_tail_link(s7commp_pending, state->pending_link);
+    }
+    state->pending_bytes += len;
+    state->pending_secs = pinfo->fd->abs_ts.secs;
+    s7commp_reassembly_stats.pending_bytes += len;
+}
+
+/*******************************************************************************************************
+ *
+ * The series of state is complete or dropped. When dropped, its fragments are removed from the
+ * reassembly table, and the state waits for the begin of a new series.
+ *
+ *******************************************************************************************************/
+static void
+s7commp_pending_remove(packet_info *pinfo,
+                       conv_state_t *state,
+                       gboolean drop)
+{
+    tvbuff_t *data;
+
+    if (state->pending_link != NULL) {
+        g_queue_delete_link(s7commp_pending, state->pending_link);
+        state->pending_link = NULL;
+        s7commp_reassembly_stats.pending--;
+        s7commp_reassembly_stats.pending_bytes -= state->pending_bytes;
+        state->pending_bytes = 0;
+    }
+    if (drop) {
+        data = fragment_delete(&s7commp_reassembly_table, pinfo, state->start_frame, NULL);
+        if (data != NULL) {
+            tvb_free(data);
+        }
+        state->state = CONV_STATE_NEW;
+        state->start_frame = 0;
+    }
+}
+
+/*******************************************************************************************************
+ *
+ * Drop the least recently used series while the pending series are over the limits. The series of
+ * current is skipped, its fragment is added after this. Returns the number of dropped series.
+ *
+ *******************************************************************************************************/
+static guint32
+s7commp_pending_evict(packet_info *pinfo,
+                      conv_state_t *current)
+{
+    GList *link;
+    conv_state_t *state;
+    guint32 evicted = 0;
+    gboolean too_large;
+    gboolean too_old;
+
+    link = g_queue_peek_head_link(s7commp_pending);
+    while (link != NULL) {
+        state = (conv_state_t *)link->data;
+        link = link->next;
+        if (state == current) {
+            continue;
+        }
+        too_large = s7commp_reassembly_max_kbytes > 0
+            && s7commp_reassembly_stats.pending_bytes > (guint64)s7commp_reassembly_max_kbytes * 1024;
+        too_old = s7commp_reassembly_max_age > 0
+            && pinfo->fd->abs_ts.secs - state->pending_secs > (time_t)s7commp_reassembly_max_age;
+        if (!too_large && !too_old) {
+            break;
+        }
+        s7commp_pending_remove(pinfo, state, TRUE);
+        evicted++;
+    }
+    s7commp_reassembly_stats.evicted += evicted;
+    return evicted;
+}
+
+/*******************************************************************************************************
+ *
+ * Count a PDU in the frame, a TCP segment may hold several. Returns the index of the PDU in the frame.
+ *
+ *******************************************************************************************************/
+static guint32
+s7commp_count_pdu(packet_info *pinfo)
+{
+    guint32 count;
+
+    count = GPOINTER_TO_UINT(p_get_proto_data(pinfo->pool, pinfo, proto_s7commp, S7COMMP_PROTO_DATA_PDU_COUNT));
+    p_remove_proto_data(pinfo->pool, pinfo, proto_s7commp, S7COMMP_PROTO_DATA_PDU_COUNT);
+    p_add_proto_data(pinfo->pool, pinfo, proto_s7commp, S7COMMP_PROTO_DATA_PDU_COUNT, GUINT_TO_POINTER(count + 1));
+    return count;
+}
+
+/*******************************************************************************************************
+ *
+ * The state of the PDU with pdu_index in the frame, NULL if there is none
+ *
+ *******************************************************************************************************/
+static frame_state_t *
+s7commp_get_frame_state(packet_info *pinfo,
+                        guint32 pdu_index)
+{
+    wmem_tree_key_t key[2];
+    guint32 state_key[2];
+
+    state_key[0] = pinfo->fd->num;
+    state_key[1] = pdu_index;
+    key[0].length = 2;
+    key[0].key = state_key;
+    key[1].length = 0;
+    key[1].key = NULL;
+    return (frame_state_t *)wmem_tree_lookup32_array(s7commp_frame_states, key);
+}
+
+/*******************************************************************************************************
+ *
+ * Keep the state of the PDU with pdu_index in the frame. The PDUs before it without a state get one
+ * which says that they are not fragmented.
+ *
+ *******************************************************************************************************/
+static void
+s7commp_set_frame_state(packet_info *pinfo,
+                        guint32 pdu_index,
+                        frame_state_t *packet_state)
+{
+    wmem_tree_key_t key[2];
+    guint32 state_key[2];
+    frame_state_t *none_state;
+    guint32 i;
+
+    state_key[0] = pinfo->fd->num;
+    key[0].length = 2;
+    key[0].key = state_key;
+    key[1].length = 0;
+    key[1].key = NULL;
+    for (i = pdu_index; i > 0 && s7commp_get_frame_state(pinfo, i - 1) == NULL; i--) {
+        none_state = wmem_new0(wmem_file_scope(), frame_state_t);
+        none_state->flags = S7COMMP_FRAG_NONE;
+        state_key[1] = i - 1;
+        wmem_tree_insert32_array(s7commp_frame_states, key, none_state);
+    }
+    state_key[1] = pdu_index;
+    wmem_tree_insert32_array(s7commp_frame_states, key, packet_state);
+}
+
+/*******************************************************************************************************
+ *
+ * Get the data of TCP of the connection the packet belongs to, NULL if TCP has none
+ *
+ *******************************************************************************************************/
+static struct tcp_analysis *
+s7commp_get_tcp_analysis(packet_info *pinfo)
+{
+    conversation_t *conversation;
+
+    if (s7commp_proto_tcp == -1) {
+        return NULL;
+    }
+    conversation = find_conversation(pinfo->fd->num, &pinfo->src, &pinfo->dst, pinfo->ptype,
+                                     pinfo->srcport, pinfo->destport, 0);
+    if (conversation == NULL) {
+        return NULL;
+    }
+    /* Not with get_tcp_conversation_data(), it clears the analysis of the current segment */
+    return (struct tcp_analysis *)conversation_get_proto_data(conversation, s7commp_proto_tcp);
+}
+
+/*******************************************************************************************************
+ *
+ * Get the reassembly state of the direction of the TCP connection the packet belongs to, by the
+ * stream index of TCP in tcpd. Every client connection to a PLC has its own state, also when they
+ * use the same PLC port. Without data of TCP the state is kept in the conversation.
+ *
+ *******************************************************************************************************/
+static conv_state_t *
+s7commp_get_conv_state(packet_info *pinfo,
+                       struct tcp_analysis *tcpd)
+{
+    conversation_t *conversation = NULL;
+    conv_states_t *conv_states;
+    int dir;
+
+    if (tcpd != NULL) {
+        conv_states = (conv_states_t *)wmem_tree_lookup32(s7commp_conv_states, tcpd->stream);
+    } else {
+        conversation = find_or_create_conversation(pinfo);
+        conv_states = (conv_states_t *)conversation_get_proto_data(conversation, proto_s7commp);
+    }
+    if (conv_states == NULL) {
+        if (s7commp_conv_states_block == NULL || s7commp_conv_states_used == S7COMMP_CONV_STATES_BLOCK) {
+            s7commp_conv_states_block = wmem_alloc_array(wmem_file_scope(), conv_states_t, S7COMMP_CONV_STATES_BLOCK);
+            s7commp_conv_states_used = 0;
+        }
+        conv_states = &s7commp_conv_states_block[s7commp_conv_states_used++];
+        conv_states->dir[0].state = CONV_STATE_NEW;
+        conv_states->dir[0].start_frame = 0;
+        conv_states->dir[0].pdutype = 0;
+        conv_states->dir[0].next_fragment = 0;
+        conv_states->dir[0].pending_link = NULL;
+        conv_states->dir[0].pending_bytes = 0;
+        conv_states->dir[0].pending_secs = 0;
+        conv_states->dir[1] = conv_states->dir[0];
+        if (tcpd != NULL) {
+            wmem_tree_insert32(s7commp_conv_states, tcpd->stream, conv_states);
+        } else {
+            conversation_add_proto_data(conversation, proto_s7commp, conv_states);
+        }
+    }
+    /* The same direction of a connection gives always the same index */
+    dir = cmp_address(&pinfo->src, &pinfo->dst);
+    if (dir == 0) {
+        dir = (pinfo->srcport > pinfo->destport) ? 1 : -1;
+    }
+    return &conv_states->dir[dir > 0 ? 1 : 0];
 }
 
 
@@ -896,6 +1229,7 @@ proto_reg_handoff_s7commp(void)
         #else
             heur_dissector_add("cotp", dissect_s7commp, proto_s7commp);
         #endif
+        s7commp_proto_tcp = proto_get_id_by_filter_name("tcp");
         initialized = TRUE;
     }
 }
@@ -903,6 +1237,9 @@ proto_reg_handoff_s7commp(void)
 void
 proto_register_s7commp (void)
 {
+    module_t *s7commp_module;
+    expert_module_t *expert_s7commp;
+
     static hf_register_info hf[] = {
         /*** Header fields ***/
         { &hf_s7commp_header,
@@ -1312,6 +1649,12 @@ proto_register_s7commp (void)
         &ett_s7commp_fragment
     };
 
+    static ei_register_info ei[] = {
+        { &ei_s7commp_reassembly_evicted,
+          { "s7comm-plus.reassembly.evicted", PI_REASSEMBLE, PI_WARN,
+            "Incomplete reassemblies dropped for the limits of the preferences", EXPFILL }},
+    };
+
     proto_s7commp = proto_register_protocol (
         "S7 Communication Plus",            /* name */
         "S7COMM-PLUS",                      /* short name */
@@ -1321,8 +1664,26 @@ proto_register_s7commp (void)
     proto_register_field_array(proto_s7commp, hf, array_length (hf));
 
     proto_register_subtree_array(ett, array_length (ett));
+
+    expert_s7commp = expert_register_protocol(proto_s7commp);
+    expert_register_field_array(expert_s7commp, ei, array_length(ei));
+
+    s7commp_module = prefs_register_protocol(proto_s7commp, NULL);
+    prefs_register_uint_preference(s7commp_module, "reassembly_max_kbytes",
+        "Maximum size of incomplete reassemblies (kB)",
+        "Incomplete fragment series of all connections are kept up to this size, "
+        "the least recently used are dropped first. 0 for no limit",
+        10, &s7commp_reassembly_max_kbytes);
+    prefs_register_uint_preference(s7commp_module, "reassembly_max_age",
+        "Maximum age of incomplete reassemblies (s)",
+        "Incomplete fragment series are dropped when they got no fragment for this time. 0 for no limit",
+        10, &s7commp_reassembly_max_age);
+
     /* Register the init routine. */
     register_init_routine(s7commp_defragment_init);
+
+    s7commp_audit_tap = register_tap("s7commp_audit");
+    s7commp_reassembly_tap = register_tap("s7commp_reassembly");
 }
 /*******************************************************************************************************
  *
@@ -2387,7 +2748,7 @@ s7commp_decode_object(tvbuff_t *tvb,
                 data_len = tvb_get_ntohs(tvb, offset);
                 proto_tree_add_text(data_item_tree, tvb, offset, 2, "Block length: %d", data_len);
                 offset += 2;
-                proto_tree_add_bytes(data_item_tree, hf_s7commp_data_data, tvb, offset, data_len, tvb_get_ptr(tvb, offset, data_len));
+                proto_tree_add_item(data_item_tree, hf_s7commp_data_data, tvb, offset, data_len, FALSE);
                 offset += data_len;
                 proto_tree_add_text(data_item_tree, tvb, offset, 2, "Unknown 2 trailing bytes: 0x%04x", tvb_get_ntohs(tvb, offset));
                 offset += 2;
@@ -3575,7 +3936,7 @@ s7commp_decode_objectqualifier(tvbuff_t *tvb,
         if (id == 0x4e8) {
             /* alles dazwischen mit Dummy-Bytes auffllen */
             if ((offset+2 - offset_save) > 0) {
-                proto_tree_add_bytes(tree, hf_s7commp_data_data, tvb, offset_save, offset - offset_save, tvb_get_ptr(tvb, offset_save, offset - offset_save));
+                proto_tree_add_item(tree, hf_s7commp_data_data, tvb, offset_save, offset - offset_save, FALSE);
             }
             dlength = dlength - (offset - offset_save);
             offset_save = offset;
@@ -3636,7 +3997,7 @@ s7commp_decode_integrity(tvbuff_t *tvb,
      * To prevent malformed packet errors, check this.
      */
     if (integrity_len == 32) {
-        proto_tree_add_bytes(integrity_tree, hf_s7commp_integrity_digest, tvb, offset, integrity_len, tvb_get_ptr(tvb, offset, integrity_len));
+        proto_tree_add_item(integrity_tree, hf_s7commp_integrity_digest, tvb, offset, integrity_len, FALSE);
         offset += integrity_len;
     } else {
         proto_tree_add_text(integrity_tree, tvb, offset-1, 1, "Error in dissector: Integrity Digest length should be 32!");
@@ -3854,11 +4215,162 @@ s7commp_decode_data(tvbuff_t *tvb,
     }
     /* Show remaining undecoded data as raw bytes */
     if (dlength > 0) {
-        proto_tree_add_bytes(tree, hf_s7commp_data_data, tvb, offset, dlength, tvb_get_ptr(tvb, offset, dlength));
+        proto_tree_add_item(tree, hf_s7commp_data_data, tvb, offset, dlength, FALSE);
         offset += dlength;
     }
     return offset;
 }
+/*******************************************************************************************************
+ *
+ * Queue the state changing requests for the audit log. This is done without a tree, as the
+ * data part is decoded only with a tree. Offset is the begin of the data part.
+ *
+ *******************************************************************************************************/
+static void
+s7commp_queue_audit(tvbuff_t *tvb,
+                    packet_info *pinfo,
+                    guint32 offset)
+{
+    s7comm_audit_tap_t *audit;
+    guint16 functioncode;
+    guint32 object_id;
+    guint32 item_count;
+    guint8 octet_count;
+    const gchar *object;
+
+    /* Opcode, reserved, function code, reserved, sequence number, session id, unknown, object id */
+    if (tvb_reported_length_remaining(tvb, offset) < 18 || tvb_get_guint8(tvb, offset) != S7COMMP_OPCODE_REQ) {
+        return;
+    }
+    functioncode = tvb_get_ntohs(tvb, offset + 3);
+    object_id = tvb_get_ntohl(tvb, offset + 14);
+    switch (functioncode) {
+        case S7COMMP_FUNCTIONCODE_SETMULTIVAR:
+            /* With object id 0 a list of addresses is following */
+            if (object_id == 0 && tvb_reported_length_remaining(tvb, offset + 18) >= 5) {
+                item_count = tvb_get_varuint32(tvb, &octet_count, offset + 18);
+                object = wmem_strdup_printf(wmem_packet_scope(), "%u items", item_count);
+            } else {
+                object = wmem_strdup_printf(wmem_packet_scope(), "ObjId=0x%08x", object_id);
+            }
+            break;
+        case S7COMMP_FUNCTIONCODE_SETVARIABLE:
+        case S7COMMP_FUNCTIONCODE_DELETEOBJECT:
+            object = wmem_strdup_printf(wmem_packet_scope(), "ObjId=0x%08x", object_id);
+            break;
+        default:
+            return;
+    }
+    audit = wmem_new(wmem_packet_scope(), s7comm_audit_tap_t);
+    audit->operation = val_to_str_const(functioncode, data_functioncode_names, "?");
+    audit->object = object;
+    audit->details = wmem_strdup_printf(wmem_packet_scope(), "SessionId=0x%08x Seq=%u",
+        tvb_get_ntohl(tvb, offset + 9), tvb_get_ntohs(tvb, offset + 7));
+    tap_queue_packet(s7commp_audit_tap, pinfo, audit);
+}
+/*******************************************************************************************************
+ *
+ * Check if the data part at offset can be the begin of a message, for the first fragment of a series
+ * or an unfragmented PDU. When a capture starts inside a series, the next fragments must not be taken
+ * as begin. Requests and responses have the reserved fields set to 0 and a function code 0x04xx or
+ * 0x05xx, also when the function is not known yet.
+ *
+ *******************************************************************************************************/
+static gboolean
+s7commp_is_data_start(tvbuff_t *tvb,
+                      guint32 offset)
+{
+    guint8 opcode;
+    guint16 functioncode;
+
+    if (!tvb_bytes_exist(tvb, offset, 7)) {
+        return FALSE;
+    }
+    opcode = tvb_get_guint8(tvb, offset);
+    switch (opcode) {
+        case S7COMMP_OPCODE_NOTIFICATION:
+            return TRUE;
+        case S7COMMP_OPCODE_REQ:
+        case S7COMMP_OPCODE_RES:
+        case S7COMMP_OPCODE_RES2:
+            functioncode = tvb_get_ntohs(tvb, offset + 3);
+            return tvb_get_ntohs(tvb, offset + 1) == 0 && tvb_get_ntohs(tvb, offset + 5) == 0
+                && functioncode >= 0x0400 && functioncode <= 0x05ff;
+        default:
+            return FALSE;
+    }
+}
+
+/*******************************************************************************************************
+ *
+ * Compare len bytes of tvb at offset with the start of other, in pieces, as the data of other
+ * may not be contiguous
+ *
+ *******************************************************************************************************/
+static gboolean
+s7commp_tvb_equal(tvbuff_t *tvb,
+                  guint32 offset,
+                  tvbuff_t *other,
+                  guint32 len)
+{
+    guint8 buf[256];
+    guint32 pos;
+    guint32 n;
+
+    if (!tvb_bytes_exist(other, 0, len)) {
+        return FALSE;
+    }
+    for (pos = 0; pos < len; pos += n) {
+        n = MIN(len - pos, (guint32)sizeof(buf));
+        tvb_memcpy(other, buf, pos, n);
+        if (tvb_memeql(tvb, offset + pos, buf, n) != 0) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/*******************************************************************************************************
+ *
+ * Check if the fragment at offset was sent again. The protocol has no sequence number, so this needs
+ * the sequence analysis of TCP in tcpd: the segment must be marked as retransmission by TCP, and the
+ * data must be the same as of a fragment already added to the series.
+ *
+ *******************************************************************************************************/
+static gboolean
+s7commp_is_retransmission(tvbuff_t *tvb,
+                          packet_info *pinfo,
+                          struct tcp_analysis *tcpd,
+                          conv_state_t *state,
+                          guint32 offset)
+{
+    fragment_head *fd_head;
+    fragment_head *fd;
+    guint32 len;
+
+    if (state->state == CONV_STATE_NEW) {
+        return FALSE;
+    }
+    if (tcpd == NULL || tcpd->ta == NULL
+            || (tcpd->ta->flags & (TCP_A_RETRANSMISSION | TCP_A_FAST_RETRANSMISSION)) == 0) {
+        return FALSE;
+    }
+    fd_head = fragment_get(&s7commp_reassembly_table, pinfo, state->start_frame, NULL);
+    if (fd_head == NULL) {
+        return FALSE;
+    }
+    len = tvb_reported_length_remaining(tvb, offset);
+    if (!tvb_bytes_exist(tvb, offset, len)) {
+        return FALSE;
+    }
+    for (fd = fd_head->next; fd != NULL; fd = fd->next) {
+        if (fd->len == len && fd->tvb_data != NULL && s7commp_tvb_equal(tvb, offset, fd->tvb_data, len)) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
 /*******************************************************************************************************
  *******************************************************************************************************
  *
@@ -3891,12 +4403,21 @@ dissect_s7commp(tvbuff_t *tvb,
     gboolean save_fragmented;
     guint32 frag_id;
     frame_state_t *packet_state;
-    conversation_t *conversation;
+    guint32 pdu_index;
     conv_state_t *conversation_state = NULL;
+    struct tcp_analysis *tcpd;
     gboolean no_fragment = FALSE;
     gboolean first_fragment = FALSE;
     gboolean inner_fragment = FALSE;
     gboolean last_fragment = FALSE;
+    gboolean out_of_sync = FALSE;
+    gboolean retransmission = FALSE;
+    gboolean reassembled = FALSE;
+    gboolean dropped = FALSE;
+    guint32 evicted = 0;
+    guint32 start_frame = 0;
+    guint32 frag_number = 0;
+    guint32 frag_len;
     tvbuff_t* next_tvb = NULL;
 
     guint packetlength;
@@ -3915,6 +4436,7 @@ dissect_s7commp(tvbuff_t *tvb,
 
     col_set_str(pinfo->cinfo, COL_PROTOCOL, PROTO_TAG_S7COMM_PLUS);
     col_clear(pinfo->cinfo, COL_INFO);
+    pdu_index = s7commp_count_pdu(pinfo);
 
     pdutype = tvb_get_guint8(tvb, 1);                       /* Get the type byte */
     hlength = 4;                                            /* Header 4 Bytes */
@@ -3967,6 +4489,12 @@ dissect_s7commp(tvbuff_t *tvb,
 
         /* Paket hat einen Trailer, wenn nach der angegebenen Datenlnge noch 4 Bytes brig bleiben */
         has_trailer = ((signed) packetlength) > (dlength + 4);
+        /* The trailer repeats the protocol id and PDU type, if not the bytes after the data are no trailer */
+        if (has_trailer && (!tvb_bytes_exist(tvb, dlength + 4, 2) || tvb_get_guint8(tvb, dlength + 4) != S7COMM_PLUS_PROT_ID
+                || tvb_get_guint8(tvb, dlength + 5) != pdutype)) {
+            has_trailer = FALSE;
+            out_of_sync = TRUE;
+        }
 
         /************************************************** START REASSEMBLING *************************************************************************/
         /*
@@ -3979,11 +4507,25 @@ dissect_s7commp(tvbuff_t *tvb,
          * state == 1:  Paket hat keinen Trailer, weiterhin Fragment    push data                             state = 1
          * state == 1:  Paket hat einen trailer, Ende Fragmente         push data, pop, dissect_data          state = 0
          *
-         * Die einzige Zugehrigkeit die es gibt, ist die TCP Portnummer. Es mssen dabei BEIDE bereinstimmen.
+         * Die einzige Zugehrigkeit die es gibt, ist die TCP Verbindung. Der Zustand wird pro Verbindung und Richtung gehalten.
          *
          * Dabei muss zustzlich beachtet werden, dass womglich ein capture inmitten einer solchen Serie gestartet wurde.
          * Das kann aber nicht zuverlssig abgefangen werden, wenn zufllig in den ersten Bytes des Datenteils gltige Daten stehen.
          *
+         * Resynchronization: a first fragment or an unfragmented PDU is only taken as such, when its data part
+         * starts like a message (s7commp_is_data_start). Otherwise it is a fragment of a series whose start is
+         * not in the capture, it is shown as raw data only. A series is dropped when a fragment has another
+         * PDU type than the first one, or when the bytes after the data are no valid trailer.
+         *
+         * Retransmissions: TCP passes retransmitted segments on, there is no sequence number in the protocol.
+         * A fragment is only taken as retransmission when TCP marks its segment as retransmission and it has
+         * the same data as a fragment already added to the series (s7commp_is_retransmission), it is not added
+         * again. Fragments with the same data which TCP doesn't mark are different fragments.
+         * Not handled: without the sequence analysis of TCP (tcp.analyze_sequence_numbers) a retransmitted
+         * fragment is added again and the reassembly gives wrong data. A retransmission after the last
+         * fragment is shown as fragment without the start of its series. The position of a fragment is
+         * counted in the order of arrival, segments out of order are added in that order.
+         *
          */
 
         /* Zustandsdiagramm:
@@ -4006,38 +4548,35 @@ dissect_s7commp(tvbuff_t *tvb,
             #ifdef DEBUG_REASSEMBLING
             printf("Reassembling pass 1: Frame=%3d HasTrailer=%d", pinfo->fd->num, has_trailer);
             #endif
-            /* evtl. find_or_create_conversation verwenden?
-             * conversation = find_or_create_conversation(pinfo);
-             */
-
-            conversation = find_conversation(pinfo->fd->num, &pinfo->dst, &pinfo->src,
-                                             pinfo->ptype, pinfo->destport,
-                                             0, NO_PORT_B);
-            if (conversation == NULL) {
-                conversation = conversation_new(pinfo->fd->num, &pinfo->dst, &pinfo->src,
-                                                pinfo->ptype, pinfo->destport,
-                                                0, NO_PORT2);
-                #ifdef DEBUG_REASSEMBLING
-                printf(" NewConv" );
-                #endif
-            }
-            conversation_state = (conv_state_t *)conversation_get_proto_data(conversation, proto_s7commp);
-            if (conversation_state == NULL) {
-                conversation_state = wmem_new(wmem_file_scope(), conv_state_t);
-                conversation_state->state = CONV_STATE_NEW;
-                conversation_state->start_frame = 0;
-                conversation_add_proto_data(conversation, proto_s7commp, conversation_state);
-                #ifdef DEBUG_REASSEMBLING
-                printf(" NewConvState" );
-                #endif
-            }
+            tcpd = s7commp_get_tcp_analysis(pinfo);
+            conversation_state = s7commp_get_conv_state(pinfo, tcpd);
             #ifdef DEBUG_REASSEMBLING
             printf(" ConvState->state=%d", conversation_state->state);
             #endif
+            frag_len = tvb_reported_length_remaining(tvb, offset);
+            if (!out_of_sync) {
+                retransmission = s7commp_is_retransmission(tvb, pinfo, tcpd, conversation_state, offset);
+            }
+            if (!retransmission && conversation_state->state != CONV_STATE_NEW
+                    && (out_of_sync || conversation_state->pdutype != pdutype)) {
+                /* The series doesn't line up, drop it */
+                s7commp_pending_remove(pinfo, conversation_state, TRUE);
+                s7commp_reassembly_stats.dropped++;
+                dropped = TRUE;
+            }
 
-            if (has_trailer) {
+            if (retransmission) {
+                /* The fragment was added already, keep the state */
+            } else if (out_of_sync) {
+                /* Not a PDU of this series, don't start a new one with it */
+            } else if (has_trailer) {
                 if (conversation_state->state == CONV_STATE_NEW) {
-                    no_fragment = TRUE;
+                    if (s7commp_is_data_start(tvb, offset)) {
+                        no_fragment = TRUE;
+                    } else {
+                        /* Last fragment of a series started before the capture */
+                        out_of_sync = TRUE;
+                    }
                     #ifdef DEBUG_REASSEMBLING
                     printf(" no_fragment=1");
                     #endif
@@ -4046,16 +4585,25 @@ dissect_s7commp(tvbuff_t *tvb,
                     /* rcksetzen */
                     #ifdef DEBUG_REASSEMBLING
                     col_append_fstr(pinfo->cinfo, COL_INFO, " (DEBUG: A state=%d)", conversation_state->state);
-                    printf(" last_fragment=1, delete_proto_data");
+                    printf(" last_fragment=1, reset state");
                     #endif
-                    conversation_state->state = CONV_STATE_NOFRAG;
-                    conversation_delete_proto_data(conversation, proto_s7commp);
+                    start_frame = conversation_state->start_frame;
+                    frag_number = conversation_state->next_fragment;
+                    s7commp_pending_remove(pinfo, conversation_state, FALSE);
+                    s7commp_reassembly_stats.completed++;
+                    conversation_state->state = CONV_STATE_NEW;
+                    conversation_state->start_frame = 0;
                 }
             } else {
-                if (conversation_state->state == CONV_STATE_NEW) {
+                if (conversation_state->state == CONV_STATE_NEW && !s7commp_is_data_start(tvb, offset)) {
+                    /* Inner fragment of a series started before the capture */
+                    out_of_sync = TRUE;
+                } else if (conversation_state->state == CONV_STATE_NEW) {
                     first_fragment = TRUE;
                     conversation_state->state = CONV_STATE_FIRST;
                     conversation_state->start_frame = pinfo->fd->num;
+                    conversation_state->pdutype = pdutype;
+                    conversation_state->next_fragment = 0;
                     #ifdef DEBUG_REASSEMBLING
                     printf(" first_fragment=1, set state=%d, start_frame=%d", conversation_state->state, conversation_state->start_frame);
                     #endif
@@ -4063,6 +4611,22 @@ dissect_s7commp(tvbuff_t *tvb,
                     inner_fragment = TRUE;
                     conversation_state->state = CONV_STATE_INNER;
                 }
+                if (first_fragment || inner_fragment) {
+                    start_frame = conversation_state->start_frame;
+                    frag_number = conversation_state->next_fragment++;
+                    s7commp_pending_add(pinfo, conversation_state, frag_len);
+                }
+            }
+            evicted = s7commp_pending_evict(pinfo, conversation_state);
+            if ((first_fragment || inner_fragment) && s7commp_reassembly_max_kbytes > 0
+                    && conversation_state->pending_bytes > (guint64)s7commp_reassembly_max_kbytes * 1024) {
+                /* The series alone is over the limit, drop it with this fragment */
+                s7commp_pending_remove(pinfo, conversation_state, TRUE);
+                s7commp_reassembly_stats.evicted++;
+                evicted++;
+                first_fragment = FALSE;
+                inner_fragment = FALSE;
+                out_of_sync = TRUE;
             }
             #ifdef DEBUG_REASSEMBLING
             printf(" => Conv->state=%d", conversation_state->state);
@@ -4072,48 +4636,74 @@ dissect_s7commp(tvbuff_t *tvb,
         }
 
         save_fragmented = pinfo->fragmented;
-        packet_state = (frame_state_t *)p_get_proto_data(wmem_file_scope(), pinfo, proto_s7commp, 0);
-        if (!packet_state) {
-            /* First S7COMMP in frame*/
-            packet_state = wmem_new(wmem_file_scope(), frame_state_t);
-            p_add_proto_data(wmem_file_scope(), pinfo, proto_s7commp, 0, packet_state);
-            packet_state->first_fragment = first_fragment;
-            packet_state->inner_fragment = inner_fragment;
-            packet_state->last_fragment = last_fragment;
-            packet_state->start_frame = conversation_state->start_frame;
+        packet_state = s7commp_get_frame_state(pinfo, pdu_index);
+        if (packet_state == NULL && !pinfo->fd->flags.visited) {
+            /* Unfragmented PDUs get a state only if one before in the frame has one */
+            if (first_fragment || inner_fragment || last_fragment || out_of_sync || retransmission || evicted > 0
+                    || dropped) {
+                packet_state = wmem_new(wmem_file_scope(), frame_state_t);
+                packet_state->flags = (first_fragment ? S7COMMP_FRAG_FIRST : 0)
+                    | (inner_fragment ? S7COMMP_FRAG_INNER : 0)
+                    | (last_fragment ? S7COMMP_FRAG_LAST : 0)
+                    | (out_of_sync ? S7COMMP_FRAG_OUT_OF_SYNC : 0)
+                    | (retransmission ? S7COMMP_FRAG_RETRANSMISSION : 0);
+                packet_state->start_frame = start_frame;
+                packet_state->frag_number = frag_number;
+                packet_state->evicted = (guint16)MIN(evicted, G_MAXUINT16);
+                packet_state->stats = (const s7commp_reassembly_stats_t *)wmem_memdup(wmem_file_scope(),
+                    &s7commp_reassembly_stats, sizeof(s7commp_reassembly_stats));
+                s7commp_set_frame_state(pinfo, pdu_index, packet_state);
+            } else if (pdu_index > 0 && s7commp_get_frame_state(pinfo, pdu_index - 1) != NULL) {
+                packet_state = wmem_new0(wmem_file_scope(), frame_state_t);
+                packet_state->flags = S7COMMP_FRAG_NONE;
+                s7commp_set_frame_state(pinfo, pdu_index, packet_state);
+            }
 #ifdef DEBUG_REASSEMBLING
             col_append_fstr(pinfo->cinfo, COL_INFO, " (DEBUG-REASM: INIT-packet_state)");
 #endif
-        } else {
-            first_fragment = packet_state->first_fragment;
-            inner_fragment = packet_state->inner_fragment;
-            last_fragment = packet_state->last_fragment;
+        } else if (packet_state != NULL) {
+            no_fragment = (packet_state->flags & S7COMMP_FRAG_NONE) != 0;
+            first_fragment = (packet_state->flags & S7COMMP_FRAG_FIRST) != 0;
+            inner_fragment = (packet_state->flags & S7COMMP_FRAG_INNER) != 0;
+            last_fragment = (packet_state->flags & S7COMMP_FRAG_LAST) != 0;
+            out_of_sync = (packet_state->flags & S7COMMP_FRAG_OUT_OF_SYNC) != 0;
+            retransmission = (packet_state->flags & S7COMMP_FRAG_RETRANSMISSION) != 0;
+            start_frame = packet_state->start_frame;
+            frag_number = packet_state->frag_number;
+            evicted = packet_state->evicted;
+        }
+        if (evicted > 0) {
+            expert_add_info_format(pinfo, s7commp_item, &ei_s7commp_reassembly_evicted,
+                "%u incomplete reassemblies dropped for the limits of the preferences", evicted);
+        }
+        /* The counters as they were after the frame on the first pass, also for tshark -2 and retaps */
+        if (packet_state != NULL && packet_state->stats != NULL && have_tap_listener(s7commp_reassembly_tap)) {
+            tap_queue_packet(s7commp_reassembly_tap, pinfo, packet_state->stats);
         }
 
         if (first_fragment || inner_fragment || last_fragment) {
             tvbuff_t* new_tvb = NULL;
             fragment_head *fd_head;
             guint32 frag_data_len;
-            /* guint32 frag_number; */
             gboolean more_frags;
 #ifdef DEBUG_REASSEMBLING
-            col_append_fstr(pinfo->cinfo, COL_INFO, " (DEBUG-REASM: F=%d I=%d L=%d N=%u)", first_fragment, inner_fragment, last_fragment, packet_state->start_frame);
+            col_append_fstr(pinfo->cinfo, COL_INFO, " (DEBUG-REASM: F=%d I=%d L=%d N=%u)", first_fragment, inner_fragment, last_fragment, start_frame);
 #endif
 
-            frag_id       = packet_state->start_frame;
+            frag_id       = start_frame;
             frag_data_len = tvb_reported_length_remaining(tvb, offset);     /* Dieses ist der reine Data-Teil, da offset hinter dem Header steht */
-            /* frag_number   = pinfo->fd->num; */
             more_frags    = !last_fragment;
 
             pinfo->fragmented = TRUE;
             /*
-             * fragment_add_seq_next() geht davon aus dass die Pakete in der richtigen Reihenfolge reinkommen.
              * Bei fragment_add_seq_check() muss eine Sequenznummer angegeben werden, die gibt es aber nicht im Protokoll.
+             * Es wird die im ersten Durchlauf gezhlte Position des Fragments in der Serie verwendet.
              */
-            fd_head = fragment_add_seq_next(&s7commp_reassembly_table,
+            fd_head = fragment_add_seq_check(&s7commp_reassembly_table,
                                              tvb, offset, pinfo,
                                              frag_id,               /* ID for fragments belonging together */
                                              NULL,                  /* void *data */
+                                             frag_number,           /* Position in the series */
                                              frag_data_len,         /* fragment length - to the end */
                                              more_frags);           /* More fragments? */
 
@@ -4124,6 +4714,7 @@ dissect_s7commp(tvbuff_t *tvb,
             if (new_tvb) { /* take it all */
                 next_tvb = new_tvb;
                 offset = 0;
+                reassembled = TRUE;
             } else { /* make a new subset */
                 next_tvb = tvb_new_subset(tvb, offset, -1, -1);
                 offset = 0;
@@ -4133,6 +4724,11 @@ dissect_s7commp(tvbuff_t *tvb,
         }
         pinfo->fragmented = save_fragmented;
         /******************************************************* END REASSEMBLING *******************************************************************/
+        /* Only complete PDUs: unfragmented, or the last fragment when the reassembly succeeded */
+        if (((last_fragment && reassembled) || !(first_fragment || inner_fragment || last_fragment || out_of_sync || retransmission))
+                && have_tap_listener(s7commp_audit_tap)) {
+            s7commp_queue_audit(next_tvb, pinfo, offset);
+        }
         if (tree) {
             /******************************************************
              * Data
@@ -4145,7 +4741,16 @@ dissect_s7commp(tvbuff_t *tvb,
             dlength = tvb_reported_length_remaining(next_tvb, offset) - 4;
             if (first_fragment || inner_fragment) {
                 col_append_fstr(pinfo->cinfo, COL_INFO, " (S7COMM-PLUS %s fragment)", first_fragment ? "first" : "inner" );
-                proto_tree_add_bytes(s7commp_data_tree, hf_s7commp_data_data, next_tvb, offset, dlength, tvb_get_ptr(next_tvb, offset, dlength));
+                proto_tree_add_item(s7commp_data_tree, hf_s7commp_data_data, next_tvb, offset, dlength, FALSE);
+                offset += dlength;
+            } else if (out_of_sync || retransmission) {
+                /* Without the start of the series the data can't be decoded */
+                col_append_str(pinfo->cinfo, COL_INFO, out_of_sync ? " (S7COMM-PLUS fragment, start of series not captured)"
+                    : " (S7COMM-PLUS retransmitted fragment)");
+                if (!has_trailer) {
+                    dlength += 4;
+                }
+                proto_tree_add_item(s7commp_data_tree, hf_s7commp_data_data, next_tvb, offset, dlength, FALSE);
                 offset += dlength;
             } else {
                 if (last_fragment) {
@@ -4172,6 +4777,84 @@ dissect_s7commp(tvbuff_t *tvb,
     return TRUE;
 }
 
+/*******************************************************************************************************
+ *
+ * -z "s7comm-plus,reassembly"
+ *   Prints the counters of the reassembly at the end: series completed, dropped because they didn't
+ *   line up, dropped for the limits of the preferences, and the incomplete series which are pending,
+ *   at the end and at most.
+ *
+ *******************************************************************************************************/
+G_MODULE_EXPORT void plugin_register_tap_listener(void);
+
+typedef struct {
+    s7commp_reassembly_stats_t last;
+    guint32 max_pending;
+    guint32 max_pending_bytes;
+} s7commp_reassembly_tap_t;
+
+static int
+s7commp_reassembly_packet(void *tapdata,
+                          packet_info *pinfo _U_,
+                          epan_dissect_t *edt _U_,
+                          const void *data)
+{
+    s7commp_reassembly_tap_t *rt = (s7commp_reassembly_tap_t *)tapdata;
+    const s7commp_reassembly_stats_t *stats = (const s7commp_reassembly_stats_t *)data;
+
+    rt->last = *stats;
+    if (stats->pending > rt->max_pending) {
+        rt->max_pending = stats->pending;
+    }
+    if (stats->pending_bytes > rt->max_pending_bytes) {
+        rt->max_pending_bytes = stats->pending_bytes;
+    }
+    return TRUE;
+}
+
+static void
+s7commp_reassembly_reset(void *tapdata)
+{
+    memset(tapdata, 0, sizeof(s7commp_reassembly_tap_t));
+}
+
+static void
+s7commp_reassembly_draw(void *tapdata)
+{
+    s7commp_reassembly_tap_t *rt = (s7commp_reassembly_tap_t *)tapdata;
+
+    printf("\n===================================================================\n");
+    printf("S7COMM-PLUS reassembly\n");
+    printf("Completed series:                      %u\n", rt->last.completed);
+    printf("Dropped series (not lining up):        %u\n", rt->last.dropped);
+    printf("Dropped series (limits):               %u\n", rt->last.evicted);
+    printf("Pending series at end:                 %u (%u bytes)\n", rt->last.pending, rt->last.pending_bytes);
+    printf("Pending series at most:                %u (%u bytes at most)\n", rt->max_pending, rt->max_pending_bytes);
+    printf("===================================================================\n");
+}
+
+static void
+s7commp_reassembly_init(const char *optarg _U_,
+                        void *userdata _U_)
+{
+    GString *error_string;
+
+    error_string = register_tap_listener("s7commp_reassembly", g_new0(s7commp_reassembly_tap_t, 1), NULL,
+        TL_REQUIRES_NOTHING, s7commp_reassembly_reset, s7commp_reassembly_packet, s7commp_reassembly_draw);
+    if (error_string) {
+        fprintf(stderr, "tshark: Couldn't register s7comm-plus,reassembly tap: %s\n", error_string->str);
+        g_string_free(error_string, TRUE);
+        exit(1);
+    }
+}
+
+/* Called by Wireshark when the plugin is loaded, registers the command line taps */
+G_MODULE_EXPORT void
+plugin_register_tap_listener(void)
+{
+    register_stat_cmd_arg("s7comm-plus,reassembly", s7commp_reassembly_init, NULL);
+}
+
 /*
  * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
  *